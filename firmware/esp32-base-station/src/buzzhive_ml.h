@@ -15,7 +15,7 @@ typedef enum {
     QUEEN_ACCEPTED = 3
 } QueenStatus;
 
-static const char* STATUS_NAMES[] = {"Queenright", "Queenless", "Queen_Hatched", "Queen_Accepted"};
+static const char* const STATUS_NAMES[] = {"Queenright", "Queenless", "Queen_Hatched", "Queen_Accepted"};
 
 // Scaler: mean values
 static const float MEAN[78] = {
@@ -28,6 +28,10 @@
 // Leave empty for local-only mode
 #define API_KEY ""
 
+// Root CA certificate (PEM) to verify API_ENDPOINT against; without it
+// the TLS connection is encrypted but the server is not verified
+// #define API_ROOT_CA "-----BEGIN CERTIFICATE-----\n...\n-----END CERTIFICATE-----\n"
+
 // ============================================================================
 // LoRa Configuration
 // ============================================================================
@@ -39,6 +43,83 @@
 #define LORA_SPREADING_FACTOR 10
 #define LORA_BANDWIDTH 125E3
 
+// Scan spreading factors LINK_SF_MIN..LINK_SF_MAX with channel activity
+// detection and advise each hive its own factor and TX power
+// (link_adaptation.h; sensors need USE_ADAPTIVE_LINK with the same range)
+// #define USE_ADAPTIVE_LINK
+#define LINK_SF_MIN 7
+#define LINK_SF_MAX 10
+
+// SNR kept above the demodulation floor when advising (dB)
+#define LINK_MARGIN_DB 5.0f
+
+// Answer each feature report with its classification and the hive's
+// schedule, in the receive window the sensor opens after it (downlink.h;
+// sensors need USE_DOWNLINK)
+// #define USE_DOWNLINK
+
+// Put a hive in alert mode (sensor's ALERT_MODE_INTERVAL_MS, no activity
+// gating) from this anomaly score (0-255), or when it looks queenless
+#define DOWNLINK_ALERT_ANOMALY 160
+
+// Wake interval sent to hives in seconds (60-21600); 0 = their own schedule
+#define DOWNLINK_WAKE_INTERVAL_S 0
+
+// Downlinks waiting for their send time at once
+#define DOWNLINK_SLOTS 4
+
+// Give each hive its own report slot and time the sensors through the
+// downlinks (slot_schedule.h), instead of letting reports collide at
+// random; needs USE_DOWNLINK, and USE_TDMA on the sensors
+// #define USE_TDMA
+
+// Slot cycle: the sensors' active report interval (their TDMA_CYCLE_MS).
+// Hives in alert mode or with a DOWNLINK_WAKE_INTERVAL_S under half a
+// cycle send their extra reports at random between slots.
+#define TDMA_CYCLE_MS (15 * 60 * 1000)
+
+// Slots are sized at boot (slotLengthMs) for TDMA_UPLINK_FRAMES frames of
+// TDMA_UPLINK_BYTES at the slowest spreading factor, then the downlink
+// and TDMA_GUARD_MS. Any frame (a full batch, USE_REPORT_BATCH) fits in
+// TRANSPORT_MAX_FRAME: 4.2 s slots at SF10, 213 per cycle. With feature
+// packets only, featurePacketSize(8) gives 2.8 s slots, 317 per cycle.
+#define TDMA_UPLINK_BYTES TRANSPORT_MAX_FRAME
+
+// Frames per report: with USE_ADAPTIVE_LINK, room for one resent fragment
+#ifdef USE_ADAPTIVE_LINK
+#define TDMA_UPLINK_FRAMES 2
+#else
+#define TDMA_UPLINK_FRAMES 1
+#endif
+
+// Guard for the sensors' clock error after drift correction (ms)
+#define TDMA_GUARD_MS 500
+
+// Reassembly of fragmented messages (lora_transport.h): messages in
+// flight at once (one per hive), and how long a partial one is kept
+#define TRANSPORT_RX_SLOTS 2
+#define TRANSPORT_TIMEOUT_MS 60000
+
+// ============================================================================
+// Receive Path
+// ============================================================================
+
+// Frames buffered between the radio task and the processing task
+// (~270 bytes each; 32 is ~10 s of back-to-back SF10 reports)
+#define RX_QUEUE_DEPTH 32
+
+// Reports waiting for the upload task (WiFi + HTTPS)
+#define UPLOAD_QUEUE_DEPTH 64
+
+// Reports go to API_ENDPOINT together, as one JSON array, once this many
+// are waiting or the oldest has waited UPLOAD_BATCH_MS (1 = post each)
+#define UPLOAD_BATCH_RECORDS 16
+#define UPLOAD_BATCH_MS 30000
+
+// Core for the upload task, beside the WiFi stack (the radio and
+// processing tasks share core 1 with the Arduino loop)
+#define UPLOAD_TASK_CORE 0
+
 // ============================================================================
 // Pin Definitions
 // ============================================================================
@@ -48,21 +129,65 @@
 #define LORA_RST_PIN 14
 #define LORA_DIO0_PIN 2
 
-// Status LED
-#define LED_PIN 2
+// Status LED (not GPIO 2: DIO0 drives the receive interrupt)
+#define LED_PIN 25
 
 // ============================================================================
 // Feature Flags
 // ============================================================================
 
-// Enable full XGBoost model from SPIFFS (requires model upload)
+// Use the trained XGBoost trees compiled into flash
+// (generate xgboost_model.h with tools/xgb_convert.cpp first)
+// #define USE_COMPILED_MODEL
+
+// Use the quantized model instead (scaler folded into 16-bit bins, 4-byte
+// nodes; generate xgboost_model_quant.h with xgb_convert --quantized)
+// #define USE_QUANTIZED_MODEL
+
+// Use the trees as generated code instead of node tables (generate
+// xgboost_model_code.h with xgb_convert --codegen; to run it from IRAM,
+// also define XGB_CODE_ATTR as IRAM_ATTR - only small ensembles fit)
+// #define USE_CODEGEN_MODEL
+
+// Map the full XGBoost model from the "model" flash partition
+// (requires partitions_model.csv and a model image upload, see model_store.h)
 // #define USE_FULL_MODEL
 
+// Score anomalies with the int8 VAE compiled into flash
+// (generate vae_model.h with tools/vae_convert.cpp first)
+// #define USE_VAE_MODEL
+
+// Split tree evaluation across both cores (worker task + loop task)
+// #define USE_DUAL_CORE_INFERENCE
+
+// Core for the tree worker task (the Arduino loop runs on core 1)
+#define INFERENCE_WORKER_CORE 0
+
+// Receive raw audio clips from the sensors (USE_AUDIO_CLIP_UPLINK),
+// upload them, and re-run MFCC extraction + inference on full-rate clips
+// (each reassembly slot then holds a whole clip)
+// #define USE_AUDIO_CLIPS
+
+// Largest clip accepted, in 256-sample ADPCM blocks (132 bytes each):
+// 128 = 4 s at 8 kHz, 345 = 4 s at 22050 Hz
+#define CLIP_MAX_BLOCKS 128
+
+// Print single-sample vs batch inference throughput at boot
+// #define RUN_INFERENCE_BENCHMARK
+
 // Enable MQTT instead of HTTP
 // #define USE_MQTT
 
 // Enable local web server for configuration
 // #define ENABLE_WEB_CONFIG
 
+// ============================================================================
+// Option Dependencies
+// ============================================================================
+
+#if defined(USE_TDMA) && !defined(USE_DOWNLINK)
+#error "USE_TDMA needs USE_DOWNLINK"
+#endif
+
 #endif // CONFIG_H
 
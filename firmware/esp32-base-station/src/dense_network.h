@@ -0,0 +1,131 @@
+/**
+ * Int8 Dense Network Runtime
+ *
+ * Fully connected layers with symmetric int8 weights and activations:
+ * - weights: one scale per output channel, row-major [output][input]
+ * - activations: one scale per layer input, calibrated on the host
+ * - bias: int32 in accumulator units (inputScale * weightScale)
+ * - multiply-accumulate in int32; each output is rescaled once with a
+ *   float multiply (the ESP32 has a single-precision FPU)
+ *
+ * Activations ping-pong between two int8 buffers in a caller-owned
+ * DenseArena (declare it static): no heap, no stack proportional to the
+ * layer width. The last layer is returned in float.
+ *
+ * Networks are produced by tools/vae_convert.cpp.
+ */
+
+#ifndef DENSE_NETWORK_H
+#define DENSE_NETWORK_H
+
+#include <stdint.h>
+
+// Widest layer (inputs or outputs) the arena holds
+#ifndef DENSE_MAX_WIDTH
+#define DENSE_MAX_WIDTH 512
+#endif
+
+enum DenseActivation {
+    DENSE_LINEAR = 0,
+    DENSE_RELU = 1
+};
+
+struct DenseLayer {
+    uint16_t inputs;
+    uint16_t outputs;
+    uint8_t activation;      // DenseActivation
+    float inputScale;        // Real value of one input step
+    const int8_t* weights;   // [outputs][inputs]
+    const int32_t* bias;     // [outputs], accumulator units
+    const float* outScale;   // [outputs], inputScale * weight scale
+};
+
+struct DenseNetwork {
+    uint32_t numLayers;
+    const DenseLayer* layers;
+};
+
+struct DenseArena {
+    int8_t a[DENSE_MAX_WIDTH];
+    int8_t b[DENSE_MAX_WIDTH];
+    float out[DENSE_MAX_WIDTH];   // Optional home for the float outputs
+};
+
+// Round to nearest and saturate to [-127, 127]
+inline int8_t quantizeInt8(float x) {
+    if (x >= 127.0f) return 127;
+    if (x <= -127.0f) return -127;
+    return (int8_t)(x >= 0.0f ? (int)(x + 0.5f) : (int)(x - 0.5f));
+}
+
+// int32 accumulator of one output channel
+inline int32_t denseDot(const DenseLayer& layer, int o, const int8_t* in) {
+    const int8_t* w = layer.weights + (uint32_t)o * layer.inputs;
+    int32_t acc = layer.bias[o];
+    for (int i = 0; i < layer.inputs; i++) {
+        acc += (int32_t)w[i] * in[i];
+    }
+    return acc;
+}
+
+/**
+ * Run one layer and requantize its outputs for the next one
+ *
+ * @param nextScale Input scale of the following layer
+ */
+inline void denseLayerInt8(const DenseLayer& layer, const int8_t* in, float nextScale, int8_t* out) {
+    float inv = 1.0f / nextScale;
+    for (int o = 0; o < layer.outputs; o++) {
+        float y = (float)denseDot(layer, o, in) * layer.outScale[o];
+        if (layer.activation == DENSE_RELU && y < 0.0f) y = 0.0f;
+        out[o] = quantizeInt8(y * inv);
+    }
+}
+
+// Run the last layer, outputs in float
+inline void denseLayerFloat(const DenseLayer& layer, const int8_t* in, float* out) {
+    for (int o = 0; o < layer.outputs; o++) {
+        float y = (float)denseDot(layer, o, in) * layer.outScale[o];
+        if (layer.activation == DENSE_RELU && y < 0.0f) y = 0.0f;
+        out[o] = y;
+    }
+}
+
+// True when every layer fits the arena and consumes the previous one's outputs
+inline bool denseNetworkFits(const DenseNetwork& net) {
+    if (net.numLayers == 0) return false;
+    for (uint32_t l = 0; l < net.numLayers; l++) {
+        const DenseLayer& layer = net.layers[l];
+        if (layer.inputs > DENSE_MAX_WIDTH || layer.outputs > DENSE_MAX_WIDTH) return false;
+        if (l > 0 && layer.inputs != net.layers[l - 1].outputs) return false;
+    }
+    return true;
+}
+
+/**
+ * Forward pass
+ *
+ * @param input layers[0].inputs floats
+ * @param output layers[numLayers - 1].outputs floats
+ * @param arena Scratch activations (not reentrant per arena)
+ */
+inline void denseForward(const DenseNetwork& net, const float* input, float* output, DenseArena* arena) {
+    const DenseLayer& first = net.layers[0];
+    float inv = 1.0f / first.inputScale;
+    for (int i = 0; i < first.inputs; i++) {
+        arena->a[i] = quantizeInt8(input[i] * inv);
+    }
+
+    int8_t* in = arena->a;
+    int8_t* out = arena->b;
+    uint32_t last = net.numLayers - 1;
+    for (uint32_t l = 0; l < last; l++) {
+        denseLayerInt8(net.layers[l], in, net.layers[l + 1].inputScale, out);
+        int8_t* t = in;
+        in = out;
+        out = t;
+    }
+    denseLayerFloat(net.layers[last], in, output);
+}
+
+#endif // DENSE_NETWORK_H
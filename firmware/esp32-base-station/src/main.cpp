@@ -15,11 +15,29 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <HTTPClient.h>
+#include <WiFiClientSecure.h>
 #include <LoRa.h>
+#include <SPI.h>
 #include <ArduinoJson.h>
 #include <PubSubClient.h>
 #include "config.h"
 #include "xgboost_inference.h"
+#include "vae_anomaly.h"
+#include "feature_packet.h"         // esp32-hive-sensor/src, see platformio.ini
+#include "lora_transport.h"         // esp32-hive-sensor/src, see platformio.ini
+#include "link_adaptation.h"        // esp32-hive-sensor/src, see platformio.ini
+#include "downlink.h"               // esp32-hive-sensor/src, see platformio.ini
+#include "report_batch.h"           // esp32-hive-sensor/src, see platformio.ini
+#include "slot_schedule.h"          // esp32-hive-sensor/src, see platformio.ini
+#include "lora_airtime.h"           // esp32-hive-sensor/src, see platformio.ini
+#ifdef USE_VAE_MODEL
+#include "vae_model.h"  // Generated by tools/vae_convert.cpp
+#endif
+#ifdef USE_AUDIO_CLIPS
+#include "audio_compression.h"    // esp32-hive-sensor/src, see platformio.ini
+#include "mfcc.h"                 // esp32-hive-sensor/src, see platformio.ini
+#include "audio_conditioning.h"
+#endif
 
 // ============================================================================
 // Configuration - CHANGE THESE FOR YOUR SETUP
@@ -38,8 +56,8 @@ const char* API_KEY = "YOUR_API_KEY";  // Get from buzzhive.io dashboard
 #define LORA_RST 14
 #define LORA_DIO0 2
 
-// Status LED
-#define LED_PIN 2
+// Status LED (not GPIO 2: DIO0 drives the receive interrupt)
+#define LED_PIN 25
 
 // ============================================================================
 // Data Structures
@@ -57,6 +75,16 @@ struct __attribute__((packed)) BuzzhivePacket {
     uint8_t featureHash[4];
 };
 
+// Liveness-only packet, sent when the sensor's activity gate finds the
+// hive silent or unchanged since its last full report
+struct __attribute__((packed)) BuzzhiveHeartbeat {
+    uint8_t hiveId;
+    uint8_t gateStatus;       // 2 = silent, 3 = unchanged
+    int16_t temperature;
+    uint8_t humidity;
+    uint16_t batteryMv;
+};
+
 // Extended packet with MFCC features (for ML inference)
 struct __attribute__((packed)) BuzzhivePacketFull {
     uint8_t hiveId;
@@ -72,8 +100,116 @@ struct __attribute__((packed)) BuzzhivePacketFull {
 
 WiFiClient wifiClient;
 HTTPClient http;
+WiFiClientSecure apiClient;   // Kept alive between posts (upload task only)
 bool wifiConnected = false;
 
+// Last feature-packet sequence number per hive, to report lost uplinks
+uint16_t lastSequence[256];
+bool sequenceSeen[256];
+
+// Last classification per hive, for batched readings without features
+uint8_t lastQueenStatus[256];
+uint8_t lastAnomalyScore[256];
+bool hiveClassified[256];
+
+#ifdef USE_AUDIO_CLIPS
+// Clips at the sensor's capture rate can be re-classified; others (e.g.
+// 8 kHz labeling clips) lack the band the MFCCs use and are only uploaded
+#define CLIP_ANALYSIS_RATE 22050
+
+#define TRANSPORT_MAX_MESSAGE (sizeof(AudioClipInfo) + CLIP_MAX_BLOCKS * ADPCM_BLOCK_BYTES)
+#else
+#define TRANSPORT_MAX_MESSAGE sizeof(BuzzhivePacketFull)
+#endif
+
+// Reassembly of fragmented messages (lora_transport.h)
+TransportReceiver<TRANSPORT_RX_SLOTS, TRANSPORT_MAX_MESSAGE> transport;
+
+// One received LoRa frame, copied out of the radio FIFO
+struct RxFrame {
+    uint32_t timestampMs;  // When DIO0 signalled RxDone
+    int16_t rssi;
+    float snr;
+    uint8_t sf;
+    uint8_t length;
+    uint8_t data[TRANSPORT_MAX_FRAME];
+};
+
+// One frame for the radio task to send (transport ACKs, downlinks)
+struct TxFrame {
+    uint32_t sendAtMs;     // millis() to send at; 0 = as soon as possible
+    uint8_t sf;            // The spreading factor of the frame it answers
+    uint8_t length;
+    uint8_t data[TRANSPORT_MAX_FRAME];
+};
+
+#define UPLOAD_REPORT 0
+#define UPLOAD_CLIP 1
+
+// One job for the upload task
+struct UploadItem {
+    uint8_t kind;
+    uint8_t hiveId;
+    uint8_t queenStatus;
+    uint8_t anomalyScore;
+    uint8_t humidity;
+    uint16_t batteryMv;
+    float temperature;
+    uint32_t timestampMs;  // millis() when the reading was taken
+};
+
+// Radio task -> processing task -> upload task
+QueueHandle_t rxQueue;
+QueueHandle_t txQueue;
+QueueHandle_t uploadQueue;
+TaskHandle_t radioTaskHandle = NULL;
+volatile uint32_t dio0TimeMs = 0;
+
+// Receive path counters, printed by loop()
+volatile uint32_t framesReceived = 0;
+volatile uint32_t rxQueueOverflows = 0;
+volatile uint32_t rxQueuePeak = 0;
+volatile uint32_t uploadQueueOverflows = 0;
+
+// Cloud upload counters, printed by loop()
+volatile uint32_t uploadPosts = 0;
+volatile uint32_t uploadFailures = 0;
+volatile uint32_t uploadSkipped = 0;         // Not posted: WiFi down
+volatile uint32_t uploadRecords = 0;         // Reports posted
+volatile uint32_t uploadConnections = 0;     // TLS handshakes
+volatile uint32_t uploadLatencyTotalMs = 0;
+volatile uint32_t uploadLatencyMaxMs = 0;
+volatile uint32_t uploadDropped = 0;         // Pushed out while posts failed
+
+#ifdef USE_AUDIO_CLIPS
+// Clip handed to the upload task; one at a time (see queueClipUpload)
+uint8_t clipUpload[TRANSPORT_MAX_MESSAGE];
+volatile bool clipUploadBusy = false;
+#endif
+
+// LED blinks requested by the processing task, played out by loop()
+volatile uint8_t ledBlinks = 0;
+
+#ifdef USE_ADAPTIVE_LINK
+// Per-hive SNR history behind the spreading factor / TX power advice
+LinkTracker linkTracker;
+#endif
+
+#ifdef USE_DOWNLINK
+// Downlinks the radio task holds until their send time
+TxFrame scheduledTx[DOWNLINK_SLOTS];
+bool scheduledTxUsed[DOWNLINK_SLOTS];
+volatile uint32_t downlinksSent = 0;
+volatile uint32_t downlinksMissed = 0;   // Too late for the window, or no free slot
+#endif
+
+#ifdef USE_TDMA
+// Report slots (slot_schedule.h), given out as hives are first heard; on
+// the millis() clock, so the grid jumps once at its wrap (49.7 days) and
+// the next downlinks re-time the hives
+SlotScheduler slotScheduler;
+#endif
+
 // Status names for display
 const char* QUEEN_STATUS_NAMES[] = {
     "Queenright",
@@ -119,25 +255,355 @@ void setupLoRa() {
     }
     
     // Match hive sensor settings
-    LoRa.setSpreadingFactor(10);
-    LoRa.setSignalBandwidth(125E3);
+    LoRa.setSpreadingFactor(LORA_SPREADING_FACTOR);
+    LoRa.setSignalBandwidth(LORA_BANDWIDTH);
     LoRa.setCodingRate4(5);
     
     Serial.println("✅ LoRa initialized - listening for hive sensors");
 }
 
 // ============================================================================
-// ML Inference
+// Receive Path
 // ============================================================================
 
-uint8_t runInference(const float* features) {
-    // Normalize features using stored scaler parameters
-    float normalizedFeatures[78];
-    normalizeFeatures(features, normalizedFeatures);
+// RxDone on DIO0: note the time and wake the radio task. The SPI reads
+// happen in the task, since the SPI driver cannot be used from an ISR.
+void IRAM_ATTR onLoRaDio0() {
+    dio0TimeMs = millis();
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(radioTaskHandle, &woken);
+    if (woken) portYIELD_FROM_ISR();
+}
+
+// SX1276 registers the LoRa library does not expose (CAD) or only
+// reaches through parsePacket(), which leaves continuous receive
+#define SX1276_REG_FIFO 0x00
+#define SX1276_REG_OP_MODE 0x01
+#define SX1276_REG_FIFO_ADDR_PTR 0x0D
+#define SX1276_REG_FIFO_RX_CURRENT_ADDR 0x10
+#define SX1276_REG_IRQ_FLAGS 0x12
+#define SX1276_REG_RX_NB_BYTES 0x13
+#define SX1276_REG_DIO_MAPPING_1 0x40
+#define SX1276_MODE_CAD 0x87          // LoRa mode | CAD
+#define SX1276_DIO0_CAD_DONE 0x80
+#define SX1276_IRQ_RX_DONE 0x40
+#define SX1276_IRQ_PAYLOAD_CRC_ERROR 0x20
+#define SX1276_IRQ_VALID_HEADER 0x10
+#define SX1276_IRQ_CAD_DONE 0x04
+#define SX1276_IRQ_CAD_DETECTED 0x01
+
+// Same SPI transaction as the LoRa library; only the radio task calls it
+uint8_t sx1276Transfer(uint8_t address, uint8_t value) {
+    SPI.beginTransaction(SPISettings(LORA_DEFAULT_SPI_FREQUENCY, MSBFIRST, SPI_MODE0));
+    digitalWrite(LORA_SS, LOW);
+    SPI.transfer(address);
+    uint8_t response = SPI.transfer(value);
+    digitalWrite(LORA_SS, HIGH);
+    SPI.endTransaction();
+    return response;
+}
+
+uint8_t sx1276Read(uint8_t reg) { return sx1276Transfer(reg & 0x7F, 0x00); }
+void sx1276Write(uint8_t reg, uint8_t value) { sx1276Transfer(reg | 0x80, value); }
+
+// Copy the frame behind RxDone into rxQueue without leaving receive mode,
+// as the library's own DIO0 handler does (parsePacket() drops the radio to
+// standby for the copy-out, deaf to a frame starting meanwhile). A full
+// queue drops the frame and counts an overflow rather than holding the
+// radio.
+void readFrame(uint8_t sf) {
+    uint8_t flags = sx1276Read(SX1276_REG_IRQ_FLAGS);
+    sx1276Write(SX1276_REG_IRQ_FLAGS, flags);  // Lowers DIO0
+    if (!(flags & SX1276_IRQ_RX_DONE) || (flags & SX1276_IRQ_PAYLOAD_CRC_ERROR)) return;
+    
+    RxFrame frame;
+    frame.timestampMs = dio0TimeMs;
+    frame.sf = sf;
+    frame.rssi = LoRa.packetRssi();
+    frame.snr = LoRa.packetSnr();
+    uint8_t size = sx1276Read(SX1276_REG_RX_NB_BYTES);
+    frame.length = size;
+    sx1276Write(SX1276_REG_FIFO_ADDR_PTR, sx1276Read(SX1276_REG_FIFO_RX_CURRENT_ADDR));
+    for (uint8_t i = 0; i < size; i++) frame.data[i] = sx1276Read(SX1276_REG_FIFO);
+    framesReceived++;
+    
+    if (xQueueSend(rxQueue, &frame, 0) != pdTRUE) {
+        rxQueueOverflows++;
+        return;
+    }
+    uint32_t depth = uxQueueMessagesWaiting(rxQueue);
+    if (depth > rxQueuePeak) rxQueuePeak = depth;
+}
+
+#ifdef USE_ADAPTIVE_LINK
+
+// Spreading factor plus the preamble sensors use with it
+void tuneLoRa(uint8_t sf) {
+    LoRa.idle();
+    LoRa.setSpreadingFactor(sf);
+    LoRa.setPreambleLength(linkPreambleSymbols(sf, LINK_SF_MIN, LINK_SF_MAX, LORA_BANDWIDTH));
+}
+
+// Wait for DIO0 to rise; wakes for queued ACKs are ignored
+bool waitDio0(uint32_t timeoutMs) {
+    uint32_t start = millis();
+    for (;;) {
+        if (digitalRead(LORA_DIO0) == HIGH) return true;
+        uint32_t elapsed = millis() - start;
+        if (elapsed >= timeoutMs) return false;
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMs - elapsed));
+    }
+}
+
+// One CAD at sf: true if a preamble is on the air
+bool channelActivity(uint8_t sf) {
+    tuneLoRa(sf);
+    sx1276Write(SX1276_REG_DIO_MAPPING_1, SX1276_DIO0_CAD_DONE);
+    sx1276Write(SX1276_REG_IRQ_FLAGS, 0xFF);
+    sx1276Write(SX1276_REG_OP_MODE, SX1276_MODE_CAD);
+    
+    waitDio0(LINK_CAD_SYMBOLS * linkSymbolUs(sf, LORA_BANDWIDTH) / 1000 + 2);
+    uint8_t flags = sx1276Read(SX1276_REG_IRQ_FLAGS);
+    sx1276Write(SX1276_REG_IRQ_FLAGS, 0xFF);
+    return (flags & SX1276_IRQ_CAD_DONE) && (flags & SX1276_IRQ_CAD_DETECTED);
+}
+
+// receiveAt()'s wait for a valid header: preamble, sync word and the 8
+// header symbols, plus slack
+uint32_t receiveHeaderMs(uint8_t sf) {
+    uint16_t preamble = linkPreambleSymbols(sf, LINK_SF_MIN, LINK_SF_MAX, LORA_BANDWIDTH);
+    return (preamble + 4 + 8 + 2) * linkSymbolUs(sf, LORA_BANDWIDTH) / 1000 + 2;
+}
+
+// ... and then for RxDone: the longest frame
+uint32_t receiveFrameMs(uint8_t sf) {
+    uint16_t preamble = linkPreambleSymbols(sf, LINK_SF_MIN, LINK_SF_MAX, LORA_BANDWIDTH);
+    return loraAirtimeUs(TRANSPORT_MAX_FRAME, sf, LORA_BANDWIDTH, 5, preamble) / 1000;
+}
+
+// After a CAD hit: receive at sf until RxDone, giving up early if no
+// valid header follows the preamble (a false detection)
+void receiveAt(uint8_t sf) {
+    LoRa.receive();
+    if (!waitDio0(receiveHeaderMs(sf))) {
+        if (!(sx1276Read(SX1276_REG_IRQ_FLAGS) & SX1276_IRQ_VALID_HEADER)) return;
+        if (!waitDio0(receiveFrameMs(sf))) return;
+    }
+    readFrame(sf);
+}
+
+#endif // USE_ADAPTIVE_LINK
+
+void transmitFrame(const TxFrame& tx) {
+#ifdef USE_ADAPTIVE_LINK
+    tuneLoRa(tx.sf);
+#endif
+    LoRa.beginPacket();
+    LoRa.write(tx.data, tx.length);
+    LoRa.endPacket();
+}
+
+#ifdef USE_DOWNLINK
+
+void scheduleFrame(const TxFrame& tx) {
+    for (int i = 0; i < DOWNLINK_SLOTS; i++) {
+        if (!scheduledTxUsed[i]) {
+            scheduledTx[i] = tx;
+            scheduledTxUsed[i] = true;
+            return;
+        }
+    }
+    downlinksMissed++;
+}
+
+// Send the downlinks that are due; one that is later than the sensor's
+// window margin would end after the window closes, so it is dropped
+bool sendScheduledFrames() {
+    bool sent = false;
+    for (int i = 0; i < DOWNLINK_SLOTS; i++) {
+        if (!scheduledTxUsed[i]) continue;
+        int32_t lateMs = (int32_t)(millis() - scheduledTx[i].sendAtMs);
+        if (lateMs < 0) continue;
+        scheduledTxUsed[i] = false;
+        if (lateMs > DOWNLINK_WINDOW_MARGIN_MS) {
+            downlinksMissed++;
+            continue;
+        }
+        transmitFrame(scheduledTx[i]);
+        downlinksSent++;
+        sent = true;
+    }
+    return sent;
+}
+
+// True if a downlink would miss its window while the radio is busy for
+// busyMs from now
+bool scheduledTxDueWithin(uint32_t busyMs) {
+    for (int i = 0; i < DOWNLINK_SLOTS; i++) {
+        if (!scheduledTxUsed[i]) continue;
+        int32_t ms = (int32_t)(scheduledTx[i].sendAtMs - millis());
+        if (ms + DOWNLINK_WINDOW_MARGIN_MS < (int32_t)busyMs) return true;
+    }
+    return false;
+}
+
+// Ticks until the next downlink is due
+TickType_t scheduledTxWait() {
+    TickType_t wait = portMAX_DELAY;
+    for (int i = 0; i < DOWNLINK_SLOTS; i++) {
+        if (!scheduledTxUsed[i]) continue;
+        int32_t ms = (int32_t)(scheduledTx[i].sendAtMs - millis());
+        if (ms <= 0) return 0;
+        TickType_t ticks = pdMS_TO_TICKS((uint32_t)ms);
+        if (ticks < wait) wait = ticks;
+    }
+    return wait;
+}
+
+#endif // USE_DOWNLINK
+
+// Send queued ACKs and due downlinks; returns true if any went out
+bool sendQueuedFrames() {
+    bool sent = false;
+    TxFrame tx;
+    while (xQueueReceive(txQueue, &tx, 0) == pdTRUE) {
+#ifdef USE_DOWNLINK
+        if (tx.sendAtMs != 0) {
+            scheduleFrame(tx);
+            continue;
+        }
+#endif
+        transmitFrame(tx);
+        sent = true;
+    }
+#ifdef USE_DOWNLINK
+    if (sendScheduledFrames()) sent = true;
+#endif
+    return sent;
+}
+
+#ifdef USE_ADAPTIVE_LINK
+
+/**
+ * Radio task: the only code that touches the SX1276
+ *
+ * Scans LINK_SF_MIN..LINK_SF_MAX with one CAD each and receives at the
+ * factor that finds a preamble; sensors send a preamble that spans a
+ * whole scan (link_adaptation.h). Queued ACKs and due downlinks go out
+ * between scans, at the factor of the frame they answer.
+ *
+ * A frame takes up to a few seconds to receive, longer than a downlink
+ * may be late (DOWNLINK_WINDOW_MARGIN_MS). If a downlink would fall due
+ * before the frame could end, the frame is not received: the sensor's
+ * window cannot move, while uplinks here are acknowledged transport
+ * messages that their sensor resends.
+ */
+void radioTask(void* param) {
+    attachInterrupt(digitalPinToInterrupt(LORA_DIO0), onLoRaDio0, RISING);
+    
+    for (;;) {
+        sendQueuedFrames();
+        for (uint8_t sf = LINK_SF_MIN; sf <= LINK_SF_MAX; sf++) {
+            if (channelActivity(sf)) {
+#ifdef USE_DOWNLINK
+                if (scheduledTxDueWithin(receiveHeaderMs(sf) + receiveFrameMs(sf))) break;
+#endif
+                receiveAt(sf);
+                break;
+            }
+        }
+    }
+}
+
+#else
+
+/**
+ * Radio task: the only code that touches the SX1276
+ *
+ * Keeps the radio in continuous receive, copying each frame out of the
+ * FIFO while it listens on, so processing and uploads never cost a
+ * packet. Queued ACKs are sent in between (the radio is deaf while
+ * sending).
+ */
+void radioTask(void* param) {
+    LoRa.receive();
+    attachInterrupt(digitalPinToInterrupt(LORA_DIO0), onLoRaDio0, RISING);
+    
+    for (;;) {
+#ifdef USE_DOWNLINK
+        ulTaskNotifyTake(pdTRUE, scheduledTxWait());
+#else
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+#endif
     
-    // Run XGBoost inference
+        // DIO0 stays high until readFrame() clears the IRQ flags, so
+        // poll the level: a frame landing mid-read is not missed
+        while (digitalRead(LORA_DIO0) == HIGH) {
+            readFrame(LORA_SPREADING_FACTOR);
+        }
+    
+        if (sendQueuedFrames()) LoRa.receive();
+    }
+}
+
+#endif // USE_ADAPTIVE_LINK
+
+// Send a frame from another task, via the radio task; sendAtMs = 0 sends
+// it right away
+void queueTransmit(const uint8_t* data, size_t length, uint8_t sf, uint32_t sendAtMs = 0) {
+    TxFrame tx;
+    tx.sendAtMs = sendAtMs;
+    tx.sf = sf;
+    tx.length = (uint8_t)length;
+    memcpy(tx.data, data, length);
+    if (xQueueSend(txQueue, &tx, 0) == pdTRUE) {
+        xTaskNotifyGive(radioTaskHandle);
+    }
+}
+
+// Hand a report to the upload task; never waits on the network.
+// timestampMs = 0 stamps it now.
+void queueUpload(uint8_t hiveId, uint8_t queenStatus, uint8_t anomalyScore,
+                 float temperature, uint8_t humidity, uint16_t batteryMv,
+                 uint32_t timestampMs = 0) {
+    UploadItem item;
+    item.kind = UPLOAD_REPORT;
+    item.hiveId = hiveId;
+    item.queenStatus = queenStatus;
+    item.anomalyScore = anomalyScore;
+    item.humidity = humidity;
+    item.batteryMv = batteryMv;
+    item.temperature = temperature;
+    item.timestampMs = timestampMs ? timestampMs : millis();
+    if (xQueueSend(uploadQueue, &item, 0) != pdTRUE) {
+        uploadQueueOverflows++;
+        Serial.printf("⚠️ Upload queue full, report from Hive %d dropped\n", hiveId);
+    }
+}
+
+void blinkLed(uint8_t count) {
+    ledBlinks = count;
+}
+
+// ============================================================================
+// ML Inference
+// ============================================================================
+
+/**
+ * Classify one report
+ * 
+ * @param normalized true for features already standardized (compact
+ *                   feature packets), false for raw MFCC statistics
+ */
+uint8_t runInference(const float* features, bool normalized = false) {
+    // Run XGBoost inference (normalizes with the stored scaler parameters,
+    // or uses the scaler folded into the quantized model)
     float scores[4];
-    xgboostPredict(normalizedFeatures, scores);
+    if (normalized) {
+        predictQueenStatusNormalized(features, scores);
+    } else {
+        predictQueenStatus(features, scores);
+    }
     
     // Find class with highest score
     uint8_t bestClass = 0;
@@ -155,58 +621,626 @@ uint8_t runInference(const float* features) {
     return bestClass;
 }
 
+#ifdef USE_VAE_MODEL
+static DenseArena vaeArena;  // Int8 activations, kept off the loop task's stack
+#endif
+
+uint8_t runAnomalyDetection(const float* features, bool normalized = false) {
+#ifdef USE_VAE_MODEL
+    float standardized[NUM_FEATURES];
+    if (!normalized) {
+        normalizeFeatures(features, standardized);
+        features = standardized;
+    }
+    uint8_t score = vaeAnomalyScore(VAE_MODEL, features, &vaeArena);
+    
+    Serial.printf("🔍 VAE anomaly score: %d\n", score);
+    return score;
+#else
+    (void)features;
+    (void)normalized;
+    return 0;  // No anomaly model built in
+#endif
+}
+
+#ifdef RUN_INFERENCE_BENCHMARK
+// Single-sample vs batch throughput of the active model on synthetic inputs
+void runInferenceBenchmark() {
+    const int count = 64;
+    static float raw[NUM_FEATURES * count];  // Feature-major
+    static float scores[count * NUM_CLASSES];
+    for (int f = 0; f < NUM_FEATURES; f++) {
+        for (int s = 0; s < count; s++) {
+            raw[f * count + s] = MEAN[f] + SCALE[f] * (random(-2000, 2000) / 1000.0f);
+        }
+    }
+    
+    unsigned long start = micros();
+    for (int s = 0; s < count; s++) {
+        float sample[NUM_FEATURES];
+        for (int f = 0; f < NUM_FEATURES; f++) sample[f] = raw[f * count + s];
+        predictQueenStatus(sample, &scores[s * NUM_CLASSES]);
+    }
+    unsigned long singleUs = micros() - start;
+    
+    start = micros();
+    predictQueenStatusBatch(raw, count, count, scores);
+    unsigned long batchUs = micros() - start;
+    
+    Serial.printf("⏱️ Inference (%d samples): single %.0f/s, batch %.0f/s\n",
+                  count, count * 1e6f / singleUs, count * 1e6f / batchUs);
+#ifdef USE_VAE_MODEL
+    start = micros();
+    for (int s = 0; s < count; s++) {
+        float sample[NUM_FEATURES];
+        for (int f = 0; f < NUM_FEATURES; f++) sample[f] = (raw[f * count + s] - MEAN[f]) / SCALE[f];
+        vaeAnomalyScore(VAE_MODEL, sample, &vaeArena);
+    }
+    Serial.printf("⏱️ VAE anomaly score: %.0f µs\n", (float)(micros() - start) / count);
+#endif
+#ifdef USE_DUAL_CORE_INFERENCE
+    Serial.printf("⏱️ Per-packet latency: %.0f µs (%s)\n", (float)singleUs / count,
+                  dualCore.running() ? "dual-core" : "single-core");
+#endif
+}
+#endif
+
 // ============================================================================
 // Cloud Upload
 // ============================================================================
 
-bool uploadToCloud(uint8_t hiveId, uint8_t queenStatus, uint8_t anomalyScore,
-                   float temperature, uint8_t humidity, uint16_t batteryMv) {
+// Reports waiting to be posted together (upload task only), oldest first
+UploadItem pendingReports[UPLOAD_BATCH_RECORDS];
+int pendingCount = 0;
+uint32_t pendingSinceMs = 0;     // Oldest report's arrival, or the failed post
+bool uploadRetrying = false;
+
+// One JSON array per post; status names are stored as pointers
+StaticJsonDocument<JSON_ARRAY_SIZE(UPLOAD_BATCH_RECORDS) + UPLOAD_BATCH_RECORDS * JSON_OBJECT_SIZE(8)> uploadDoc;
+
+void setupCloudClient() {
+#ifdef API_ROOT_CA
+    apiClient.setCACert(API_ROOT_CA);
+#else
+    apiClient.setInsecure();   // As HTTPClient does for an https URL without a CA
+#endif
+    http.setReuse(true);
+}
+
+// Start a request on the kept-alive connection; only a new connection
+// costs a TLS handshake
+void beginRequest(const String& url) {
+    if (!apiClient.connected()) {
+        uploadConnections++;
+    }
+    http.begin(apiClient, url);
+    http.addHeader("X-API-Key", API_KEY);
+}
+
+// end() leaves the connection open for the next request
+void endRequest(uint32_t startMs) {
+    http.end();
+    uint32_t latencyMs = millis() - startMs;
+    uploadPosts++;
+    uploadLatencyTotalMs += latencyMs;
+    if (latencyMs > uploadLatencyMaxMs) uploadLatencyMaxMs = latencyMs;
+}
+
+/**
+ * Post reports as one JSON array
+ */
+bool uploadReports(const UploadItem* items, int count) {
     if (!wifiConnected || WiFi.status() != WL_CONNECTED) {
+        uploadSkipped++;
         Serial.println("⚠️ WiFi not connected, skipping upload");
         return false;
     }
     
     // Build JSON payload
-    StaticJsonDocument<512> doc;
-    doc["hive_id"] = hiveId;
-    doc["queen_status"] = queenStatus;
-    doc["queen_status_name"] = QUEEN_STATUS_NAMES[queenStatus];
-    doc["anomaly_score"] = anomalyScore;
-    doc["temperature"] = temperature;
-    doc["humidity"] = humidity;
-    doc["battery_mv"] = batteryMv;
-    doc["timestamp"] = millis();
+    uploadDoc.clear();
+    JsonArray reports = uploadDoc.to<JsonArray>();
+    for (int i = 0; i < count; i++) {
+        const UploadItem& item = items[i];
+        JsonObject doc = reports.createNestedObject();
+        doc["hive_id"] = item.hiveId;
+        doc["queen_status"] = item.queenStatus;
+        doc["queen_status_name"] = QUEEN_STATUS_NAMES[item.queenStatus];
+        doc["anomaly_score"] = item.anomalyScore;
+        doc["temperature"] = item.temperature;
+        doc["humidity"] = item.humidity;
+        doc["battery_mv"] = item.batteryMv;
+        doc["timestamp"] = item.timestampMs;
+    }
     
     String payload;
-    serializeJson(doc, payload);
+    serializeJson(uploadDoc, payload);
     
     // Send to API
-    http.begin(API_ENDPOINT);
+    uint32_t start = millis();
+    beginRequest(API_ENDPOINT);
     http.addHeader("Content-Type", "application/json");
-    http.addHeader("X-API-Key", API_KEY);
-    
     int httpCode = http.POST(payload);
+    endRequest(start);
     
     if (httpCode == 200 || httpCode == 201) {
-        Serial.println("☁️ Uploaded to cloud successfully");
+        uploadRecords += count;
+        Serial.printf("☁️ Uploaded %d reports in %lu ms\n", count, millis() - start);
         return true;
+    }
+    uploadFailures++;
+    Serial.printf("❌ Upload failed: HTTP %d\n", httpCode);
+    return false;
+}
+
+// Keep a report for the next post; while posts fail, a full batch drops
+// its oldest report
+void addPendingReport(const UploadItem& item) {
+    if (pendingCount == UPLOAD_BATCH_RECORDS) {
+        memmove(pendingReports, pendingReports + 1, (UPLOAD_BATCH_RECORDS - 1) * sizeof(UploadItem));
+        pendingCount--;
+        uploadDropped++;
+    }
+    if (pendingCount == 0) {
+        pendingSinceMs = millis();
+    }
+    pendingReports[pendingCount++] = item;
+}
+
+// Post the pending reports once there are UPLOAD_BATCH_RECORDS of them or
+// the oldest has waited UPLOAD_BATCH_MS; a failed post waits that long
+void postPendingReports() {
+    if (pendingCount == 0) return;
+    bool due = millis() - pendingSinceMs >= UPLOAD_BATCH_MS;
+    if (!due && (pendingCount < UPLOAD_BATCH_RECORDS || uploadRetrying)) return;
+    
+    uploadRetrying = !uploadReports(pendingReports, pendingCount);
+    if (uploadRetrying) {
+        pendingSinceMs = millis();
     } else {
-        Serial.printf("❌ Upload failed: HTTP %d\n", httpCode);
+        pendingCount = 0;
+    }
+}
+
+#ifdef USE_AUDIO_CLIPS
+
+/**
+ * Upload a received clip as-is (ADPCM blocks, see audio_compression.h)
+ */
+bool uploadClip(uint8_t hiveId, const AudioClipInfo& info, const uint8_t* blocks) {
+    if (!wifiConnected || WiFi.status() != WL_CONNECTED) {
+        uploadSkipped++;
+        Serial.println("⚠️ WiFi not connected, skipping clip upload");
         return false;
     }
     
-    http.end();
+    uint32_t start = millis();
+    beginRequest(String(API_ENDPOINT) + "/clips");
+    http.addHeader("Content-Type", "application/octet-stream");
+    http.addHeader("X-Hive-Id", String(hiveId));
+    http.addHeader("X-Clip-Id", String(info.clipId));
+    http.addHeader("X-Sample-Rate", String(info.sampleRate));
+    http.addHeader("X-Audio-Codec", "ima-adpcm-256");
+    
+    int httpCode = http.POST((uint8_t*)blocks, (size_t)info.blockCount * ADPCM_BLOCK_BYTES);
+    endRequest(start);
+    
+    if (httpCode == 200 || httpCode == 201) {
+        Serial.println("☁️ Clip uploaded");
+        return true;
+    }
+    uploadFailures++;
+    Serial.printf("❌ Clip upload failed: HTTP %d\n", httpCode);
+    return false;
+}
+
+// Hand a clip message to the upload task. There is one clip buffer: a
+// clip that completes while the previous one is uploading is not uploaded.
+void queueClipUpload(const TransportMessage& message) {
+    if (clipUploadBusy) {
+        Serial.printf("⚠️ Clip upload busy, clip from Hive %d not uploaded\n", message.hiveId);
+        return;
+    }
+    memcpy(clipUpload, message.data, message.length);
+    clipUploadBusy = true;
+    
+    UploadItem item = {};
+    item.kind = UPLOAD_CLIP;
+    item.hiveId = message.hiveId;
+    if (xQueueSend(uploadQueue, &item, 0) != pdTRUE) {
+        clipUploadBusy = false;
+        uploadQueueOverflows++;
+        Serial.printf("⚠️ Upload queue full, clip from Hive %d not uploaded\n", message.hiveId);
+    }
 }
 
+#endif // USE_AUDIO_CLIPS
+
+/**
+ * Upload task: posts queued reports (batched) and clips and keeps WiFi
+ * connected, so a slow server or a reconnect only delays uploads
+ */
+void uploadTask(void* param) {
+    UploadItem item;
+    unsigned long lastWifiCheck = 0;
+    setupCloudClient();
+    
+    for (;;) {
+        if (xQueueReceive(uploadQueue, &item, pdMS_TO_TICKS(1000)) == pdTRUE) {
+#ifdef USE_AUDIO_CLIPS
+            if (item.kind == UPLOAD_CLIP) {
+                AudioClipInfo info;
+                memcpy(&info, clipUpload, sizeof(info));
+                uploadClip(item.hiveId, info, clipUpload + sizeof(info));
+                clipUploadBusy = false;
+            }
+#endif
+            if (item.kind == UPLOAD_REPORT) {
+                addPendingReport(item);
+            }
+        }
+        postPendingReports();
+    
+        // Reconnect WiFi if disconnected
+        if (millis() - lastWifiCheck > 30000) {  // Check every 30 seconds
+            lastWifiCheck = millis();
+            if (WiFi.status() != WL_CONNECTED) {
+                Serial.println("📶 Reconnecting WiFi...");
+                WiFi.reconnect();
+            }
+        }
+    }
+}
+
+// ============================================================================
+// Audio Clips
+// ============================================================================
+
+#ifdef USE_AUDIO_CLIPS
+
+/**
+ * Decode a clip block by block into the MFCC front end
+ * 
+ * Same conditioning and streaming extraction as the sensor, so a clip
+ * at the capture rate gives the features the sensor would have sent
+ * (up to ADPCM noise). Only one decoded block is held in RAM.
+ * 
+ * @param features Output, N_FEATURES raw MFCC statistics
+ */
+void extractClipFeatures(const AudioClipInfo& info, const uint8_t* blocks, float* features) {
+    static MfccStream mfccStream;
+    static AudioConditioner conditioner;
+    int16_t samples[ADPCM_BLOCK_SAMPLES];
+    
+    mfccStream.begin(info.sampleRate);
+    conditioner.begin();
+    for (uint16_t i = 0; i < info.blockCount; i++) {
+        if (!adpcmDecodeBlock(&blocks[i * ADPCM_BLOCK_BYTES], samples)) {
+            memset(samples, 0, sizeof(samples));
+        }
+        conditioner.process(samples, ADPCM_BLOCK_SAMPLES);
+        mfccStream.push(samples, ADPCM_BLOCK_SAMPLES);
+    }
+    mfccStream.finish(features, conditioner.gain());
+}
+
+// Queue a complete clip for upload, then classify it if it is at the
+// capture rate
+void handleAudioClip(const TransportMessage& message) {
+    AudioClipInfo info;
+    if (message.length < sizeof(info)) return;
+    memcpy(&info, message.data, sizeof(info));
+    const uint8_t* blocks = message.data + sizeof(info);
+    if (info.blockCount == 0 || info.sampleRate == 0 ||
+        message.length != sizeof(info) + (size_t)info.blockCount * ADPCM_BLOCK_BYTES) {
+        Serial.printf("⚠️ Bad clip from Hive %d: %d blocks in %d bytes\n",
+                      message.hiveId, info.blockCount, (int)message.length);
+        return;
+    }
+    
+    Serial.printf("\n🎵 Clip #%d from Hive %d: %d blocks at %d Hz (%.1f s)\n",
+                  info.clipId, message.hiveId, info.blockCount, info.sampleRate,
+                  (float)info.blockCount * ADPCM_BLOCK_SAMPLES / info.sampleRate);
+    
+    queueClipUpload(message);
+    
+    if (info.sampleRate == CLIP_ANALYSIS_RATE) {
+        unsigned long start = micros();
+        float features[N_FEATURES];
+        extractClipFeatures(info, blocks, features);
+        Serial.printf("   Re-extracted MFCCs in %lu ms\n", (micros() - start) / 1000);
+        runInference(features);
+        runAnomalyDetection(features);
+    }
+}
+
+#endif // USE_AUDIO_CLIPS
+
 // ============================================================================
 // LoRa Packet Processing
 // ============================================================================
 
-void processPacket(int packetSize) {
-    if (packetSize == sizeof(BuzzhivePacket)) {
+// Full packet with MFCC features (only fits the radio fragmented)
+void handleFullFeatures(const BuzzhivePacketFull& packet) {
+    Serial.printf("\n📥 Received MFCC data from Hive %d\n", packet.hiveId);
+    
+    // Run ML inference on base station
+    float features[NUM_FEATURES];
+    memcpy(features, packet.mfccFeatures, sizeof(features));
+    uint8_t queenStatus = runInference(features);
+    uint8_t anomalyScore = runAnomalyDetection(features);
+    
+    float temp = packet.temperature / 100.0;
+    
+    // Upload to cloud
+    queueUpload(packet.hiveId, queenStatus, anomalyScore,
+                temp, packet.humidity, packet.batteryMv);
+    
+    blinkLed(3);
+}
+
+#ifdef USE_DOWNLINK
+
+// Alert mode when the colony looks queenless or anomalous
+bool downlinkAlert(uint8_t queenStatus, uint8_t anomalyScore) {
+    return queenStatus == 1 || anomalyScore >= DOWNLINK_ALERT_ANOMALY;  // 1 = Queenless
+}
+
+#ifdef USE_TDMA
+// Preamble the sensors send at sf
+uint16_t sensorPreamble(uint8_t sf) {
+#ifdef USE_ADAPTIVE_LINK
+    return linkPreambleSymbols(sf, LINK_SF_MIN, LINK_SF_MAX, LORA_BANDWIDTH);
+#else
+    return 8;
+#endif
+}
+
+// When the frame's preamble started: RxDone less its time on air
+uint32_t frameStartMs(const RxFrame& rx) {
+    return rx.timestampMs - loraAirtimeUs(rx.length, rx.sf, LORA_BANDWIDTH, 5, sensorPreamble(rx.sf)) / 1000;
+}
+
+// Slot for the longest report at the slowest spreading factor in use
+uint32_t tdmaSlotMs() {
+#ifdef USE_ADAPTIVE_LINK
+    uint8_t sf = LINK_SF_MAX;
+#else
+    uint8_t sf = LORA_SPREADING_FACTOR;
+#endif
+    uint32_t uplinkMs = loraAirtimeUs(TDMA_UPLINK_BYTES, sf, LORA_BANDWIDTH, 5, sensorPreamble(sf)) / 1000;
+    uint32_t downlinkMs = loraAirtimeUs(sizeof(BuzzhiveDownlink), sf, LORA_BANDWIDTH, 5,
+                                        sensorPreamble(sf)) / 1000;
+    return slotLengthMs(uplinkMs, TDMA_UPLINK_FRAMES, downlinkMs, TDMA_GUARD_MS);
+}
+#endif
+
+static_assert(DOWNLINK_WAKE_INTERVAL_S == 0 || (DOWNLINK_WAKE_INTERVAL_S >= DOWNLINK_MIN_WAKE_S &&
+                                                DOWNLINK_WAKE_INTERVAL_S <= DOWNLINK_MAX_WAKE_S),
+              "DOWNLINK_WAKE_INTERVAL_S is outside what sensors accept (downlink.h)");
+
+/**
+ * Answer a report in the window its sensor opens DOWNLINK_DELAY_MS after
+ * the frame ended (downlink.h): classification and schedule
+ */
+void queueDownlink(const RxFrame& rx, uint8_t hiveId, uint16_t sequence,
+                   uint8_t queenStatus, uint8_t anomalyScore, bool alert) {
+    BuzzhiveDownlink downlink;
+    downlink.magic = DOWNLINK_MAGIC;
+    downlink.hiveId = hiveId;
+    downlink.sequence = sequence;
+    downlink.queenStatus = queenStatus;
+    downlink.anomalyScore = anomalyScore;
+    downlink.flags = alert ? DOWNLINK_ALERT : 0;
+    downlink.wakeIntervalS = DOWNLINK_WAKE_INTERVAL_S;
+    downlink.baseTimeMs = 0;
+    downlink.slotInMs = 0;
+    uint32_t sendAtMs = rx.timestampMs + DOWNLINK_DELAY_MS;
+#ifdef USE_TDMA
+    // Time reference: this downlink's start, and from there to the slot
+    int slot = slotScheduler.assign(hiveId);
+    if (slot >= 0) {
+        downlink.flags |= DOWNLINK_SLOT;
+        downlink.baseTimeMs = sendAtMs;
+        downlink.slotInMs = slotScheduler.nextStart(slot, sendAtMs) - sendAtMs;
+        Serial.printf("   🕐 Hive %d slot %d, report %ld ms off it\n", hiveId, slot,
+                      (long)slotScheduler.error(slot, frameStartMs(rx)));
+    }
+#endif
+    
+    downlinkSeal(downlink);
+    queueTransmit((uint8_t*)&downlink, sizeof(downlink), rx.sf, sendAtMs);
+    if (alert) {
+        Serial.printf("   🚨 Hive %d to alert mode\n", hiveId);
+    }
+}
+
+#endif // USE_DOWNLINK
+
+// Log reports lost between the last one seen from a hive and first
+void trackSequence(uint8_t hiveId, uint16_t first, uint16_t last) {
+    if (sequenceSeen[hiveId]) {
+        uint16_t missed = (uint16_t)(first - lastSequence[hiveId] - 1);
+        if (missed > 0 && missed < 0x8000) {
+            Serial.printf("   ⚠️ %u report(s) lost since #%u\n", missed, lastSequence[hiveId]);
+        }
+    }
+    lastSequence[hiveId] = last;
+    sequenceSeen[hiveId] = true;
+}
+
+// Quantized features (feature_packet.h), on their own or as a transport
+// message - decode and run inference here
+void handleFeaturePacket(const RxFrame& rx, const uint8_t* data, int size) {
+    BuzzhiveFeaturePacket packet;
+    if (size > (int)sizeof(packet)) return;
+    memcpy(&packet, data, size);
+    
+    float normalized[NUM_FEATURES];
+    if (!featurePacketValid(packet.header, size) ||
+        !decodeFeatures(packet.payload, packet.header.bits, normalized)) {
+        Serial.printf("⚠️ Bad feature packet: version %d, %d-bit, %d bytes\n",
+                      packet.header.version, packet.header.bits, size);
+        return;
+    }
+    
+    uint8_t hiveId = packet.header.hiveId;
+    Serial.printf("\n📥 Received features from Hive %d (#%u, %d-bit)\n",
+                  hiveId, packet.header.sequence, packet.header.bits);
+    trackSequence(hiveId, packet.header.sequence, packet.header.sequence);
+    
+    // Run ML inference on base station
+    uint8_t queenStatus = runInference(normalized, true);
+    uint8_t anomalyScore = runAnomalyDetection(normalized, true);
+    lastQueenStatus[hiveId] = queenStatus;
+    lastAnomalyScore[hiveId] = anomalyScore;
+    hiveClassified[hiveId] = true;
+#ifdef USE_DOWNLINK
+    queueDownlink(rx, hiveId, packet.header.sequence, queenStatus, anomalyScore,
+                  downlinkAlert(queenStatus, anomalyScore));
+#endif
+    
+    float temp = packet.header.temperature / 100.0;
+    
+    // Upload to cloud
+    queueUpload(hiveId, queenStatus, anomalyScore,
+                temp, packet.header.humidity, packet.header.batteryMv);
+    
+    blinkLed(3);
+}
+
+// Readings of the batch being handled (processing task only)
+BatchReading batchReadings[BATCH_MAX_READINGS];
+
+/**
+ * Batched readings (report_batch.h): one record each, stamped with when
+ * it was taken. Readings the activity gate left without features keep
+ * the hive's last classification.
+ */
+void handleBatch(const RxFrame& rx, const uint8_t* data, int size) {
+    BatchHeader header;
+    if (!batchDecode(data, size, header, batchReadings)) {
+        Serial.printf("⚠️ Bad batch from Hive %d (%d bytes)\n", data[1], size);
+        return;
+    }
+    
+    uint8_t hiveId = header.hiveId;
+    uint16_t newest = (uint16_t)(header.sequence + header.count - 1);
+    Serial.printf("\n📦 Received batch from Hive %d (#%u-#%u, %d-bit, %d bytes)\n",
+                  hiveId, header.sequence, newest, header.bits, size);
+    trackSequence(hiveId, header.sequence, newest);
+    
+#ifdef USE_DOWNLINK
+    bool alert = false;
+#endif
+    for (int r = 0; r < header.count; r++) {
+        const BatchReading& reading = batchReadings[r];
+        if (reading.flags & READING_FEATURES) {
+            float normalized[NUM_FEATURES];
+            for (int i = 0; i < NUM_FEATURES; i++) {
+                normalized[i] = dequantizeFeature(reading.codes[i], header.bits);
+            }
+            lastQueenStatus[hiveId] = runInference(normalized, true);
+            lastAnomalyScore[hiveId] = runAnomalyDetection(normalized, true);
+            hiveClassified[hiveId] = true;
+#ifdef USE_DOWNLINK
+            alert = alert || downlinkAlert(lastQueenStatus[hiveId], lastAnomalyScore[hiveId]);
+#endif
+        }
+        
+        float temp = reading.temperature / 100.0;
+        Serial.printf("   #%u, %lu s ago: %s, %.1f°C, %d mV\n", (uint16_t)(header.sequence + r),
+                      (unsigned long)reading.timeS,
+                      (reading.flags & READING_FEATURES) ? QUEEN_STATUS_NAMES[lastQueenStatus[hiveId]]
+                                                         : reading.status == 2 ? "silent" : "unchanged",
+                      temp, reading.batteryMv);
+        if (!hiveClassified[hiveId]) continue;   // Nothing to report it with yet
+        
+        queueUpload(hiveId, lastQueenStatus[hiveId], lastAnomalyScore[hiveId],
+                    temp, reading.humidity, reading.batteryMv, rx.timestampMs - reading.timeS * 1000);
+    }
+#ifdef USE_DOWNLINK
+    if (hiveClassified[hiveId]) {
+        queueDownlink(rx, hiveId, newest, lastQueenStatus[hiveId], lastAnomalyScore[hiveId], alert);
+    }
+#endif
+    
+    blinkLed(3);
+}
+
+/**
+ * Feed one fragment to reassembly (lora_transport.h)
+ * 
+ * The ACK goes out before a completed message is handled, so the sensor
+ * is not kept listening through inference and upload.
+ */
+void processTransportFrame(const RxFrame& rx, const TransportHeader& header) {
+    uint8_t advice = 0;
+#ifdef USE_ADAPTIVE_LINK
+    // Advise the sender from its link history, as heard on this frame
+    LinkSettings used;
+    if (linkDecode(header.link, used)) {
+        used.sf = rx.sf;
+        LinkSettings next = linkTracker.update(header.hiveId, used, rx.snr);
+        advice = linkEncode(next);
+        if ((header.kind & TRANSPORT_ACK_REQUEST) &&
+            (next.sf != used.sf || next.txPowerDbm != used.txPowerDbm)) {
+            Serial.printf("📶 Hive %d: SF%d/%d dBm -> SF%d/%d dBm (SNR %.1f dB)\n", header.hiveId,
+                          used.sf, used.txPowerDbm, next.sf, next.txPowerDbm, rx.snr);
+        }
+    }
+#endif
+    
+    uint8_t ack[TRANSPORT_MAX_FRAME];
+    size_t ackLength;
+    TransportMessage message;
+    TransportResult result = transport.receive(rx.data, rx.length, millis(), ack, ackLength,
+                                               message, advice);
+    
+    if (ackLength > 0) {
+        queueTransmit(ack, ackLength, rx.sf);
+    }
+    if (result == TRANSPORT_REJECTED) {
+        Serial.printf("⚠️ Fragment rejected (%d bytes): message too large or no free slot\n", rx.length);
+        return;
+    }
+    if (result != TRANSPORT_COMPLETE) return;
+    
+    if (message.type == TRANSPORT_MSG_FEATURES_FULL && message.length == sizeof(BuzzhivePacketFull)) {
+        BuzzhivePacketFull packet;
+        memcpy(&packet, message.data, sizeof(packet));
+        handleFullFeatures(packet);
+    } else if (message.type == TRANSPORT_MSG_FEATURES) {
+        handleFeaturePacket(rx, message.data, (int)message.length);
+    } else if (message.type == TRANSPORT_MSG_BATCH && batchValid(message.data, message.length)) {
+        handleBatch(rx, message.data, (int)message.length);
+#ifdef USE_AUDIO_CLIPS
+    } else if (message.type == TRANSPORT_MSG_AUDIO_CLIP) {
+        handleAudioClip(message);
+#endif
+    } else {
+        Serial.printf("⚠️ Unknown message type %d from Hive %d (%d bytes)\n",
+                      message.type, message.hiveId, (int)message.length);
+    }
+}
+
+// Fragments and batches are told apart from the fixed-size formats by
+// their header, not their size
+void processPacket(const RxFrame& rx) {
+    const uint8_t* frame = rx.data;
+    int packetSize = rx.length;
+    
+    TransportHeader header;
+    if (transportParse(frame, packetSize, header)) {
+        processTransportFrame(rx, header);
+        
+    } else if (batchValid(frame, packetSize)) {
+        // Several readings in one frame (report_batch.h)
+        handleBatch(rx, frame, packetSize);
+        
+    } else if (packetSize == sizeof(BuzzhivePacket)) {
         // Simple packet (already classified by hive sensor)
         BuzzhivePacket packet;
-        LoRa.readBytes((uint8_t*)&packet, sizeof(packet));
+        memcpy(&packet, frame, sizeof(packet));
         
         float temp = packet.temperature / 100.0;
         
@@ -216,47 +1250,76 @@ void processPacket(int packetSize) {
         Serial.printf("   Temperature: %.1f°C\n", temp);
         Serial.printf("   Humidity: %d%%\n", packet.humidity);
         Serial.printf("   Battery: %d mV\n", packet.batteryMv);
-        Serial.printf("   RSSI: %d dBm\n", LoRa.packetRssi());
+        Serial.printf("   RSSI: %d dBm, SNR: %.1f dB\n", rx.rssi, rx.snr);
         
         // Upload to cloud
-        uploadToCloud(packet.hiveId, packet.queenStatus, packet.anomalyScore,
-                      temp, packet.humidity, packet.batteryMv);
+        queueUpload(packet.hiveId, packet.queenStatus, packet.anomalyScore,
+                    temp, packet.humidity, packet.batteryMv);
         
         // Blink LED to indicate received packet
-        digitalWrite(LED_PIN, HIGH);
-        delay(100);
-        digitalWrite(LED_PIN, LOW);
-        
-    } else if (packetSize == sizeof(BuzzhivePacketFull)) {
-        // Full packet with MFCC features - run inference here
-        BuzzhivePacketFull packet;
-        LoRa.readBytes((uint8_t*)&packet, sizeof(packet));
+        blinkLed(1);
         
-        Serial.printf("\n📥 Received MFCC data from Hive %d\n", packet.hiveId);
+    } else if (packetSize == sizeof(BuzzhiveHeartbeat)) {
+        // Sensor skipped its report: nothing new since the last one
+        BuzzhiveHeartbeat packet;
+        memcpy(&packet, frame, sizeof(packet));
         
-        // Run ML inference on base station
-        uint8_t queenStatus = runInference(packet.mfccFeatures);
-        uint8_t anomalyScore = 0;  // TODO: Add VAE inference
+        Serial.printf("\n💓 Heartbeat from Hive %d (%s), %.1f°C, %d mV\n",
+                      packet.hiveId, packet.gateStatus == 2 ? "silent" : "unchanged",
+                      packet.temperature / 100.0, packet.batteryMv);
         
-        float temp = packet.temperature / 100.0;
-        
-        // Upload to cloud
-        uploadToCloud(packet.hiveId, queenStatus, anomalyScore,
-                      temp, packet.humidity, packet.batteryMv);
-        
-        // Blink LED
-        for (int i = 0; i < 3; i++) {
-            digitalWrite(LED_PIN, HIGH);
-            delay(50);
-            digitalWrite(LED_PIN, LOW);
-            delay(50);
-        }
+    } else if (packetSize >= (int)featurePacketSize(FEATURE_MIN_BITS) &&
+               packetSize <= (int)sizeof(BuzzhiveFeaturePacket)) {
+        // Quantized features (feature_packet.h) - decode and run inference here
+        handleFeaturePacket(rx, frame, packetSize);
         
     } else {
         Serial.printf("⚠️ Unknown packet size: %d bytes\n", packetSize);
     }
 }
 
+/**
+ * Processing task: reassembly, inference and anomaly scoring on queued
+ * frames; results go on to the upload task
+ */
+void processTask(void* param) {
+    RxFrame frame;
+    for (;;) {
+        if (xQueueReceive(rxQueue, &frame, pdMS_TO_TICKS(1000)) == pdTRUE) {
+            processPacket(frame);
+        }
+        
+        // Drop messages whose missing fragments never came
+        transport.expire(millis());
+    }
+}
+
+// Create the queues and tasks; the radio task starts receiving
+void startReceivePath() {
+    transport.begin(TRANSPORT_TIMEOUT_MS);
+#ifdef USE_ADAPTIVE_LINK
+    linkTracker.begin(LINK_SF_MIN, LINK_SF_MAX, LINK_MARGIN_DB);
+    Serial.printf("📶 Scanning SF%d-SF%d, %lu ms per scan\n", LINK_SF_MIN, LINK_SF_MAX,
+                  (unsigned long)(linkScanCycleUs(LINK_SF_MIN, LINK_SF_MAX, LORA_BANDWIDTH) / 1000));
+#endif
+    
+    rxQueue = xQueueCreate(RX_QUEUE_DEPTH, sizeof(RxFrame));
+    txQueue = xQueueCreate(4, sizeof(TxFrame));
+    uploadQueue = xQueueCreate(UPLOAD_QUEUE_DEPTH, sizeof(UploadItem));
+    if (!rxQueue || !txQueue || !uploadQueue) {
+        Serial.println("❌ Receive queues allocation failed!");
+        while (1);
+    }
+    
+    // Radio above processing above the Arduino loop on core 1
+    xTaskCreatePinnedToCore(uploadTask, "upload", 8192, NULL, 1, NULL, UPLOAD_TASK_CORE);
+    xTaskCreatePinnedToCore(processTask, "process", 8192, NULL, 2, NULL, 1);
+    xTaskCreatePinnedToCore(radioTask, "radio", 4096, NULL, 5, &radioTaskHandle, 1);
+    
+    Serial.printf("✅ Receive path: %d-frame RX queue, %d-report upload queue\n",
+                  RX_QUEUE_DEPTH, UPLOAD_QUEUE_DEPTH);
+}
+
 // ============================================================================
 // Main Setup & Loop
 // ============================================================================
@@ -273,27 +1336,70 @@ void setup() {
     setupWiFi();
     setupLoRa();
     
+#ifdef USE_FULL_MODEL
+    if (!loadXGBoostModel()) {
+        Serial.println("⚠️ Falling back to built-in model");
+    }
+#endif
+#ifdef USE_DUAL_CORE_INFERENCE
+    beginDualCoreInference();
+#endif
+    
+#ifdef RUN_INFERENCE_BENCHMARK
+    runInferenceBenchmark();
+#endif
+    
+#ifdef USE_TDMA
+    slotScheduler.begin(TDMA_CYCLE_MS, tdmaSlotMs());
+    Serial.printf("🕐 %d report slots of %lu ms\n", slotScheduler.slots(), (unsigned long)tdmaSlotMs());
+    if (slotScheduler.slots() < 256) {
+        Serial.println("⚠️ Fewer slots than hive IDs: hives beyond them report at random");
+    }
+#endif
+    
+    startReceivePath();
+    
     Serial.println("\n✅ Ready! Waiting for hive sensor data...\n");
 }
 
 void loop() {
-    // Check for incoming LoRa packets
-    int packetSize = LoRa.parsePacket();
-    if (packetSize > 0) {
-        processPacket(packetSize);
-    }
-    
-    // Reconnect WiFi if disconnected
-    static unsigned long lastWifiCheck = 0;
-    if (millis() - lastWifiCheck > 30000) {  // Check every 30 seconds
-        lastWifiCheck = millis();
-        if (WiFi.status() != WL_CONNECTED) {
-            Serial.println("📶 Reconnecting WiFi...");
-            WiFi.reconnect();
+    // Play out LED blinks: 50 ms on, 50 ms off
+    static unsigned long lastLedChange = 0;
+    static bool ledOn = false;
+    if (millis() - lastLedChange >= 50) {
+        if (ledOn) {
+            digitalWrite(LED_PIN, LOW);
+            ledOn = false;
+            lastLedChange = millis();
+        } else if (ledBlinks > 0) {
+            ledBlinks--;
+            digitalWrite(LED_PIN, HIGH);
+            ledOn = true;
+            lastLedChange = millis();
         }
     }
     
-    // Small delay to prevent tight loop
+    // Receive path health, once a minute
+    static unsigned long lastStats = 0;
+    if (millis() - lastStats > 60000) {
+        lastStats = millis();
+        Serial.printf("📻 %lu frames, RX queue peak %lu/%d, %lu overflows; %lu uploads dropped\n",
+                      (unsigned long)framesReceived, (unsigned long)rxQueuePeak, RX_QUEUE_DEPTH,
+                      (unsigned long)rxQueueOverflows, (unsigned long)uploadQueueOverflows);
+        Serial.printf("☁️ %lu posts (%lu failed, %lu skipped offline), %lu reports, %lu TLS handshakes, "
+                      "%lu ms avg / %lu ms max; %lu reports dropped\n",
+                      (unsigned long)uploadPosts, (unsigned long)uploadFailures, (unsigned long)uploadSkipped,
+                      (unsigned long)uploadRecords, (unsigned long)uploadConnections,
+                      (unsigned long)(uploadPosts ? uploadLatencyTotalMs / uploadPosts : 0),
+                      (unsigned long)uploadLatencyMaxMs, (unsigned long)uploadDropped);
+#ifdef USE_DOWNLINK
+        Serial.printf("📬 %lu downlinks sent, %lu missed their window\n",
+                      (unsigned long)downlinksSent, (unsigned long)downlinksMissed);
+#endif
+#ifdef USE_TDMA
+        Serial.printf("🕐 %d/%d slots assigned\n", slotScheduler.assigned(), slotScheduler.slots());
+#endif
+    }
+    
     delay(10);
 }
-
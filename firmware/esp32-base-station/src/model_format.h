@@ -0,0 +1,301 @@
+/**
+ * Binary Model Image Format
+ *
+ * The compiled tree ensemble as one flat, position-independent image that
+ * is flashed to its own data partition and used in place: parsing just
+ * checks the header and points a TreeEnsemble/QuantEnsemble into the
+ * mapped bytes. No heap, no copy, no JSON at boot.
+ *
+ * Layout (little-endian, every section 4-byte aligned):
+ *   ModelImageHeader
+ *   cascade                     Cascade (early-exit stages, may be empty)
+ *   treeRoots[numTrees]         uint32_t
+ *   treeClass[numTrees]         uint8_t, padded
+ *   nodes[nodeCount]            TreeNode or QuantTreeNode
+ *   leaves[leafCount]           float      (quantized only)
+ *   cutOffsets[numFeatures + 1] uint32_t   (quantized only)
+ *   cuts[cutCount]              float      (quantized only)
+ *
+ * The CRC-32 covers everything after the header. The writer is used by
+ * tools/xgb_convert.cpp; both sides compile on the host and the ESP32.
+ */
+
+#ifndef MODEL_FORMAT_H
+#define MODEL_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "tree_ensemble.h"
+
+#define MODEL_IMAGE_MAGIC 0x4C444D42    // "BMDL"
+#define MODEL_IMAGE_VERSION 2    // 2: cascade section
+
+enum ModelKind {
+    MODEL_KIND_FLOAT = 0,       // TreeEnsemble, normalized inputs
+    MODEL_KIND_QUANTIZED = 1    // QuantEnsemble, raw inputs
+};
+
+struct ModelImageHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint8_t kind;               // ModelKind
+    uint8_t reserved;
+    uint16_t numFeatures;
+    uint16_t numClasses;
+    uint32_t numTrees;
+    float baseScore;
+    uint32_t nodeCount;
+    uint32_t leafCount;         // Quantized only
+    uint32_t cutCount;          // Quantized only
+    uint32_t payloadBytes;      // Bytes after the header
+    uint32_t crc32;             // CRC-32 of the payload
+};
+
+enum ModelStatus {
+    MODEL_OK = 0,
+    MODEL_NOT_FOUND,
+    MODEL_TOO_SMALL,
+    MODEL_BAD_MAGIC,
+    MODEL_BAD_VERSION,
+    MODEL_BAD_LAYOUT,
+    MODEL_BAD_CRC
+};
+
+inline const char* modelStatusName(ModelStatus status) {
+    switch (status) {
+        case MODEL_OK: return "ok";
+        case MODEL_NOT_FOUND: return "not found";
+        case MODEL_TOO_SMALL: return "image truncated";
+        case MODEL_BAD_MAGIC: return "no model image";
+        case MODEL_BAD_VERSION: return "unsupported version";
+        case MODEL_BAD_LAYOUT: return "corrupt layout";
+        case MODEL_BAD_CRC: return "CRC mismatch";
+    }
+    return "unknown";
+}
+
+// A parsed image: pointers into the mapped bytes
+struct ModelImage {
+    uint8_t kind;
+    TreeEnsemble trees;         // Valid for MODEL_KIND_FLOAT
+    QuantEnsemble quant;        // Valid for MODEL_KIND_QUANTIZED
+    Cascade cascade;
+};
+
+// ============================================================================
+// CRC-32 (IEEE 802.3, nibble table)
+// ============================================================================
+
+inline uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t length) {
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc = table[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+        crc = table[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+    return ~crc;
+}
+
+// ============================================================================
+// Section Layout
+// ============================================================================
+
+inline uint32_t alignUp4(uint32_t n) { return (n + 3u) & ~3u; }
+
+struct ModelSections {
+    uint32_t cascade, roots, treeClass, nodes, leaves, cutOffsets, cuts, end;
+};
+
+inline ModelSections modelSections(const ModelImageHeader& h) {
+    ModelSections s;
+    uint32_t nodeSize = (h.kind == MODEL_KIND_QUANTIZED) ? sizeof(QuantTreeNode) : sizeof(TreeNode);
+    uint32_t cutOffsetCount = (h.kind == MODEL_KIND_QUANTIZED) ? h.numFeatures + 1u : 0u;
+    s.cascade = sizeof(ModelImageHeader);
+    s.roots = s.cascade + sizeof(Cascade);
+    s.treeClass = s.roots + h.numTrees * 4u;
+    s.nodes = s.treeClass + alignUp4(h.numTrees);
+    s.leaves = s.nodes + h.nodeCount * nodeSize;
+    s.cutOffsets = s.leaves + h.leafCount * 4u;
+    s.cuts = s.cutOffsets + cutOffsetCount * 4u;
+    s.end = s.cuts + h.cutCount * 4u;
+    return s;
+}
+
+// ============================================================================
+// Reader
+// ============================================================================
+
+// Stages end on whole rounds, in increasing order, before the last tree
+inline bool cascadeInBounds(const Cascade& cascade, uint32_t numTrees, uint32_t numClasses) {
+    if (cascade.numStages > CASCADE_MAX_STAGES) return false;
+    uint32_t prev = 0;
+    for (uint32_t i = 0; i < cascade.numStages; i++) {
+        uint32_t end = cascade.stages[i].endTree;
+        if (end <= prev || end >= numTrees || end % numClasses != 0) return false;
+        prev = end;
+    }
+    return true;
+}
+
+// Every root and child offset stays inside the node array
+inline bool treesInBounds(const uint32_t* roots, uint32_t numTrees, uint32_t nodeCount) {
+    for (uint32_t t = 0; t < numTrees; t++) {
+        if (roots[t] >= nodeCount) return false;
+    }
+    return true;
+}
+
+inline bool nodesInBounds(const TreeNode* nodes, uint32_t nodeCount, uint32_t numFeatures) {
+    for (uint32_t i = 0; i < nodeCount; i++) {
+        if (nodes[i].feature == TREE_LEAF) continue;
+        if (nodes[i].feature >= numFeatures) return false;
+        if (nodes[i].left == 0 || i + nodes[i].left + 1u >= nodeCount) return false;
+    }
+    return true;
+}
+
+inline bool nodesInBounds(const QuantTreeNode* nodes, uint32_t nodeCount, uint32_t numFeatures,
+                          uint32_t leafCount) {
+    for (uint32_t i = 0; i < nodeCount; i++) {
+        if (nodes[i].feature == QTREE_LEAF) {
+            if (nodes[i].bin >= leafCount) return false;
+            continue;
+        }
+        if (nodes[i].feature >= numFeatures) return false;
+        if (nodes[i].left == 0 || i + nodes[i].left + 1u >= nodeCount) return false;
+    }
+    return true;
+}
+
+/**
+ * Validate an image and point a ModelImage into it (no copy)
+ *
+ * @param data Image bytes, 4-byte aligned (e.g. a mapped partition)
+ * @param size Bytes available; may exceed the image (partition size)
+ */
+inline ModelStatus parseModelImage(const uint8_t* data, size_t size, ModelImage* out) {
+    if (size < sizeof(ModelImageHeader)) return MODEL_TOO_SMALL;
+    ModelImageHeader h;
+    memcpy(&h, data, sizeof(h));
+    if (h.magic != MODEL_IMAGE_MAGIC) return MODEL_BAD_MAGIC;
+    if (h.version != MODEL_IMAGE_VERSION) return MODEL_BAD_VERSION;
+    if (h.kind > MODEL_KIND_QUANTIZED || h.numClasses == 0 || h.numClasses > 255) return MODEL_BAD_LAYOUT;
+    if (h.numTrees > 0x00FFFFFF || h.nodeCount > 0x00FFFFFF || h.leafCount > 0xFFFF + 1u ||
+        h.cutCount > 0x00FFFFFF) return MODEL_BAD_LAYOUT;
+    if (h.kind == MODEL_KIND_QUANTIZED && h.numFeatures >= QTREE_LEAF) return MODEL_BAD_LAYOUT;
+
+    ModelSections s = modelSections(h);
+    if (h.payloadBytes != s.end - sizeof(ModelImageHeader)) return MODEL_BAD_LAYOUT;
+    if (size < s.end) return MODEL_TOO_SMALL;
+    if (crc32Update(0, data + sizeof(h), h.payloadBytes) != h.crc32) return MODEL_BAD_CRC;
+
+    Cascade cascade;
+    memcpy(&cascade, data + s.cascade, sizeof(cascade));
+    if (!cascadeInBounds(cascade, h.numTrees, h.numClasses)) return MODEL_BAD_LAYOUT;
+
+    const uint32_t* roots = (const uint32_t*)(data + s.roots);
+    const uint8_t* treeClass = data + s.treeClass;
+    if (!treesInBounds(roots, h.numTrees, h.nodeCount)) return MODEL_BAD_LAYOUT;
+    for (uint32_t t = 0; t < h.numTrees; t++) {
+        if (treeClass[t] >= h.numClasses) return MODEL_BAD_LAYOUT;
+    }
+
+    out->kind = h.kind;
+    out->cascade = cascade;
+    if (h.kind == MODEL_KIND_FLOAT) {
+        const TreeNode* nodes = (const TreeNode*)(data + s.nodes);
+        if (!nodesInBounds(nodes, h.nodeCount, h.numFeatures)) return MODEL_BAD_LAYOUT;
+        TreeEnsemble& m = out->trees;
+        m.numFeatures = h.numFeatures;
+        m.numClasses = h.numClasses;
+        m.numTrees = h.numTrees;
+        m.baseScore = h.baseScore;
+        m.treeRoots = roots;
+        m.treeClass = treeClass;
+        m.nodes = nodes;
+    } else {
+        const QuantTreeNode* nodes = (const QuantTreeNode*)(data + s.nodes);
+        if (!nodesInBounds(nodes, h.nodeCount, h.numFeatures, h.leafCount)) return MODEL_BAD_LAYOUT;
+        const uint32_t* cutOffsets = (const uint32_t*)(data + s.cutOffsets);
+        for (uint32_t f = 0; f < h.numFeatures; f++) {
+            if (cutOffsets[f] > cutOffsets[f + 1]) return MODEL_BAD_LAYOUT;
+        }
+        if (cutOffsets[0] != 0 || cutOffsets[h.numFeatures] != h.cutCount) return MODEL_BAD_LAYOUT;
+        QuantEnsemble& m = out->quant;
+        m.numFeatures = h.numFeatures;
+        m.numClasses = h.numClasses;
+        m.numTrees = h.numTrees;
+        m.baseScore = h.baseScore;
+        m.treeRoots = roots;
+        m.treeClass = treeClass;
+        m.nodes = nodes;
+        m.leaves = (const float*)(data + s.leaves);
+        m.cutOffsets = cutOffsets;
+        m.cuts = (const float*)(data + s.cuts);
+    }
+    return MODEL_OK;
+}
+
+// ============================================================================
+// Writer
+// ============================================================================
+
+inline ModelImageHeader modelImageHeader(const TreeEnsemble& m, uint32_t nodeCount) {
+    ModelImageHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = MODEL_IMAGE_MAGIC;
+    h.version = MODEL_IMAGE_VERSION;
+    h.kind = MODEL_KIND_FLOAT;
+    h.numFeatures = m.numFeatures;
+    h.numClasses = m.numClasses;
+    h.numTrees = m.numTrees;
+    h.baseScore = m.baseScore;
+    h.nodeCount = nodeCount;
+    h.payloadBytes = modelSections(h).end - sizeof(ModelImageHeader);
+    return h;
+}
+
+inline ModelImageHeader modelImageHeader(const QuantEnsemble& m, uint32_t nodeCount, uint32_t leafCount) {
+    ModelImageHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = MODEL_IMAGE_MAGIC;
+    h.version = MODEL_IMAGE_VERSION;
+    h.kind = MODEL_KIND_QUANTIZED;
+    h.numFeatures = m.numFeatures;
+    h.numClasses = m.numClasses;
+    h.numTrees = m.numTrees;
+    h.baseScore = m.baseScore;
+    h.nodeCount = nodeCount;
+    h.leafCount = leafCount;
+    h.cutCount = m.cutOffsets[m.numFeatures];
+    h.payloadBytes = modelSections(h).end - sizeof(ModelImageHeader);
+    return h;
+}
+
+/**
+ * Serialize a model into out (sizeof(ModelImageHeader) + header.payloadBytes
+ * bytes, from modelImageHeader())
+ */
+inline void writeModelImage(ModelImageHeader h, const Cascade& cascade, const uint32_t* roots,
+                            const uint8_t* treeClass, const void* nodes, const float* leaves,
+                            const uint32_t* cutOffsets, const float* cuts, uint8_t* out) {
+    ModelSections s = modelSections(h);
+    memset(out, 0, s.end);
+    memcpy(out + s.cascade, &cascade, sizeof(cascade));
+    memcpy(out + s.roots, roots, h.numTrees * 4u);
+    memcpy(out + s.treeClass, treeClass, h.numTrees);
+    memcpy(out + s.nodes, nodes, s.leaves - s.nodes);
+    if (h.kind == MODEL_KIND_QUANTIZED) {
+        memcpy(out + s.leaves, leaves, h.leafCount * 4u);
+        memcpy(out + s.cutOffsets, cutOffsets, (h.numFeatures + 1u) * 4u);
+        memcpy(out + s.cuts, cuts, h.cutCount * 4u);
+    }
+    h.crc32 = crc32Update(0, out + sizeof(h), h.payloadBytes);
+    memcpy(out, &h, sizeof(h));
+}
+
+#endif // MODEL_FORMAT_H
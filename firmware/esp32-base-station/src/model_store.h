@@ -0,0 +1,116 @@
+/**
+ * Memory-Mapped Model Storage
+ *
+ * Maps a binary model image (model_format.h) read-only into the address
+ * space so the ensemble runs directly out of it:
+ * - ESP32: the "model" data partition through esp_partition_mmap(), read
+ *   via the flash cache like code and const data
+ * - Host:  a plain mmap() of the image file
+ *
+ * Flash the image produced by tools/xgb_convert.cpp --binary with:
+ *   parttool.py write_partition --partition-name model --input xgboost_model.bin
+ * (partition table: partitions_model.csv)
+ */
+
+#ifndef MODEL_STORE_H
+#define MODEL_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "model_format.h"
+
+#ifdef ESP_PLATFORM
+#include <esp_idf_version.h>
+#include <esp_partition.h>
+#if ESP_IDF_VERSION_MAJOR >= 5
+typedef esp_partition_mmap_handle_t ModelMapHandle;
+#define MODEL_MMAP_DATA ESP_PARTITION_MMAP_DATA
+#define modelMunmap esp_partition_munmap
+#else
+// arduino-esp32 2.x (IDF 4.4)
+#include <esp_spi_flash.h>
+typedef spi_flash_mmap_handle_t ModelMapHandle;
+#define MODEL_MMAP_DATA SPI_FLASH_MMAP_DATA
+#define modelMunmap spi_flash_munmap
+#endif
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// Partition label in partitions_model.csv
+#define MODEL_PARTITION_LABEL "model"
+
+struct MappedModel {
+    const uint8_t* data;
+    size_t size;
+#ifdef ESP_PLATFORM
+    ModelMapHandle handle;
+#endif
+};
+
+/**
+ * Map a model image read-only
+ *
+ * @param name Partition label on the ESP32, file path on the host
+ * @return true if mapped; release with unmapModel()
+ */
+inline bool mapModel(const char* name, MappedModel* out) {
+    out->data = nullptr;
+    out->size = 0;
+#ifdef ESP_PLATFORM
+    const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_ANY, name);
+    if (!part) return false;
+    const void* ptr = nullptr;
+    if (esp_partition_mmap(part, 0, part->size, MODEL_MMAP_DATA, &ptr, &out->handle) != ESP_OK) {
+        return false;
+    }
+    out->data = (const uint8_t*)ptr;
+    out->size = part->size;
+    return true;
+#else
+    int fd = open(name, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void* ptr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) return false;
+    out->data = (const uint8_t*)ptr;
+    out->size = (size_t)st.st_size;
+    return true;
+#endif
+}
+
+inline void unmapModel(MappedModel* mapped) {
+    if (!mapped->data) return;
+#ifdef ESP_PLATFORM
+    modelMunmap(mapped->handle);
+#else
+    munmap((void*)mapped->data, mapped->size);
+#endif
+    mapped->data = nullptr;
+    mapped->size = 0;
+}
+
+/**
+ * Map and validate a model image in one step
+ *
+ * @param name Partition label or file path
+ * @param mapped Mapping to keep alive while the model is in use
+ * @param model Parsed model pointing into the mapping
+ */
+inline ModelStatus openModel(const char* name, MappedModel* mapped, ModelImage* model) {
+    if (!mapModel(name, mapped)) return MODEL_NOT_FOUND;
+    ModelStatus status = parseModelImage(mapped->data, mapped->size, model);
+    if (status != MODEL_OK) unmapModel(mapped);
+    return status;
+}
+
+#endif // MODEL_STORE_H
@@ -0,0 +1,287 @@
+/**
+ * Dual-Core Tree Ensemble Evaluation
+ *
+ * Splits each range of trees in two: a worker on the other core walks the
+ * first half straight into the margins while the calling task walks the
+ * second half into a local partial sum, which is added once the worker is
+ * done. Every tree still lands in its own class margin, so the result is
+ * the single-core one up to the rounding of that final add.
+ *
+ * Backends:
+ * - ESP32: a FreeRTOS task pinned to the given core, driven by task
+ *   notifications (the calling task waits on its own notification value,
+ *   so it must not use it for anything else)
+ * - Host:  a std::thread with a mutex / condition variable handshake
+ *
+ * Both cores read the model through the same flash cache on the ESP32,
+ * so misses are shared and the speedup stays below 2x.
+ */
+
+#ifndef PARALLEL_ENSEMBLE_H
+#define PARALLEL_ENSEMBLE_H
+
+#include <stdint.h>
+#include "tree_ensemble.h"
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+// Ranges shorter than this are not worth a handoff (tens of µs on FreeRTOS)
+#ifndef TREE_SPLIT_MIN_TREES
+#define TREE_SPLIT_MIN_TREES 32
+#endif
+
+// Largest class count the split path handles; wider models run single-core
+#define TREE_SPLIT_MAX_CLASSES 16
+
+// ============================================================================
+// Worker
+// ============================================================================
+
+/**
+ * Runs one posted job at a time on a second core
+ */
+class TreeWorker {
+public:
+    typedef void (*JobFn)(void* arg);
+
+    /**
+     * Start the worker
+     *
+     * @param core Core to pin the worker to (ignored on the host)
+     * @param stackBytes Worker task stack (ignored on the host)
+     * @param priority Worker task priority (ignored on the host)
+     */
+    bool begin(int core, uint32_t stackBytes = 4096, int priority = 2) {
+        if (started) return true;
+        stopping = false;
+#ifdef ESP_PLATFORM
+        caller = xTaskGetCurrentTaskHandle();
+        started = xTaskCreatePinnedToCore(taskEntry, "trees", stackBytes, this, priority,
+                                          &task, core) == pdPASS;
+#else
+        (void)core;
+        (void)stackBytes;
+        (void)priority;
+        pending = false;
+        done = false;
+        thread = std::thread(threadEntry, this);
+        started = true;
+#endif
+        return started;
+    }
+
+    // Stop and delete the worker; no job may be in flight
+    void end() {
+        if (!started) return;
+#ifdef ESP_PLATFORM
+        caller = xTaskGetCurrentTaskHandle();
+        stopping = true;
+        xTaskNotifyGive(task);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+#else
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        thread.join();
+#endif
+        started = false;
+    }
+
+    bool running() const { return started; }
+
+    // Start fn(arg) on the worker; pair every post() with a wait()
+    void post(JobFn fn, void* arg) {
+        job = fn;
+        jobArg = arg;
+#ifdef ESP_PLATFORM
+        caller = xTaskGetCurrentTaskHandle();
+        xTaskNotifyGive(task);
+#else
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending = true;
+            done = false;
+        }
+        wake.notify_one();
+#endif
+    }
+
+    // Block until the posted job has finished
+    void wait() {
+#ifdef ESP_PLATFORM
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+#else
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this] { return done; });
+#endif
+    }
+
+private:
+    JobFn job = nullptr;
+    void* jobArg = nullptr;
+    bool started = false;
+
+#ifdef ESP_PLATFORM
+    TaskHandle_t task = NULL;
+    TaskHandle_t caller = NULL;
+    volatile bool stopping = false;
+
+    static void taskEntry(void* param) {
+        TreeWorker* self = (TreeWorker*)param;
+        for (;;) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            if (self->stopping) break;
+            self->job(self->jobArg);
+            xTaskNotifyGive(self->caller);
+        }
+        xTaskNotifyGive(self->caller);
+        vTaskDelete(NULL);
+    }
+#else
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    bool pending = false;
+    bool done = false;
+    bool stopping = false;
+
+    static void threadEntry(TreeWorker* self) {
+        std::unique_lock<std::mutex> lock(self->mutex);
+        for (;;) {
+            self->wake.wait(lock, [self] { return self->pending || self->stopping; });
+            if (self->stopping) return;
+            self->pending = false;
+            lock.unlock();
+            self->job(self->jobArg);
+            lock.lock();
+            self->done = true;
+            self->finished.notify_one();
+        }
+    }
+#endif
+};
+
+// ============================================================================
+// Split Evaluation
+// ============================================================================
+
+/**
+ * Tree ensemble evaluated on two cores
+ *
+ * Until begin() succeeds (or for ranges under TREE_SPLIT_MIN_TREES) every
+ * call runs on the calling task alone. Not reentrant: one worker serves
+ * one caller at a time.
+ */
+class DualCoreEnsemble {
+public:
+    bool begin(int workerCore) { return worker.begin(workerCore); }
+    void end() { worker.end(); }
+    bool running() const { return worker.running(); }
+
+    // margins[c] += trees [firstTree, lastTree) of class c
+    void accumulate(const TreeEnsemble& model, const float* features,
+                    uint32_t firstTree, uint32_t lastTree, float* margins) {
+        split(&model, features, model.numClasses, firstTree, lastTree, margins, floatJob);
+    }
+
+    // margins[c] += trees [firstTree, lastTree) of class c, on binned features
+    void accumulate(const QuantEnsemble& model, const uint16_t* bins,
+                    uint32_t firstTree, uint32_t lastTree, float* margins) {
+        split(&model, bins, model.numClasses, firstTree, lastTree, margins, quantJob);
+    }
+
+    /**
+     * ensemblePredictCascade() on two cores
+     *
+     * @return Number of trees evaluated
+     */
+    uint32_t predictCascade(const TreeEnsemble& model, const Cascade& cascade,
+                            const float* features, float* probs) {
+        return runCascade(cascade, model.numTrees, model.numClasses, model.baseScore,
+                          [&](uint32_t first, uint32_t last, float* margins) {
+                              accumulate(model, features, first, last, margins);
+                          }, probs);
+    }
+
+    /**
+     * quantPredictCascade() on two cores
+     *
+     * @return Number of trees evaluated
+     */
+    uint32_t predictCascade(const QuantEnsemble& model, const Cascade& cascade,
+                            const float* raw, float* probs) {
+        uint16_t bins[256];
+        quantizeFeatures(model, raw, bins);
+        return runCascade(cascade, model.numTrees, model.numClasses, model.baseScore,
+                          [&](uint32_t first, uint32_t last, float* margins) {
+                              accumulate(model, bins, first, last, margins);
+                          }, probs);
+    }
+
+    // Full ensemble, no early exit
+    template <class Model>
+    void predict(const Model& model, const float* input, float* probs) {
+        Cascade none = {};
+        predictCascade(model, none, input, probs);
+    }
+
+private:
+    struct Job {
+        const void* model;
+        const void* input;
+        uint32_t firstTree;
+        uint32_t lastTree;
+        float* margins;
+    };
+
+    TreeWorker worker;
+    Job job;
+
+    static void floatJob(void* arg) {
+        Job* j = (Job*)arg;
+        ensembleAccumulate(*(const TreeEnsemble*)j->model, (const float*)j->input,
+                           j->firstTree, j->lastTree, j->margins);
+    }
+
+    static void quantJob(void* arg) {
+        Job* j = (Job*)arg;
+        quantAccumulate(*(const QuantEnsemble*)j->model, (const uint16_t*)j->input,
+                        j->firstTree, j->lastTree, j->margins);
+    }
+
+    void split(const void* model, const void* input, int numClasses,
+               uint32_t firstTree, uint32_t lastTree, float* margins, TreeWorker::JobFn fn) {
+        if (lastTree <= firstTree) return;
+        if (!worker.running() || lastTree - firstTree < TREE_SPLIT_MIN_TREES ||
+            numClasses > TREE_SPLIT_MAX_CLASSES) {
+            job = {model, input, firstTree, lastTree, margins};
+            fn(&job);
+            return;
+        }
+        uint32_t mid = firstTree + (lastTree - firstTree) / 2;
+
+        // Worker: first half, in place (same sums as single-core up to mid)
+        job = {model, input, firstTree, mid, margins};
+        worker.post(fn, &job);
+
+        // Caller: second half into a partial sum
+        float partial[TREE_SPLIT_MAX_CLASSES] = {};
+        Job local = {model, input, mid, lastTree, partial};
+        fn(&local);
+
+        worker.wait();
+        for (int c = 0; c < numClasses; c++) margins[c] += partial[c];
+    }
+};
+
+#endif // PARALLEL_ENSEMBLE_H
@@ -0,0 +1,407 @@
+/**
+ * Flat Tree-Ensemble Runtime for the XGBoost Queen Detector
+ *
+ * Evaluates the trained gradient-boosted trees from a compact flat node
+ * array produced offline by tools/xgb_convert.cpp:
+ * - Each node is 8 bytes: threshold (or leaf value), 16-bit feature index,
+ *   16-bit offset to the left child. The right child always follows the
+ *   left one, so one offset is enough.
+ * - Nodes are stored breadth-first per tree, keeping the top levels that
+ *   every sample visits next to each other in flash/cache.
+ *
+ * Splits follow XGBoost: go left when feature < threshold. Features are
+ * never missing here (MFCC statistics), so default directions are not
+ * stored.
+ *
+ * QuantEnsemble is the same model with the StandardScaler folded in:
+ * thresholds become raw-domain split points, each feature is turned into
+ * a 16-bit bin index once per sample, and nodes shrink to 4 bytes with
+ * integer compares. Predictions are identical to the float model.
+ *
+ * A Cascade turns either model into staged evaluation: run the first
+ * rounds, stop once the top two class margins are far enough apart, and
+ * only keep going for ambiguous samples. Stage thresholds are calibrated
+ * offline (xgb_convert --calibrate) and shipped with the model.
+ *
+ * The batch API scores many samples stored feature-major (SoA). Each tree
+ * is walked for a block of samples at once, one level per pass, so the
+ * tree stays in cache and the independent walks overlap in the pipeline.
+ *
+ * Portable C++ (no Arduino dependencies) so the host tools use the same code.
+ */
+
+#ifndef TREE_ENSEMBLE_H
+#define TREE_ENSEMBLE_H
+
+#include <stdint.h>
+#include <math.h>
+
+// Feature index marking a leaf node
+#define TREE_LEAF 0xFFFF
+
+struct TreeNode {
+    float value;        // Split threshold, or leaf value for leaves
+    uint16_t feature;   // Split feature index, TREE_LEAF for leaves
+    uint16_t left;      // Offset from this node to its left child
+};
+
+struct TreeEnsemble {
+    uint16_t numFeatures;
+    uint16_t numClasses;
+    uint32_t numTrees;
+    float baseScore;            // Initial margin for every class
+    const uint32_t* treeRoots;  // Index of each tree's root in nodes
+    const uint8_t* treeClass;   // Output class each tree adds to
+    const TreeNode* nodes;
+};
+
+// Walk one tree to its leaf value
+inline float evalTree(const TreeNode* node, const float* features) {
+    while (node->feature != TREE_LEAF) {
+        node += node->left + (features[node->feature] < node->value ? 0 : 1);
+    }
+    return node->value;
+}
+
+/**
+ * Add the leaf values of trees [firstTree, lastTree) to per-class margins
+ *
+ * @param margins numClasses accumulators, not cleared here
+ */
+inline void ensembleAccumulate(const TreeEnsemble& model, const float* features,
+                               uint32_t firstTree, uint32_t lastTree, float* margins) {
+    for (uint32_t t = firstTree; t < lastTree; t++) {
+        margins[model.treeClass[t]] += evalTree(&model.nodes[model.treeRoots[t]], features);
+    }
+}
+
+// In-place softmax over n values
+inline void softmax(float* values, int n) {
+    float maxV = values[0];
+    for (int i = 1; i < n; i++) {
+        if (values[i] > maxV) maxV = values[i];
+    }
+    float sum = 0.0f;
+    for (int i = 0; i < n; i++) {
+        values[i] = expf(values[i] - maxV);
+        sum += values[i];
+    }
+    for (int i = 0; i < n; i++) values[i] /= sum;
+}
+
+/**
+ * Class probabilities for one normalized feature vector (multi:softprob)
+ *
+ * @param features numFeatures normalized features
+ * @param probs Output array of numClasses probabilities
+ */
+inline void ensemblePredict(const TreeEnsemble& model, const float* features, float* probs) {
+    for (int c = 0; c < model.numClasses; c++) probs[c] = model.baseScore;
+    ensembleAccumulate(model, features, 0, model.numTrees, probs);
+    softmax(probs, model.numClasses);
+}
+
+// ============================================================================
+// Quantized Ensemble
+// ============================================================================
+
+// Feature index marking a quantized leaf node
+#define QTREE_LEAF 0xFF
+
+struct QuantTreeNode {
+    uint8_t feature;    // Split feature index, QTREE_LEAF for leaves
+    uint8_t left;       // Offset from this node to its left child
+    uint16_t bin;       // Go left when bin(feature) <= this; leaf value index for leaves
+};
+
+struct QuantEnsemble {
+    uint16_t numFeatures;
+    uint16_t numClasses;
+    uint32_t numTrees;
+    float baseScore;
+    const uint32_t* treeRoots;
+    const uint8_t* treeClass;
+    const QuantTreeNode* nodes;
+    const float* leaves;
+    const uint32_t* cutOffsets; // numFeatures + 1 offsets into cuts
+    const float* cuts;          // Raw-domain split points, ascending per feature
+};
+
+/**
+ * Bin index of each raw (unnormalized) feature: the number of that
+ * feature's split points <= the value
+ *
+ * @param raw numFeatures raw features
+ * @param bins Output array of numFeatures bin indices
+ */
+inline void quantizeFeatures(const QuantEnsemble& model, const float* raw, uint16_t* bins) {
+    for (int f = 0; f < model.numFeatures; f++) {
+        const float* cuts = model.cuts + model.cutOffsets[f];
+        uint32_t n = model.cutOffsets[f + 1] - model.cutOffsets[f];
+        if (n == 0) {
+            bins[f] = 0;
+            continue;
+        }
+        // Branchless upper bound: the select compiles to a conditional move
+        const float* base = cuts;
+        while (n > 1) {
+            uint32_t half = n >> 1;
+            base = (base[half] <= raw[f]) ? base + half : base;
+            n -= half;
+        }
+        bins[f] = (uint16_t)((base - cuts) + (*base <= raw[f] ? 1 : 0));
+    }
+}
+
+inline float evalQuantTree(const QuantTreeNode* node, const uint16_t* bins, const float* leaves) {
+    while (node->feature != QTREE_LEAF) {
+        node += node->left + (bins[node->feature] <= node->bin ? 0 : 1);
+    }
+    return leaves[node->bin];
+}
+
+inline void quantAccumulate(const QuantEnsemble& model, const uint16_t* bins,
+                            uint32_t firstTree, uint32_t lastTree, float* margins) {
+    for (uint32_t t = firstTree; t < lastTree; t++) {
+        margins[model.treeClass[t]] += evalQuantTree(&model.nodes[model.treeRoots[t]], bins, model.leaves);
+    }
+}
+
+/**
+ * Class probabilities from raw features (no normalization step needed)
+ *
+ * @param raw numFeatures raw features, as received from the sensor
+ * @param probs Output array of numClasses probabilities
+ */
+inline void quantPredict(const QuantEnsemble& model, const float* raw, float* probs) {
+    uint16_t bins[256];
+    quantizeFeatures(model, raw, bins);
+    for (int c = 0; c < model.numClasses; c++) probs[c] = model.baseScore;
+    quantAccumulate(model, bins, 0, model.numTrees, probs);
+    softmax(probs, model.numClasses);
+}
+
+// ============================================================================
+// Cascade (Early Exit)
+// ============================================================================
+
+#define CASCADE_MAX_STAGES 4
+
+struct CascadeStage {
+    uint32_t endTree;   // Trees evaluated by the end of this stage (whole rounds)
+    float minGap;       // Exit when top1 - top2 margin >= this
+};
+
+struct Cascade {
+    uint32_t numStages; // 0 = always run the full ensemble
+    CascadeStage stages[CASCADE_MAX_STAGES];
+};
+
+// Margin difference between the two leading classes
+inline float marginGap(const float* margins, int n) {
+    float first = -INFINITY;
+    float second = -INFINITY;
+    for (int i = 0; i < n; i++) {
+        if (margins[i] > first) {
+            second = first;
+            first = margins[i];
+        } else if (margins[i] > second) {
+            second = margins[i];
+        }
+    }
+    return first - second;
+}
+
+/**
+ * Staged evaluation shared by every backend
+ *
+ * @param accumulate Called as accumulate(firstTree, lastTree, margins)
+ * @return Number of trees evaluated
+ */
+template <class Accumulate>
+inline uint32_t runCascade(const Cascade& cascade, uint32_t numTrees, int numClasses, float baseScore,
+                           Accumulate accumulate, float* probs) {
+    for (int c = 0; c < numClasses; c++) probs[c] = baseScore;
+    uint32_t done = 0;
+    for (uint32_t s = 0; s < cascade.numStages; s++) {
+        accumulate(done, cascade.stages[s].endTree, probs);
+        done = cascade.stages[s].endTree;
+        if (marginGap(probs, numClasses) >= cascade.stages[s].minGap) {
+            softmax(probs, numClasses);
+            return done;
+        }
+    }
+    accumulate(done, numTrees, probs);
+    softmax(probs, numClasses);
+    return numTrees;
+}
+
+/**
+ * ensemblePredict() with early exit
+ *
+ * @return Number of trees evaluated
+ */
+inline uint32_t ensemblePredictCascade(const TreeEnsemble& model, const Cascade& cascade,
+                                       const float* features, float* probs) {
+    return runCascade(cascade, model.numTrees, model.numClasses, model.baseScore,
+                      [&](uint32_t first, uint32_t last, float* margins) {
+                          ensembleAccumulate(model, features, first, last, margins);
+                      }, probs);
+}
+
+/**
+ * quantPredict() with early exit
+ *
+ * @return Number of trees evaluated
+ */
+inline uint32_t quantPredictCascade(const QuantEnsemble& model, const Cascade& cascade,
+                                    const float* raw, float* probs) {
+    uint16_t bins[256];
+    quantizeFeatures(model, raw, bins);
+    return runCascade(cascade, model.numTrees, model.numClasses, model.baseScore,
+                      [&](uint32_t first, uint32_t last, float* margins) {
+                          quantAccumulate(model, bins, first, last, margins);
+                      }, probs);
+}
+
+// ============================================================================
+// Batch Inference (feature-major samples)
+// ============================================================================
+
+// Samples walked together per tree
+#ifndef TREE_BATCH_BLOCK
+#define TREE_BATCH_BLOCK 8
+#endif
+
+// Widest model whose block is staged on the stack (78 features in use);
+// wider models fall back to one sample at a time
+#define TREE_BATCH_MAX_FEATURES 96
+
+/**
+ * Walk one tree for a block of samples, level by level, and add each
+ * sample's leaf to its margins
+ *
+ * @param features Feature-major: feature f of sample s at features[f * stride + s]
+ */
+inline void evalTreeBlock(const TreeNode* root, const float* features, size_t stride,
+                          int count, int cls, int numClasses, float* margins) {
+    const TreeNode* node[TREE_BATCH_BLOCK];
+    for (int s = 0; s < count; s++) node[s] = root;
+    // Branch-free passes: leaves have a zero child offset, so masking the
+    // compare makes them stay put until every sample has reached one
+    uint32_t active = 1;
+    while (active) {
+        active = 0;
+        for (int s = 0; s < count; s++) {
+            const TreeNode* n = node[s];
+            uint32_t split = n->feature != TREE_LEAF;
+            uint32_t f = split ? n->feature : 0;
+            uint32_t right = features[f * stride + s] < n->value ? 0 : 1;
+            node[s] = n + n->left + (right & split);
+            active |= split;
+        }
+    }
+    for (int s = 0; s < count; s++) margins[s * numClasses + cls] += node[s]->value;
+}
+
+/**
+ * ensemblePredict() for many samples
+ *
+ * @param features Normalized, feature-major: features[f * stride + s]
+ * @param stride Distance between features of one sample (>= count)
+ * @param count Number of samples
+ * @param probs Output, sample-major: probs[s * numClasses + c]
+ */
+inline void ensemblePredictBatch(const TreeEnsemble& model, const float* features, size_t stride,
+                                 size_t count, float* probs) {
+    // Each block is copied into a compact buffer so the walks touch a few
+    // cache lines instead of one per feature row of the caller's array.
+    // Wider models walk the caller's array in place.
+    float block[TREE_BATCH_MAX_FEATURES * TREE_BATCH_BLOCK];
+    bool staged = model.numFeatures <= TREE_BATCH_MAX_FEATURES;
+    for (size_t first = 0; first < count; first += TREE_BATCH_BLOCK) {
+        int n = (int)(count - first < TREE_BATCH_BLOCK ? count - first : TREE_BATCH_BLOCK);
+        float* margins = probs + first * model.numClasses;
+        for (int i = 0; i < n * model.numClasses; i++) margins[i] = model.baseScore;
+
+        if (staged) {
+            for (int f = 0; f < model.numFeatures; f++) {
+                for (int s = 0; s < n; s++) block[f * TREE_BATCH_BLOCK + s] = features[f * stride + first + s];
+            }
+            for (uint32_t t = 0; t < model.numTrees; t++) {
+                evalTreeBlock(&model.nodes[model.treeRoots[t]], block, TREE_BATCH_BLOCK, n,
+                              model.treeClass[t], model.numClasses, margins);
+            }
+        } else {
+            for (uint32_t t = 0; t < model.numTrees; t++) {
+                evalTreeBlock(&model.nodes[model.treeRoots[t]], features + first, stride, n,
+                              model.treeClass[t], model.numClasses, margins);
+            }
+        }
+        for (int s = 0; s < n; s++) softmax(margins + s * model.numClasses, model.numClasses);
+    }
+}
+
+inline void evalQuantTreeBlock(const QuantTreeNode* root, const uint16_t* bins, const float* leaves,
+                               int count, int cls, int numClasses, float* margins) {
+    const QuantTreeNode* node[TREE_BATCH_BLOCK];
+    for (int s = 0; s < count; s++) node[s] = root;
+    uint32_t active = 1;
+    while (active) {
+        active = 0;
+        for (int s = 0; s < count; s++) {
+            const QuantTreeNode* n = node[s];
+            uint32_t split = n->feature != QTREE_LEAF;
+            uint32_t f = split ? n->feature : 0;
+            uint32_t right = bins[f * TREE_BATCH_BLOCK + s] <= n->bin ? 0 : 1;
+            node[s] = n + n->left + (right & split);
+            active |= split;
+        }
+    }
+    for (int s = 0; s < count; s++) margins[s * numClasses + cls] += leaves[node[s]->bin];
+}
+
+/**
+ * quantPredict() for many samples
+ *
+ * @param raw Raw features, feature-major: raw[f * stride + s]
+ * @param stride Distance between features of one sample (>= count)
+ * @param count Number of samples
+ * @param probs Output, sample-major: probs[s * numClasses + c]
+ */
+inline void quantPredictBatch(const QuantEnsemble& model, const float* raw, size_t stride,
+                              size_t count, float* probs) {
+    if (model.numFeatures > TREE_BATCH_MAX_FEATURES) {
+        // Too wide for the stack buffers: score one by one
+        float sample[QTREE_LEAF];
+        for (size_t s = 0; s < count; s++) {
+            for (int f = 0; f < model.numFeatures; f++) sample[f] = raw[f * stride + s];
+            quantPredict(model, sample, probs + s * model.numClasses);
+        }
+        return;
+    }
+
+    uint16_t bins[TREE_BATCH_MAX_FEATURES * TREE_BATCH_BLOCK];
+    for (size_t first = 0; first < count; first += TREE_BATCH_BLOCK) {
+        int n = (int)(count - first < TREE_BATCH_BLOCK ? count - first : TREE_BATCH_BLOCK);
+
+        // Bin the block feature-major, one row of TREE_BATCH_BLOCK per feature
+        float sample[TREE_BATCH_MAX_FEATURES];
+        uint16_t sampleBins[TREE_BATCH_MAX_FEATURES];
+        for (int s = 0; s < n; s++) {
+            for (int f = 0; f < model.numFeatures; f++) sample[f] = raw[f * stride + first + s];
+            quantizeFeatures(model, sample, sampleBins);
+            for (int f = 0; f < model.numFeatures; f++) bins[f * TREE_BATCH_BLOCK + s] = sampleBins[f];
+        }
+
+        float* margins = probs + first * model.numClasses;
+        for (int i = 0; i < n * model.numClasses; i++) margins[i] = model.baseScore;
+        for (uint32_t t = 0; t < model.numTrees; t++) {
+            evalQuantTreeBlock(&model.nodes[model.treeRoots[t]], bins, model.leaves, n,
+                               model.treeClass[t], model.numClasses, margins);
+        }
+        for (int s = 0; s < n; s++) softmax(margins + s * model.numClasses, model.numClasses);
+    }
+}
+
+#endif // TREE_ENSEMBLE_H
@@ -0,0 +1,54 @@
+/**
+ * VAE Anomaly Score
+ *
+ * The VAE runs as one dense chain on the normalized features:
+ *   encoder hidden layers -> latent mean -> decoder layers -> reconstruction
+ * The log-variance head and the sampling step are training-only; scoring
+ * decodes the posterior mean, so the result is deterministic.
+ *
+ * The score is the mean squared reconstruction error against the float
+ * input (not its int8 copy, so out-of-range features still count in
+ * full), scaled so the calibration set's 99th percentile lands at 128
+ * and clamped to the packet's 0-255 anomalyScore.
+ */
+
+#ifndef VAE_ANOMALY_H
+#define VAE_ANOMALY_H
+
+#include <stdint.h>
+#include "dense_network.h"
+
+struct VaeModel {
+    DenseNetwork net;
+    float errorScale;   // Score per unit of mean squared error
+};
+
+/**
+ * Mean squared reconstruction error
+ *
+ * @param normalized layers[0].inputs normalized features
+ */
+inline float vaeReconstructionError(const VaeModel& model, const float* normalized, DenseArena* arena) {
+    float* recon = arena->out;
+    denseForward(model.net, normalized, recon, arena);
+    int n = model.net.layers[0].inputs;
+    float sum = 0.0f;
+    for (int i = 0; i < n; i++) {
+        float d = recon[i] - normalized[i];
+        sum += d * d;
+    }
+    return sum / n;
+}
+
+// Reconstruction error mapped to 0-255
+inline uint8_t vaeScoreFromError(const VaeModel& model, float error) {
+    float score = error * model.errorScale;
+    if (score >= 255.0f) return 255;
+    return (uint8_t)(score + 0.5f);
+}
+
+inline uint8_t vaeAnomalyScore(const VaeModel& model, const float* normalized, DenseArena* arena) {
+    return vaeScoreFromError(model, vaeReconstructionError(model, normalized, arena));
+}
+
+#endif // VAE_ANOMALY_H
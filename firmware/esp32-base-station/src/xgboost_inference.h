@@ -2,23 +2,45 @@
  * XGBoost Inference for Buzzhive Base Station
  * 
  * This file provides the interface for running XGBoost inference.
- * The actual model is stored in SPIFFS/LittleFS as a JSON file.
  * 
  * Model: XGBoost with 800 trees, 4 classes
  * Accuracy: 78.8%
  * 
- * For ESP32 deployment options:
- * 1. Load JSON model from SPIFFS (this approach)
- * 2. Use a simplified/pruned model
- * 3. Use Random Forest (simpler tree structure)
+ * With USE_COMPILED_MODEL the trained trees are compiled into flash:
+ *   g++ -std=c++17 -O2 -I firmware/esp32-base-station/src \
+ *       tools/xgb_convert.cpp -o xgb_convert
+ *   ./xgb_convert models/xgboost_queen_detector.json \
+ *       -o firmware/esp32-base-station/src/xgboost_model.h
+ * USE_QUANTIZED_MODEL instead uses the --quantized output
+ * (xgboost_model_quant.h): the scaler is folded into the thresholds, so
+ * raw features go straight to integer bin compares with identical results.
+ * USE_CODEGEN_MODEL replaces the node tables with the --codegen output
+ * (xgboost_model_code.h): every tree as nested constant compares, same
+ * results, larger but faster on small ensembles (tools/bench_codegen.cpp).
+ * USE_FULL_MODEL maps a binary image (xgb_convert --binary) from the
+ * "model" flash partition at boot instead; see model_store.h.
+ * USE_DUAL_CORE_INFERENCE splits the trees of any of these across both
+ * cores (parallel_ensemble.h) once beginDualCoreInference() has run.
+ * Without any of these, a hand-written rule set stands in for the model.
  */
 
 #ifndef XGBOOST_INFERENCE_H
 #define XGBOOST_INFERENCE_H
 
 #include <Arduino.h>
+#include "config.h"
 #include "buzzhive_ml.h"  // Contains scaler parameters
 
+#include "tree_ensemble.h"
+
+#if defined(USE_QUANTIZED_MODEL)
+#include "xgboost_model_quant.h"  // Generated by tools/xgb_convert.cpp --quantized
+#elif defined(USE_CODEGEN_MODEL)
+#include "xgboost_model_code.h"  // Generated by tools/xgb_convert.cpp --codegen
+#elif defined(USE_COMPILED_MODEL)
+#include "xgboost_model.h"  // Generated by tools/xgb_convert.cpp
+#endif
+
 // ============================================================================
 // Feature Normalization
 // ============================================================================
@@ -37,11 +59,10 @@ inline void normalizeFeatures(const float* raw, float* normalized) {
 // ============================================================================
 
 /**
- * Simplified XGBoost prediction using decision rules
+ * Fallback prediction using decision rules
  * 
- * This is a pruned version of the full model focusing on the most
- * important features. For full accuracy, use the JSON model with
- * a proper XGBoost runtime.
+ * Used when no compiled model is built in. For full accuracy, enable
+ * USE_COMPILED_MODEL.
  * 
  * Key features identified from model analysis:
  * - MFCC 1 mean (index 0): Low frequency energy
@@ -49,7 +70,7 @@ inline void normalizeFeatures(const float* raw, float* normalized) {
  * - MFCC 3 mean (index 2): Fine spectral details
  * - Delta MFCC 1 std (index 52): Temporal variation
  */
-inline void xgboostPredict(const float* features, float* scores) {
+inline void heuristicPredict(const float* features, float* scores) {
     // Initialize scores
     scores[0] = 0.0;  // Queenright
     scores[1] = 0.0;  // Queenless
@@ -93,42 +114,227 @@ inline void xgboostPredict(const float* features, float* scores) {
     
     // Default bias toward most common class
     scores[3] += 0.3;  // Queen_Accepted is most common
-    
-    // Note: For production accuracy, load the full JSON model
-    // and use proper tree traversal or integrate with microxgb library
 }
 
 // ============================================================================
-// Full Model Inference (requires SPIFFS + ArduinoJson)
+// Full Model Inference (flash "model" partition)
 // ============================================================================
 
 #ifdef USE_FULL_MODEL
 
-#include <SPIFFS.h>
-#include <ArduinoJson.h>
+#include "model_store.h"
+
+static MappedModel mappedModel;
+static ModelImage flashModel;
+static bool flashModelLoaded = false;
 
-// Load model from SPIFFS
-bool loadXGBoostModel(const char* modelPath) {
-    if (!SPIFFS.begin(true)) {
-        Serial.println("❌ SPIFFS mount failed");
+/**
+ * Map the model image (xgb_convert --binary) from its flash partition
+ * 
+ * The image is validated (header + CRC) and then used in place through
+ * the flash cache: no heap, no parsing, no copy.
+ */
+bool loadXGBoostModel(const char* partitionLabel = MODEL_PARTITION_LABEL) {
+    ModelStatus status = openModel(partitionLabel, &mappedModel, &flashModel);
+    if (status != MODEL_OK) {
+        Serial.printf("❌ Model partition '%s': %s\n", partitionLabel, modelStatusName(status));
         return false;
     }
     
-    File file = SPIFFS.open(modelPath, "r");
-    if (!file) {
-        Serial.println("❌ Model file not found");
+    flashModelLoaded = true;
+    bool quantized = flashModel.kind == MODEL_KIND_QUANTIZED;
+    Serial.printf("✅ Model mapped from flash: %u trees (%s)\n",
+                  (unsigned)(quantized ? flashModel.quant.numTrees : flashModel.trees.numTrees),
+                  quantized ? "quantized" : "float");
+    return true;
+}
+
+#endif // USE_FULL_MODEL
+
+// ============================================================================
+// Dual-Core Evaluation
+// ============================================================================
+
+#ifdef USE_DUAL_CORE_INFERENCE
+
+#include "parallel_ensemble.h"
+
+static DualCoreEnsemble dualCore;
+
+/**
+ * Start the tree worker on INFERENCE_WORKER_CORE
+ * 
+ * Call from the task that runs inference: the worker reports back to it.
+ */
+bool beginDualCoreInference() {
+    if (!dualCore.begin(INFERENCE_WORKER_CORE)) {
+        Serial.println("❌ Tree worker task failed to start, inference stays single-core");
         return false;
     }
-    
-    // Parse JSON model
-    // Note: Full XGBoost model is ~4MB, may need streaming parser
-    // or external SD card storage
-    
-    file.close();
+    Serial.printf("✅ Tree worker running on core %d\n", INFERENCE_WORKER_CORE);
     return true;
 }
 
-#endif // USE_FULL_MODEL
+#endif // USE_DUAL_CORE_INFERENCE
 
-#endif // XGBOOST_INFERENCE_H
+// Early-exit scoring on one or both cores
+inline uint32_t scoreModel(const TreeEnsemble& model, const Cascade& cascade,
+                           const float* features, float* scores) {
+#ifdef USE_DUAL_CORE_INFERENCE
+    return dualCore.predictCascade(model, cascade, features, scores);
+#else
+    return ensemblePredictCascade(model, cascade, features, scores);
+#endif
+}
+
+inline uint32_t scoreModel(const QuantEnsemble& model, const Cascade& cascade,
+                           const float* raw, float* scores) {
+#ifdef USE_DUAL_CORE_INFERENCE
+    return dualCore.predictCascade(model, cascade, raw, scores);
+#else
+    return quantPredictCascade(model, cascade, raw, scores);
+#endif
+}
 
+// ============================================================================
+// Model Inference
+// ============================================================================
+
+// Trained float node tables in use, or nullptr
+inline const TreeEnsemble* activeFloatModel() {
+#ifdef USE_FULL_MODEL
+    if (flashModelLoaded) return flashModel.kind == MODEL_KIND_FLOAT ? &flashModel.trees : nullptr;
+#endif
+#if defined(USE_COMPILED_MODEL) && !defined(USE_QUANTIZED_MODEL) && !defined(USE_CODEGEN_MODEL)
+    return &XGB_MODEL;
+#else
+    return nullptr;
+#endif
+}
+
+// Trained quantized model in use, or nullptr
+inline const QuantEnsemble* activeQuantModel() {
+#ifdef USE_FULL_MODEL
+    if (flashModelLoaded) return flashModel.kind == MODEL_KIND_QUANTIZED ? &flashModel.quant : nullptr;
+#endif
+#ifdef USE_QUANTIZED_MODEL
+    return &XGB_QMODEL;
+#else
+    return nullptr;
+#endif
+}
+
+/**
+ * Predict queen status scores from normalized features
+ * 
+ * Uses the flash model when mapped, else the compiled-in model (generated
+ * code or node tables), else the rule set. Trained models stop early on
+ * confident samples when they were converted with calibrated cascade
+ * stages (xgb_convert --calibrate). The generated code always runs on
+ * one core.
+ * 
+ * @param features NUM_FEATURES normalized features
+ * @param scores Output array of NUM_CLASSES scores (class probabilities
+ *               when a trained model is available)
+ */
+inline void xgboostPredict(const float* features, float* scores) {
+#ifdef USE_FULL_MODEL
+    if (flashModelLoaded && flashModel.kind == MODEL_KIND_FLOAT) {
+        scoreModel(flashModel.trees, flashModel.cascade, features, scores);
+        return;
+    }
+#endif
+#if defined(USE_CODEGEN_MODEL) && !defined(USE_QUANTIZED_MODEL)
+    xgbCodePredict(features, scores);
+#elif defined(USE_COMPILED_MODEL) && !defined(USE_QUANTIZED_MODEL)
+    scoreModel(XGB_MODEL, XGB_CASCADE, features, scores);
+#else
+    heuristicPredict(features, scores);
+#endif
+}
+
+/**
+ * Predict queen status scores from raw sensor features
+ * 
+ * Normalizes and calls xgboostPredict(), or with a quantized model
+ * bins the raw features directly.
+ */
+inline void predictQueenStatus(const float* raw, float* scores) {
+#ifdef USE_FULL_MODEL
+    if (flashModelLoaded && flashModel.kind == MODEL_KIND_QUANTIZED) {
+        scoreModel(flashModel.quant, flashModel.cascade, raw, scores);
+        return;
+    }
+#endif
+#ifdef USE_QUANTIZED_MODEL
+    scoreModel(XGB_QMODEL, XGB_Q_CASCADE, raw, scores);
+#else
+    float normalized[NUM_FEATURES];
+    normalizeFeatures(raw, normalized);
+    xgboostPredict(normalized, scores);
+#endif
+}
+
+/**
+ * Predict queen status scores from normalized features, e.g. decoded
+ * from a compact feature packet
+ * 
+ * Quantized models bin raw values, so they get the features scaled back.
+ */
+inline void predictQueenStatusNormalized(const float* normalized, float* scores) {
+    if (activeQuantModel()) {
+        float raw[NUM_FEATURES];
+        for (int i = 0; i < NUM_FEATURES; i++) {
+            raw[i] = normalized[i] * SCALE[i] + MEAN[i];
+        }
+        predictQueenStatus(raw, scores);
+        return;
+    }
+    xgboostPredict(normalized, scores);
+}
+
+// ============================================================================
+// Batch Inference
+// ============================================================================
+
+/**
+ * Score many samples at once (full ensemble, no early exit)
+ * 
+ * Node tables are walked a block at a time; the generated code and the
+ * rule set go through xgboostPredict() one sample at a time.
+ * Not reentrant: call from one task at a time.
+ * 
+ * @param raw Raw features, feature-major: raw[f * stride + s]
+ * @param stride Distance between features of one sample (>= count)
+ * @param count Number of samples
+ * @param scores Output, sample-major: scores[s * NUM_CLASSES + c]
+ */
+inline void predictQueenStatusBatch(const float* raw, size_t stride, size_t count, float* scores) {
+    const QuantEnsemble* quant = activeQuantModel();
+    if (quant) {
+        quantPredictBatch(*quant, raw, stride, count, scores);
+        return;
+    }
+    const TreeEnsemble* trees = activeFloatModel();
+    
+    static float normalized[NUM_FEATURES * TREE_BATCH_BLOCK];
+    for (size_t first = 0; first < count; first += TREE_BATCH_BLOCK) {
+        int n = (int)(count - first < TREE_BATCH_BLOCK ? count - first : TREE_BATCH_BLOCK);
+        for (int f = 0; f < NUM_FEATURES; f++) {
+            for (int s = 0; s < n; s++) {
+                normalized[f * TREE_BATCH_BLOCK + s] = (raw[f * stride + first + s] - MEAN[f]) / SCALE[f];
+            }
+        }
+        if (trees) {
+            ensemblePredictBatch(*trees, normalized, TREE_BATCH_BLOCK, n, scores + first * NUM_CLASSES);
+            continue;
+        }
+        for (int s = 0; s < n; s++) {
+            float sample[NUM_FEATURES];
+            for (int f = 0; f < NUM_FEATURES; f++) sample[f] = normalized[f * TREE_BATCH_BLOCK + s];
+            xgboostPredict(sample, scores + (first + s) * NUM_CLASSES);
+        }
+    }
+}
+
+#endif // XGBOOST_INFERENCE_H
@@ -0,0 +1,161 @@
+/**
+ * Acoustic Activity Gate
+ *
+ * Cheap pre-classifier evaluated on the first second of each recording.
+ * It decides whether the rest of the wake cycle (full capture, feature
+ * aggregation and the LoRa report) is worth paying for:
+ * - RMS level of the conditioned audio (silence detection)
+ * - Cepstral flux: mean L2 distance between consecutive MFCC frames,
+ *   which tracks log-spectral flux because the DCT is orthonormal
+ * - Four coarse band levels (dB), projected from the MFCCs onto quarters
+ *   of the mel range
+ *
+ * Features come from MFCC frames the extractor already computes, so the
+ * gate adds no FFT. The resulting GateSignature is plain data meant to be
+ * kept in RTC memory and compared against on the next wake.
+ *
+ * Portable C++ (no Arduino dependencies) so it also builds on a host.
+ */
+
+#ifndef ACTIVITY_GATE_H
+#define ACTIVITY_GATE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include <atomic>
+#include "mfcc.h"
+
+#define GATE_BANDS 4
+
+// Summary of a probe window; persisted between wake cycles
+struct GateSignature {
+    uint8_t valid;
+    uint8_t skippedCycles;    // Consecutive cycles skipped since the last full report
+    float rmsDb;              // dBFS of the conditioned audio
+    float flux;               // Mean cepstral flux per frame
+    float bandDb[GATE_BANDS];
+};
+
+enum GateDecision {
+    GATE_PENDING = 0,   // Probe not finished yet
+    GATE_ACTIVE,        // New information: run the full cycle
+    GATE_SILENT,        // Below the silence threshold
+    GATE_UNCHANGED      // Matches the last reported signature
+};
+
+class ActivityGate : public MfccFrameObserver {
+public:
+    ActivityGate() : ready_(false) {
+        // Mean of each DCT basis row over a band's mel bins: projecting
+        // MFCCs through this gives the smoothed band level in dB
+        const int perBand = N_MELS / GATE_BANDS;
+        for (int b = 0; b < GATE_BANDS; b++) {
+            for (int k = 0; k < N_MFCC; k++) {
+                float sum = 0.0f;
+                for (int m = b * perBand; m < (b + 1) * perBand; m++) sum += mfccDct.row(k)[m];
+                projection_[b][k] = sum / perBand;
+            }
+        }
+    }
+
+    /**
+     * Start a new probe
+     *
+     * @param probeFrames MFCC frames to observe before deciding
+     */
+    void begin(int probeFrames) {
+        probeFrames_ = probeFrames > 1 ? probeFrames : 2;
+        frames_ = 0;
+        sumSquares_ = 0;
+        sampleCount_ = 0;
+        fluxSum_ = 0.0f;
+        for (int b = 0; b < GATE_BANDS; b++) bandSum_[b] = 0.0f;
+        ready_.store(false, std::memory_order_relaxed);
+    }
+
+    // Conditioned audio, for the RMS level (ignored once the probe is done)
+    void addSamples(const int16_t* samples, size_t count) {
+        if (ready_.load(std::memory_order_relaxed)) return;
+        int64_t sum = 0;
+        for (size_t i = 0; i < count; i++) sum += (int32_t)samples[i] * samples[i];
+        sumSquares_ += sum;
+        sampleCount_ += count;
+    }
+
+    void onMfccFrame(const float* mfcc) override {
+        if (ready_.load(std::memory_order_relaxed)) return;
+
+        if (frames_ > 0) {
+            float d2 = 0.0f;
+            for (int k = 0; k < N_MFCC; k++) {
+                float d = mfcc[k] - prev_[k];
+                d2 += d * d;
+            }
+            fluxSum_ += sqrtf(d2);
+        }
+        for (int b = 0; b < GATE_BANDS; b++) {
+            float level = 0.0f;
+            for (int k = 0; k < N_MFCC; k++) level += projection_[b][k] * mfcc[k];
+            bandSum_[b] += level;
+        }
+        memcpy(prev_, mfcc, sizeof(prev_));
+
+        if (++frames_ >= probeFrames_) finishProbe();
+    }
+
+    // Probe complete; safe to call from another task/core
+    bool ready() const { return ready_.load(std::memory_order_acquire); }
+
+    // Valid once ready()
+    const GateSignature& signature() const { return signature_; }
+
+    /**
+     * Compare the probe against the last reported signature
+     *
+     * @param previous Signature of the last full report (valid == 0 if none)
+     * @param silenceDbfs RMS level below which the clip counts as silent
+     * @param changeDb Level/band change that counts as new information
+     * @param fluxRatio Relative flux change that counts as new information
+     */
+    GateDecision evaluate(const GateSignature& previous, float silenceDbfs,
+                          float changeDb, float fluxRatio) const {
+        if (!ready()) return GATE_PENDING;
+        if (signature_.rmsDb < silenceDbfs) return GATE_SILENT;
+        if (!previous.valid) return GATE_ACTIVE;
+
+        if (fabsf(signature_.rmsDb - previous.rmsDb) > changeDb) return GATE_ACTIVE;
+        for (int b = 0; b < GATE_BANDS; b++) {
+            if (fabsf(signature_.bandDb[b] - previous.bandDb[b]) > changeDb) return GATE_ACTIVE;
+        }
+        float fluxRef = previous.flux > 1e-3f ? previous.flux : 1e-3f;
+        if (fabsf(signature_.flux - previous.flux) / fluxRef > fluxRatio) return GATE_ACTIVE;
+
+        return GATE_UNCHANGED;
+    }
+
+private:
+    void finishProbe() {
+        double meanSquare = sampleCount_ > 0 ? (double)sumSquares_ / sampleCount_ : 0.0;
+        double fullScale = 32768.0 * 32768.0;
+        signature_.valid = 1;
+        signature_.skippedCycles = 0;
+        signature_.rmsDb = (float)(10.0 * log10(meanSquare / fullScale + 1e-12));
+        signature_.flux = fluxSum_ / (frames_ - 1);
+        for (int b = 0; b < GATE_BANDS; b++) signature_.bandDb[b] = bandSum_[b] / frames_;
+        ready_.store(true, std::memory_order_release);
+    }
+
+    float projection_[GATE_BANDS][N_MFCC];
+    float prev_[N_MFCC];
+    int probeFrames_;
+    int frames_;
+    int64_t sumSquares_;
+    size_t sampleCount_;
+    float fluxSum_;
+    float bandSum_[GATE_BANDS];
+    GateSignature signature_;
+    std::atomic<bool> ready_;
+};
+
+#endif // ACTIVITY_GATE_H
@@ -0,0 +1,320 @@
+/**
+ * Raw Audio Clip Compression (IMA-ADPCM)
+ *
+ * Occasional short clips are sent next to the MFCC features so the base
+ * station can store them for labeling and re-run feature extraction:
+ * - IMA-ADPCM, 4 bits per sample (4:1 against int16)
+ * - Optional downsampling before encoding (e.g. 22050 -> 8000 Hz, another
+ *   2.75:1), windowed-sinc low-pass + linear interpolation, integer only
+ * - Both stream: samples are encoded as they are captured, one block at
+ *   a time, so the raw clip is never held in RAM
+ *
+ * Blocks are ADPCM_BLOCK_SAMPLES samples and carry the codec state they
+ * start from, so each one decodes on its own:
+ *
+ *   [predictor int16][step index uint8][0][128 bytes: 2 samples per byte,
+ *                                          first sample in the low nibble]
+ *
+ * Portable C++ (no Arduino dependencies) so it also builds on a host.
+ * Shared by both firmwares: the base station includes this copy (see its
+ * platformio.ini).
+ */
+
+#ifndef AUDIO_COMPRESSION_H
+#define AUDIO_COMPRESSION_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#define ADPCM_BLOCK_SAMPLES 256
+#define ADPCM_HEADER_BYTES 4
+#define ADPCM_BLOCK_BYTES (ADPCM_HEADER_BYTES + ADPCM_BLOCK_SAMPLES / 2)
+
+// Blocks needed for a clip of n samples
+#define ADPCM_CLIP_BLOCKS(n) (((n) + ADPCM_BLOCK_SAMPLES - 1) / ADPCM_BLOCK_SAMPLES)
+
+// Anti-alias filter length of the downsampler
+#define RESAMPLE_TAPS 31
+
+// ============================================================================
+// IMA-ADPCM
+// ============================================================================
+
+static const int16_t ADPCM_STEP_TABLE[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41,
+    45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209,
+    230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876,
+    963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+    3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493,
+    10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623,
+    27086, 29794, 32767
+};
+
+static const int8_t ADPCM_INDEX_TABLE[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+struct AdpcmState {
+    int16_t predictor;
+    uint8_t index;
+};
+
+// Apply one 4-bit code to the state; shared by encoder and decoder so
+// both track the same prediction exactly
+inline int16_t adpcmApply(AdpcmState& state, uint8_t code) {
+    int32_t step = ADPCM_STEP_TABLE[state.index];
+    int32_t delta = step >> 3;
+    if (code & 4) delta += step;
+    if (code & 2) delta += step >> 1;
+    if (code & 1) delta += step >> 2;
+    int32_t p = state.predictor + ((code & 8) ? -delta : delta);
+    p = p > 32767 ? 32767 : (p < -32768 ? -32768 : p);
+    state.predictor = (int16_t)p;
+
+    int index = state.index + ADPCM_INDEX_TABLE[code & 7];
+    state.index = (uint8_t)(index < 0 ? 0 : (index > 88 ? 88 : index));
+    return state.predictor;
+}
+
+inline uint8_t adpcmEncodeSample(AdpcmState& state, int16_t sample) {
+    int32_t step = ADPCM_STEP_TABLE[state.index];
+    int32_t diff = sample - state.predictor;
+    uint8_t code = 0;
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+    if (diff >= step) { code |= 4; diff -= step; }
+    step >>= 1;
+    if (diff >= step) { code |= 2; diff -= step; }
+    step >>= 1;
+    if (diff >= step) code |= 1;
+    adpcmApply(state, code);
+    return code;
+}
+
+/**
+ * Encode one block
+ *
+ * @param state Codec state, carried from the previous block
+ * @param samples ADPCM_BLOCK_SAMPLES samples
+ * @param block Output, ADPCM_BLOCK_BYTES bytes
+ */
+inline void adpcmEncodeBlock(AdpcmState& state, const int16_t* samples, uint8_t* block) {
+    block[0] = (uint8_t)((uint16_t)state.predictor & 0xFF);
+    block[1] = (uint8_t)((uint16_t)state.predictor >> 8);
+    block[2] = state.index;
+    block[3] = 0;
+    uint8_t* out = block + ADPCM_HEADER_BYTES;
+    for (int i = 0; i < ADPCM_BLOCK_SAMPLES; i += 2) {
+        uint8_t lo = adpcmEncodeSample(state, samples[i]);
+        uint8_t hi = adpcmEncodeSample(state, samples[i + 1]);
+        *out++ = (uint8_t)(lo | (hi << 4));
+    }
+}
+
+/**
+ * Decode one block
+ *
+ * @param block ADPCM_BLOCK_BYTES bytes
+ * @param samples Output, ADPCM_BLOCK_SAMPLES samples
+ * @return false if the header is corrupt
+ */
+inline bool adpcmDecodeBlock(const uint8_t* block, int16_t* samples) {
+    AdpcmState state;
+    state.predictor = (int16_t)(uint16_t)(block[0] | (block[1] << 8));
+    state.index = block[2];
+    if (state.index > 88) return false;
+    const uint8_t* in = block + ADPCM_HEADER_BYTES;
+    for (int i = 0; i < ADPCM_BLOCK_SAMPLES; i += 2) {
+        uint8_t b = *in++;
+        samples[i] = adpcmApply(state, b & 0x0F);
+        samples[i + 1] = adpcmApply(state, b >> 4);
+    }
+    return true;
+}
+
+// ============================================================================
+// Downsampler
+// ============================================================================
+
+/**
+ * Streaming downsampler for any rate ratio
+ *
+ * Low-passes at 0.9 x the output Nyquist (Hamming-windowed sinc, Q14
+ * taps), then interpolates linearly between filtered input samples at
+ * the exact output instants (n * inRate / outRate, tracked as an integer
+ * phase, so there is no drift over a clip). One FIR per input sample:
+ * ~31 MACs at 22050 Hz.
+ */
+class AudioDownsampler {
+public:
+    /**
+     * @param inRate Capture rate
+     * @param outRate Target rate; >= inRate passes samples through
+     */
+    void begin(int inRate, int outRate) {
+        inRate_ = inRate;
+        outRate_ = outRate < inRate ? outRate : inRate;
+        phase_ = outRate_;
+        pos_ = 0;
+        prevY_ = 0;
+        memset(history_, 0, sizeof(history_));
+        if (!active()) return;
+
+        float cutoff = 0.45f * outRate_ / inRate_;   // Cycles per input sample
+        float taps[RESAMPLE_TAPS];
+        float sum = 0.0f;
+        const int mid = RESAMPLE_TAPS / 2;
+        for (int k = 0; k < RESAMPLE_TAPS; k++) {
+            float t = (float)(k - mid);
+            float sinc = t == 0.0f ? 2.0f * cutoff
+                                   : sinf(2.0f * (float)M_PI * cutoff * t) / ((float)M_PI * t);
+            float window = 0.54f - 0.46f * cosf(2.0f * (float)M_PI * k / (RESAMPLE_TAPS - 1));
+            taps[k] = sinc * window;
+            sum += taps[k];
+        }
+        for (int k = 0; k < RESAMPLE_TAPS; k++) {
+            taps_[k] = (int16_t)lrintf(taps[k] / sum * 16384.0f);   // Unity DC gain
+        }
+    }
+
+    bool active() const { return outRate_ < inRate_; }
+    int outputRate() const { return outRate_; }
+
+    // Output samples produced for `count` inputs, at most
+    size_t maxOutput(size_t count) const {
+        return active() ? count * outRate_ / inRate_ + 1 : count;
+    }
+
+    /**
+     * @param out At least maxOutput(count) samples
+     * @return Number of samples written
+     */
+    size_t process(const int16_t* in, size_t count, int16_t* out) {
+        if (!active()) {
+            memcpy(out, in, count * sizeof(int16_t));
+            return count;
+        }
+        size_t produced = 0;
+        for (size_t i = 0; i < count; i++) {
+            // Doubled ring: the last RESAMPLE_TAPS inputs are contiguous
+            pos_ = pos_ + 1 == RESAMPLE_TAPS ? 0 : pos_ + 1;
+            history_[pos_] = history_[pos_ + RESAMPLE_TAPS] = in[i];
+            const int16_t* x = &history_[pos_ + 1];
+            int32_t acc = 0;
+            for (int k = 0; k < RESAMPLE_TAPS; k++) acc += taps_[k] * x[k];
+            int32_t y = acc >> 14;
+
+            // phase_ / outRate_ = position of the next output after the
+            // previous input; emit every output up to this input
+            while (phase_ <= outRate_) {
+                int32_t v = (prevY_ * (outRate_ - phase_) + y * phase_) / outRate_;
+                out[produced++] = (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+                phase_ += inRate_;
+            }
+            phase_ -= outRate_;
+            prevY_ = y;
+        }
+        return produced;
+    }
+
+private:
+    int16_t taps_[RESAMPLE_TAPS];
+    int16_t history_[2 * RESAMPLE_TAPS];
+    int pos_ = 0;
+    int32_t prevY_ = 0;
+    int32_t phase_ = 0;
+    int32_t inRate_ = 0;
+    int32_t outRate_ = 0;
+};
+
+// ============================================================================
+// Clip Encoder
+// ============================================================================
+
+/**
+ * Downsample and ADPCM-encode a clip into a caller-owned buffer while it
+ * is captured; samples past the buffer's capacity are dropped.
+ *
+ *   encoder.begin(22050, 8000, buffer, ADPCM_CLIP_BLOCKS(8000 * 4));
+ *   encoder.push(chunk, n);   // per capture chunk, before conditioning
+ *   encoder.finish();         // zero-pads the last block
+ */
+class AudioClipEncoder {
+public:
+    /**
+     * @param buffer capacityBlocks * ADPCM_BLOCK_BYTES bytes
+     */
+    void begin(int inRate, int outRate, uint8_t* buffer, size_t capacityBlocks) {
+        resampler_.begin(inRate, outRate);
+        state_.predictor = 0;
+        state_.index = 0;
+        buffer_ = buffer;
+        capacity_ = capacityBlocks;
+        blocks_ = 0;
+        pending_ = 0;
+        samples_ = 0;
+    }
+
+    void push(const int16_t* samples, size_t count) {
+        int16_t scratch[64];
+        while (count > 0 && !full()) {
+            // Chunks small enough that the output always fits in scratch
+            size_t n = count < 64 ? count : 64;
+            size_t produced = resampler_.process(samples, n, scratch);
+            samples += n;
+            count -= n;
+            for (size_t i = 0; i < produced && !full(); i++) {
+                pendingSamples_[pending_++] = scratch[i];
+                if (pending_ == ADPCM_BLOCK_SAMPLES) flushBlock();
+            }
+        }
+    }
+
+    void finish() {
+        if (pending_ > 0 && !full()) {
+            memset(&pendingSamples_[pending_], 0, (ADPCM_BLOCK_SAMPLES - pending_) * sizeof(int16_t));
+            flushBlock();
+        }
+        pending_ = 0;
+    }
+
+    bool full() const { return blocks_ >= capacity_; }
+    size_t blockCount() const { return blocks_; }
+    size_t bytes() const { return blocks_ * ADPCM_BLOCK_BYTES; }
+    uint32_t sampleCount() const { return samples_; }   // Before padding
+    int sampleRate() const { return resampler_.outputRate(); }
+    const uint8_t* block(size_t i) const { return buffer_ + i * ADPCM_BLOCK_BYTES; }
+
+private:
+    void flushBlock() {
+        adpcmEncodeBlock(state_, pendingSamples_, buffer_ + blocks_ * ADPCM_BLOCK_BYTES);
+        samples_ += pending_;
+        blocks_++;
+        pending_ = 0;
+    }
+
+    AudioDownsampler resampler_;
+    AdpcmState state_;
+    int16_t pendingSamples_[ADPCM_BLOCK_SAMPLES];
+    size_t pending_ = 0;
+    uint8_t* buffer_ = nullptr;
+    size_t capacity_ = 0;
+    size_t blocks_ = 0;
+    uint32_t samples_ = 0;
+};
+
+// ============================================================================
+// Clip Message
+// ============================================================================
+
+// Start of a clip message (TRANSPORT_MSG_AUDIO_CLIP, lora_transport.h);
+// blockCount ADPCM blocks follow
+struct __attribute__((packed)) AudioClipInfo {
+    uint8_t clipId;           // Per-hive clip counter, wraps
+    uint16_t blockCount;
+    uint16_t sampleRate;      // Hz, after downsampling
+};
+
+#endif // AUDIO_COMPRESSION_H
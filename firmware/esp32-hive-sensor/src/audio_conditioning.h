@@ -0,0 +1,107 @@
+/**
+ * Single-Pass Audio Conditioning for the MFCC Front End
+ *
+ * Runs once over each captured chunk, in place:
+ * - DC-offset removal (INMP441 output sits slightly off zero)
+ * - Pre-emphasis y[n] = x[n] - 0.97 * x[n-1], saturated to int16
+ * - Peak tracking for normalization
+ *
+ * Normalization is not applied to the samples. gain() returns the single
+ * scale factor that MfccStream::finish() folds into the log-mel domain,
+ * so there is no per-sample divide and no second pass over the clip.
+ *
+ * The DC estimate lags one chunk: a chunk is corrected with the estimate
+ * from the chunks before it, and its mean, summed in the same loop,
+ * updates the estimate afterwards. The per-sample loop then carries only
+ * the sum and the peak (reductions), so the compiler can vectorize it.
+ * Only the first chunk of a clip is read twice, to start the estimate at
+ * its mean.
+ *
+ * Portable C++ (no Arduino dependencies) so it also builds on a host.
+ */
+
+#ifndef AUDIO_CONDITIONING_H
+#define AUDIO_CONDITIONING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Pre-emphasis coefficient 0.97 in Q15
+#define PRE_EMPHASIS_Q15 31785
+
+// DC tracker smoothing: the estimate moves 1/2^DC_SMOOTH_SHIFT of the way
+// to each new chunk mean (~8 chunks of 512 samples, about 190 ms)
+#define DC_SMOOTH_SHIFT 3
+
+class AudioConditioner {
+public:
+    void begin() {
+        dcQ8_ = 0;
+        prevSample_ = 0;
+        peak_ = 0;
+        primed_ = false;
+    }
+
+    /**
+     * Condition a chunk of samples in place
+     *
+     * @param samples Audio samples (int16_t), replaced by the conditioned signal
+     * @param count Number of samples
+     */
+    void process(int16_t* samples, size_t count) {
+        if (count == 0) return;
+
+        if (!primed_) {
+            dcQ8_ = chunkMeanQ8(samples, count);
+            prevSample_ = (int16_t)(dcQ8_ >> 8);
+            primed_ = true;
+        }
+
+        // (x[n] - dc) - 0.97 * (x[n-1] - dc) = x[n] - 0.97 * x[n-1] - 0.03 * dc
+        int32_t dcTerm = (int32_t)(((int64_t)dcQ8_ * (32768 - PRE_EMPHASIS_Q15)) >> (15 + 8));
+
+        // Walk backwards so x[n-1] is still the raw sample when x[n] is written
+        int16_t last = samples[count - 1];
+        int64_t sum = 0;
+        int32_t peak = peak_;
+        for (size_t i = count - 1; i > 0; i--) {
+            sum += samples[i];
+            int32_t y = samples[i] - ((PRE_EMPHASIS_Q15 * samples[i - 1]) >> 15) - dcTerm;
+            y = y > 32767 ? 32767 : (y < -32768 ? -32768 : y);
+            samples[i] = (int16_t)y;
+            int32_t a = y < 0 ? -y : y;
+            peak = a > peak ? a : peak;
+        }
+        sum += samples[0];
+        int32_t y = samples[0] - ((PRE_EMPHASIS_Q15 * prevSample_) >> 15) - dcTerm;
+        y = y > 32767 ? 32767 : (y < -32768 ? -32768 : y);
+        samples[0] = (int16_t)y;
+        int32_t a = y < 0 ? -y : y;
+        peak_ = a > peak ? a : peak;
+
+        int32_t meanQ8 = (int32_t)((sum << 8) / (int64_t)count);
+        dcQ8_ += (meanQ8 - dcQ8_) >> DC_SMOOTH_SHIFT;
+        prevSample_ = last;
+    }
+
+    // Scale factor that normalizes the conditioned clip to full scale
+    float gain() const {
+        return (peak_ > 0) ? 32767.0f / peak_ : 1.0f;
+    }
+
+    int32_t peak() const { return peak_; }
+
+private:
+    static int32_t chunkMeanQ8(const int16_t* samples, size_t count) {
+        int64_t sum = 0;
+        for (size_t i = 0; i < count; i++) sum += samples[i];
+        return (int32_t)((sum << 8) / (int64_t)count);
+    }
+
+    int32_t dcQ8_;
+    int16_t prevSample_;
+    int32_t peak_;
+    bool primed_;
+};
+
+#endif // AUDIO_CONDITIONING_H
@@ -0,0 +1,111 @@
+/**
+ * Capture -> Extract Pipeline
+ *
+ * Hands I2S blocks from a capture task to an extraction task through a
+ * lock-free SPSC ring, so MFCC frames are computed on one core while the
+ * other keeps reading the microphone. Feature extraction then finishes a
+ * few milliseconds after the last sample arrives instead of starting there.
+ *
+ * The pipeline is threading-agnostic: the firmware runs the two sides as
+ * FreeRTOS tasks pinned to different cores, and tools/pipeline_sim.cpp
+ * runs them as std::threads on a host.
+ *
+ * Producer:                          Consumer:
+ *   AudioBlock* b = p.beginWrite();    while (!p.finished()) {
+ *   (fill b->samples, b->count)          if (!p.consumeOne(fn)) idle();
+ *   p.commitWrite();                   }
+ *   ...
+ *   p.endCapture();
+ */
+
+#ifndef CAPTURE_PIPELINE_H
+#define CAPTURE_PIPELINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "spsc_ring.h"
+
+// Samples per ring slot (one i2s_read of 1 KB)
+#define PIPELINE_BLOCK_SAMPLES 512
+
+struct AudioBlock {
+    uint16_t count;
+    int16_t samples[PIPELINE_BLOCK_SAMPLES];
+};
+
+template <uint32_t BLOCKS>
+class CapturePipeline {
+public:
+    CapturePipeline() : captureDone_(false), producerStalls_(0), maxDepth_(0) {}
+
+    // Reset before starting either side
+    void begin() {
+        ring_.reset();
+        captureDone_.store(false, std::memory_order_relaxed);
+        producerStalls_ = 0;
+        maxDepth_ = 0;
+    }
+
+    // ---- Producer (capture) side ----
+
+    /**
+     * Get the next block to fill
+     *
+     * @return Block to fill, or nullptr if the consumer has fallen a full
+     *         ring behind (counted as a stall; retry after yielding)
+     */
+    AudioBlock* beginWrite() {
+        AudioBlock* block = ring_.acquireWrite();
+        if (!block) producerStalls_++;
+        return block;
+    }
+
+    void commitWrite() {
+        ring_.commitWrite();
+        uint32_t depth = ring_.size();
+        if (depth > maxDepth_) maxDepth_ = depth;
+    }
+
+    // No more blocks will be written
+    void endCapture() {
+        captureDone_.store(true, std::memory_order_release);
+    }
+
+    // ---- Consumer (extraction) side ----
+
+    /**
+     * Process the oldest pending block, if any
+     *
+     * @param fn Called as fn(samples, count); may modify the samples in place
+     * @return true if a block was processed
+     */
+    template <class Fn>
+    bool consumeOne(Fn fn) {
+        AudioBlock* block = ring_.acquireRead();
+        if (!block) return false;
+        fn(block->samples, (size_t)block->count);
+        ring_.releaseRead();
+        return true;
+    }
+
+    // Capture has ended and every block has been consumed
+    bool finished() const {
+        // Check the flag first: blocks committed before endCapture() are
+        // then guaranteed to be visible to the emptiness check
+        return captureDone_.load(std::memory_order_acquire) && ring_.empty();
+    }
+
+    // ---- Statistics (producer side) ----
+
+    uint32_t producerStalls() const { return producerStalls_; }
+    uint32_t maxDepth() const { return maxDepth_; }
+
+private:
+    SpscRing<AudioBlock, BLOCKS> ring_;
+    std::atomic<bool> captureDone_;
+    uint32_t producerStalls_;
+    uint32_t maxDepth_;
+};
+
+#endif // CAPTURE_PIPELINE_H
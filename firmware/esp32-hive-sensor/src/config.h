@@ -32,6 +32,81 @@
 // LoRa bandwidth
 #define LORA_BANDWIDTH 125E3
 
+// Send the MFCC features, quantized (feature_packet.h), so the base
+// station classifies them (comment out to send the summary packet only)
+#define USE_FEATURE_UPLINK
+
+// Bits per feature in the uplink (4-8): 8 = 88-byte packet, 6 = 69 bytes
+#define FEATURE_BITS 8
+
+// Messages over one packet (audio clips) go through lora_transport.h:
+// payload bytes per fragment (1-245) and send/ACK rounds before giving up
+#define TRANSPORT_FRAGMENT_BYTES 240
+#define TRANSPORT_MAX_ROUNDS 12
+
+// Rounds for a message of one fragment (a report). A hive at the edge of
+// LINK_SF_MAX at full power has no slower setting to fall back to, and
+// would pay every round for each lost report: 3 rounds instead of 12
+// cut its time on air per report from 5.7 s to 2.2 s
+// (tools/link_adaptation_sim.cpp)
+#define TRANSPORT_REPORT_ROUNDS 3
+
+// Extra ACK wait on top of the ACK's time on air (base station turnaround)
+#define TRANSPORT_ACK_MARGIN_MS 300
+
+// Let the base station pick this hive's spreading factor and TX power
+// (link_adaptation.h). Reports then go as acknowledged transport
+// messages (needs USE_FEATURE_UPLINK); LORA_SPREADING_FACTOR is the
+// starting point after a cold boot.
+// #define USE_ADAPTIVE_LINK
+
+// Spreading factors the base station scans (must match it)
+#define LINK_SF_MIN 7
+#define LINK_SF_MAX 10
+
+// Listen for the base station's answer after each report (downlink.h):
+// classification, alert mode and next wake interval. Costs one short
+// receive window per report; needs USE_FEATURE_UPLINK and the base
+// station's USE_DOWNLINK.
+// #define USE_DOWNLINK
+
+// Back to the own schedule (alert mode and wake interval cleared) after
+// this many reports in a row without an answer
+#define DOWNLINK_MAX_MISSES 6
+
+// Keep readings in RTC memory and send them together (report_batch.h):
+// every REPORT_BATCH_READINGS wakes, or at once on an alert. Replaces the
+// per-wake feature report and heartbeat; needs USE_FEATURE_UPLINK.
+// #define USE_REPORT_BATCH
+
+// Readings per batch (1-16); one that would overflow the frame waits
+// for the next batch
+#define REPORT_BATCH_READINGS 8
+
+// Bits per feature in batches (4-8): 8 fits 3 readings with features in
+// a frame; at 4, most deltas between readings take 1-3 bits and 8 fit.
+// Lower it only once tools/bench_trees.cpp shows the model keeps its
+// classes at that width
+#define REPORT_BATCH_FEATURE_BITS 8
+
+// Send the batch at once when hive temperature moves this much between
+// readings (°C)
+#define REPORT_BATCH_ALERT_TEMP_C 3.0
+
+// Report in the slot the base station gives this hive (slot_schedule.h)
+// instead of at random, so hives never collide: wakes just before the
+// slot and holds the report for it. Needs USE_DOWNLINK (the time
+// reference) and the base station's USE_TDMA.
+// #define USE_TDMA
+
+// Slot cycle, the base station's TDMA_CYCLE_MS. Report intervals round
+// to whole cycles; shorter ones (alert mode, ALERT_MODE_INTERVAL_MS) keep
+// the slot every cycle and send the extra reports at random in between.
+#define TDMA_CYCLE_MS (15 * 60 * 1000)
+
+// Wake this much earlier than the last wake took to have its report ready
+#define TDMA_WAKE_GUARD_MS 500
+
 // ============================================================================
 // Audio Configuration
 // ============================================================================
@@ -42,6 +117,53 @@
 // Recording duration in seconds
 #define AUDIO_DURATION_SEC 10
 
+// Compute MFCCs on the second core while recording (comment out to
+// extract inline in the capture loop)
+#define USE_CAPTURE_PIPELINE
+
+// Core for the MFCC extraction task (the Arduino loop runs on core 1)
+#define EXTRACT_TASK_CORE 0
+
+// Send a short raw clip (IMA-ADPCM, audio_compression.h) with every
+// AUDIO_CLIP_EVERY_N_REPORTS-th full report, for labeling and re-analysis
+// at the base station. Sent as one transport message: a 4 s clip at 8 kHz
+// is 16.5 KB, 69 fragments, ~2.5 min on air at SF10 - mind your region's
+// duty-cycle limit (comment out to never send audio)
+// #define USE_AUDIO_CLIP_UPLINK
+
+#define AUDIO_CLIP_EVERY_N_REPORTS 96  // Once a day at 15-minute reports
+
+// Clip length, from the start of the recording
+#define AUDIO_CLIP_SEC 4
+
+// Clip sample rate: 8000 is enough to listen to and label (16 KB buffer
+// for 4 s); AUDIO_SAMPLE_RATE keeps the band the model's MFCCs use, so the
+// base station can re-run inference on the clip (44 KB)
+#define AUDIO_CLIP_SAMPLE_RATE 8000
+
+// ============================================================================
+// Activity Gate
+// ============================================================================
+
+// Skip the full recording and report when the hive sounds the same as at
+// the last report, or is silent (comment out to always report)
+#define USE_ACTIVITY_GATE
+
+// Length of the probe at the start of each recording
+#define GATE_PROBE_MS 1000
+
+// RMS level (dBFS, after pre-emphasis) below which a clip counts as silent
+#define GATE_SILENCE_DBFS -60.0
+
+// Level or band change (dB) that counts as new information
+#define GATE_CHANGE_DB 3.0
+
+// Relative spectral flux change that counts as new information
+#define GATE_FLUX_RATIO 0.3
+
+// Force a full report after this many skipped cycles
+#define GATE_MAX_SKIPPED_CYCLES 4
+
 // ============================================================================
 // Power Management
 // ============================================================================
@@ -79,5 +201,25 @@
 // Status LED
 #define LED_PIN 2
 
+// ============================================================================
+// Option Dependencies
+// ============================================================================
+
+#if defined(USE_ADAPTIVE_LINK) && !defined(USE_FEATURE_UPLINK)
+#error "USE_ADAPTIVE_LINK needs USE_FEATURE_UPLINK"
+#endif
+
+#if defined(USE_DOWNLINK) && !defined(USE_FEATURE_UPLINK)
+#error "USE_DOWNLINK needs USE_FEATURE_UPLINK"
+#endif
+
+#if defined(USE_REPORT_BATCH) && !defined(USE_FEATURE_UPLINK)
+#error "USE_REPORT_BATCH needs USE_FEATURE_UPLINK"
+#endif
+
+#if defined(USE_TDMA) && !defined(USE_DOWNLINK)
+#error "USE_TDMA needs USE_DOWNLINK"
+#endif
+
 #endif // CONFIG_H
 
@@ -0,0 +1,61 @@
+/**
+ * DCT-II with a Cached Cosine Basis
+ *
+ * Orthonormal DCT-II (scipy.fft.dct(type=2, norm='ortho'), as used by
+ * librosa.feature.mfcc) that only produces the first N_OUT coefficients.
+ * The N_OUT x N_IN basis is built once when the object is constructed, so
+ * each transform is N_OUT * N_IN multiply-accumulates with no cos() calls.
+ *
+ * Usage:
+ *   static DCT2<40, 13> dct;       // 40 mel bands -> 13 cepstral coefficients
+ *   dct.compute(melDb, mfcc);
+ *
+ * Portable C++ (no Arduino dependencies) so it also builds on a host.
+ */
+
+#ifndef DCT_H
+#define DCT_H
+
+#include <math.h>
+
+template <int N_IN, int N_OUT>
+class DCT2 {
+public:
+    static_assert(N_OUT > 0 && N_OUT <= N_IN, "DCT2 output count must be in 1..N_IN");
+
+    DCT2() {
+        const double s0 = sqrt(1.0 / N_IN);
+        const double sk = sqrt(2.0 / N_IN);
+        for (int k = 0; k < N_OUT; k++) {
+            double norm = (k == 0) ? s0 : sk;
+            for (int i = 0; i < N_IN; i++) {
+                basis_[k][i] = (float)(norm * cos(M_PI * k * (2 * i + 1) / (2.0 * N_IN)));
+            }
+        }
+    }
+
+    /**
+     * Transform one vector
+     *
+     * @param input N_IN values
+     * @param output First N_OUT DCT-II coefficients
+     */
+    void compute(const float* input, float* output) const {
+        for (int k = 0; k < N_OUT; k++) {
+            const float* row = basis_[k];
+            float sum = 0.0f;
+            for (int i = 0; i < N_IN; i++) {
+                sum += row[i] * input[i];
+            }
+            output[k] = sum;
+        }
+    }
+
+    // Basis row k, scaled for the orthonormal transform
+    const float* row(int k) const { return basis_[k]; }
+
+private:
+    float basis_[N_OUT][N_IN];
+};
+
+#endif // DCT_H
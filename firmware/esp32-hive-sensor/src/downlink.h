@@ -0,0 +1,82 @@
+/**
+ * Downlink Window
+ *
+ * After each feature report the sensor sleeps its radio for
+ * DOWNLINK_DELAY_MS, counted from the end of its last uplink frame, then
+ * listens just long enough for one BuzzhiveDownlink at its spreading
+ * factor, DOWNLINK_WINDOW_MARGIN_MS early and late. The base station
+ * classifies the report in the meantime and sends the answer at exactly
+ * that delay after the frame's RxDone:
+ *
+ *   uplink |--- delay: radio asleep ---| margin | downlink | margin |
+ *
+ * The answer carries the classification and the hive's schedule: alert
+ * mode (the sensor's ALERT_MODE_INTERVAL_MS) and/or an explicit wake
+ * interval. No answer leaves the sensor on its own schedule.
+ *
+ * With TDMA slots (slot_schedule.h) the answer is also the hive's time
+ * reference: the base station's clock at its start, and how far that is
+ * from the hive's next slot.
+ *
+ * A wrong schedule can keep a hive asleep for hours, so the answer ends
+ * in a CRC-8 and a wake interval outside DOWNLINK_MIN_WAKE_S..
+ * DOWNLINK_MAX_WAKE_S is refused with it.
+ *
+ * Portable C++ (no Arduino dependencies). Shared by both firmwares: the
+ * base station includes this copy (see its platformio.ini).
+ */
+
+#ifndef DOWNLINK_H
+#define DOWNLINK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "lora_transport.h"
+
+#define DOWNLINK_MAGIC 0xD7
+
+// Uplink end to downlink start; covers inference and a transport ACK
+#define DOWNLINK_DELAY_MS 1000
+
+// Window opens this early and closes this late (clock error, turnaround)
+#define DOWNLINK_WINDOW_MARGIN_MS 50
+
+// Flags
+#define DOWNLINK_ALERT 0x01       // Wake every ALERT_MODE_INTERVAL_MS, report every wake
+#define DOWNLINK_SLOT 0x02        // baseTimeMs / slotInMs are set
+
+// Wake intervals a sensor accepts (besides 0)
+#define DOWNLINK_MIN_WAKE_S 60
+#define DOWNLINK_MAX_WAKE_S (6 * 60 * 60)
+
+struct __attribute__((packed)) BuzzhiveDownlink {
+    uint8_t magic;            // DOWNLINK_MAGIC
+    uint8_t hiveId;
+    uint16_t sequence;        // Report answered (BuzzhiveFeatureHeader::sequence)
+    uint8_t queenStatus;
+    uint8_t anomalyScore;
+    uint8_t flags;            // DOWNLINK_ALERT | DOWNLINK_SLOT
+    uint16_t wakeIntervalS;   // Next wake; 0 = the sensor's own schedule
+    uint32_t baseTimeMs;      // Base station clock at this downlink's start
+    uint32_t slotInMs;        // ... to the hive's next slot
+    uint8_t crc;              // CRC-8 of the bytes before it
+};
+
+inline void downlinkSeal(BuzzhiveDownlink& downlink) {
+    downlink.crc = transportCrc8((const uint8_t*)&downlink, sizeof(downlink) - 1);
+}
+
+// True if frame is the intact answer to this hive's report, with a
+// schedule the sensor may follow
+inline bool downlinkMatches(const BuzzhiveDownlink& downlink, int length,
+                            uint8_t hiveId, uint16_t sequence) {
+    if (length != (int)sizeof(BuzzhiveDownlink) || downlink.magic != DOWNLINK_MAGIC ||
+        downlink.hiveId != hiveId || downlink.sequence != sequence) {
+        return false;
+    }
+    if (transportCrc8((const uint8_t*)&downlink, sizeof(downlink) - 1) != downlink.crc) return false;
+    return downlink.wakeIntervalS == 0 ||
+           (downlink.wakeIntervalS >= DOWNLINK_MIN_WAKE_S && downlink.wakeIntervalS <= DOWNLINK_MAX_WAKE_S);
+}
+
+#endif // DOWNLINK_H
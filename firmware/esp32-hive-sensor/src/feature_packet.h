@@ -0,0 +1,138 @@
+/**
+ * Compact Feature Uplink
+ *
+ * Carries the 78 MFCC features in a LoRa-sized packet: each feature is
+ * standardized with the scaler from buzzhive_ml.h, clamped to
+ * +/-FEATURE_RANGE_SD standard deviations and stored as a signed code of
+ * `bits` bits (4-8), packed LSB first. Zero is exact and the code is
+ * symmetric, so the worst-case error is half a step (0.016 SD at 8 bits).
+ *
+ *   8 bits: 10 + 78 = 88 bytes    (float features: 318 bytes, over the
+ *   6 bits: 10 + 59 = 69 bytes     SX1276's 255-byte limit)
+ *
+ * The base station decodes straight into normalized model inputs.
+ *
+ * Shared by both firmwares: the base station includes this copy (see its
+ * platformio.ini). buzzhive_ml.h comes from models/ on the sensor.
+ */
+
+#ifndef FEATURE_PACKET_H
+#define FEATURE_PACKET_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "buzzhive_ml.h"
+
+// Bump when the encoding changes
+#define FEATURE_PACKET_VERSION 1
+
+// Clamp range of the standardized features (part of version 1)
+#define FEATURE_RANGE_SD 4.0f
+
+#define FEATURE_MIN_BITS 4
+#define FEATURE_MAX_BITS 8
+
+#define FEATURE_PAYLOAD_BYTES(bits) ((NUM_FEATURES * (bits) + 7) / 8)
+
+struct __attribute__((packed)) BuzzhiveFeatureHeader {
+    uint8_t version;          // FEATURE_PACKET_VERSION
+    uint8_t hiveId;
+    uint16_t sequence;        // Per-hive report counter, wraps
+    uint8_t bits;             // Bits per feature
+    int16_t temperature;      // x100 for 2 decimal precision
+    uint8_t humidity;
+    uint16_t batteryMv;
+};
+
+// Largest form (8 bits); shorter widths send fewer payload bytes
+struct __attribute__((packed)) BuzzhiveFeaturePacket {
+    BuzzhiveFeatureHeader header;
+    uint8_t payload[FEATURE_PAYLOAD_BYTES(FEATURE_MAX_BITS)];
+};
+
+// Bytes on air for a given width
+inline size_t featurePacketSize(uint8_t bits) {
+    return sizeof(BuzzhiveFeatureHeader) + FEATURE_PAYLOAD_BYTES(bits);
+}
+
+// Largest code magnitude: 127 at 8 bits, 7 at 4 bits
+inline int featureCodeMax(uint8_t bits) {
+    return (1 << (bits - 1)) - 1;
+}
+
+// Signed code of raw feature i: standardized, clamped and rounded
+inline int quantizeFeature(float raw, int i, uint8_t bits) {
+    int codeMax = featureCodeMax(bits);
+    float q = (raw - MEAN[i]) / SCALE[i] * (codeMax / FEATURE_RANGE_SD);
+    if (q > codeMax) q = (float)codeMax;
+    if (q < -codeMax) q = (float)-codeMax;
+    return q >= 0.0f ? (int)(q + 0.5f) : (int)(q - 0.5f);
+}
+
+// Normalized model input for a code
+inline float dequantizeFeature(int code, uint8_t bits) {
+    return code * (FEATURE_RANGE_SD / featureCodeMax(bits));
+}
+
+/**
+ * Standardize, quantize and pack raw features
+ *
+ * @param bits FEATURE_MIN_BITS..FEATURE_MAX_BITS
+ * @param payload FEATURE_PAYLOAD_BYTES(bits) bytes
+ */
+inline void encodeFeatures(const float* raw, uint8_t bits, uint8_t* payload) {
+    int codeMax = featureCodeMax(bits);
+    uint32_t acc = 0;
+    int accBits = 0;
+    size_t out = 0;
+    for (int i = 0; i < NUM_FEATURES; i++) {
+        int code = quantizeFeature(raw[i], i, bits);
+        acc |= (uint32_t)(code + codeMax) << accBits;   // Offset binary
+        accBits += bits;
+        while (accBits >= 8) {
+            payload[out++] = (uint8_t)acc;
+            acc >>= 8;
+            accBits -= 8;
+        }
+    }
+    if (accBits > 0) payload[out] = (uint8_t)acc;
+}
+
+/**
+ * Unpack features into normalized model inputs
+ *
+ * @return false if the width is unsupported or a code is out of range
+ */
+inline bool decodeFeatures(const uint8_t* payload, uint8_t bits, float* normalized) {
+    if (bits < FEATURE_MIN_BITS || bits > FEATURE_MAX_BITS) return false;
+    int codeMax = featureCodeMax(bits);
+    uint32_t mask = (1u << bits) - 1;
+    uint32_t acc = 0;
+    int accBits = 0;
+    size_t in = 0;
+    for (int i = 0; i < NUM_FEATURES; i++) {
+        while (accBits < bits) {
+            acc |= (uint32_t)payload[in++] << accBits;
+            accBits += 8;
+        }
+        int code = (int)(acc & mask) - codeMax;
+        acc >>= bits;
+        accBits -= bits;
+        if (code > codeMax) return false;
+        normalized[i] = dequantizeFeature(code, bits);
+    }
+    return true;
+}
+
+/**
+ * Validate a received packet's header against its length
+ *
+ * @param size Bytes received
+ */
+inline bool featurePacketValid(const BuzzhiveFeatureHeader& header, size_t size) {
+    return header.version == FEATURE_PACKET_VERSION &&
+           header.bits >= FEATURE_MIN_BITS && header.bits <= FEATURE_MAX_BITS &&
+           size == featurePacketSize(header.bits);
+}
+
+#endif // FEATURE_PACKET_H
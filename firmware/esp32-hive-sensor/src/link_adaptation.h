@@ -0,0 +1,208 @@
+/**
+ * Adaptive Spreading Factor and TX Power
+ *
+ * The base station advises each hive the fastest spreading factor, then
+ * the lowest TX power, that keeps a margin of SNR above the SX1276's
+ * demodulation floor on the worst of the hive's last LINK_HISTORY frames:
+ *
+ *   SF        7     8     9      10    11     12
+ *   SNR (dB)  -7.5  -10   -12.5  -15   -17.5  -20
+ *
+ * SNR is measured in the channel bandwidth, so it does not depend on the
+ * spreading factor; frames are normalized to LINK_POWER_MAX_DBM using the
+ * TX power the sensor reports with them. Settings travel as one byte in
+ * the transport header (TransportHeader::link): the sensor's own in data
+ * frames, the advice in ACKs. The sensor keeps them in RTC memory for
+ * its next wake; after LINK_FALLBACK_MISSES unacknowledged messages in a
+ * row it steps back towards full power and the slowest factor.
+ *
+ * One SX1276 demodulates a single spreading factor at a time, so the
+ * base station scans the range with channel activity detection (CAD) and
+ * sensors send a preamble long enough to span one scan
+ * (linkPreambleSymbols). Both ends must use the same range.
+ *
+ * Portable C++ (no Arduino dependencies). Shared by both firmwares: the
+ * base station includes this copy (see its platformio.ini).
+ */
+
+#ifndef LINK_ADAPTATION_H
+#define LINK_ADAPTATION_H
+
+#include <stdint.h>
+#include <string.h>
+
+// TX power range (PA_BOOST) and advice step; 17 dBm is the LoRa library default
+#define LINK_POWER_MIN_DBM 2
+#define LINK_POWER_MAX_DBM 17
+#define LINK_POWER_STEP_DB 3
+
+// Frames per hive the advice looks back over
+#define LINK_HISTORY 4
+
+// Messages without any ACK, in a row, before the sensor falls back a step
+#define LINK_FALLBACK_MISSES 2
+
+// CAD listens for about two symbols; the receiver then needs a few more
+// preamble symbols to lock; register writes between CAD steps
+#define LINK_CAD_SYMBOLS 2
+#define LINK_RX_LOCK_SYMBOLS 6
+#define LINK_CAD_OVERHEAD_US 1000
+
+struct __attribute__((packed)) LinkSettings {
+    uint8_t sf;
+    int8_t txPowerDbm;
+};
+
+// SX1276 demodulation floor
+inline float linkRequiredSnr(int sf) {
+    return 10.0f - 2.5f * sf;
+}
+
+// One-byte form for TransportHeader::link: SF-5 in the top 3 bits, dBm
+// in the low 5; 0 = no settings
+inline uint8_t linkEncode(LinkSettings settings) {
+    return (uint8_t)(((settings.sf - 5) << 5) | (settings.txPowerDbm & 0x1F));
+}
+
+inline bool linkDecode(uint8_t code, LinkSettings& settings) {
+    if (code == 0) return false;
+    settings.sf = (uint8_t)((code >> 5) + 5);
+    settings.txPowerDbm = (int8_t)(code & 0x1F);
+    return settings.sf >= 6 && settings.sf <= 12;
+}
+
+inline uint32_t linkSymbolUs(int sf, long bandwidthHz) {
+    return (uint32_t)((1ULL << sf) * 1000000ULL / (unsigned long)bandwidthHz);
+}
+
+// One CAD at each factor, fastest first
+inline uint32_t linkScanCycleUs(int minSf, int maxSf, long bandwidthHz) {
+    uint32_t us = 0;
+    for (int sf = minSf; sf <= maxSf; sf++) {
+        us += LINK_CAD_SYMBOLS * linkSymbolUs(sf, bandwidthHz) + LINK_CAD_OVERHEAD_US;
+    }
+    return us;
+}
+
+/**
+ * Preamble for frames at sf, so a scanning receiver finds them
+ *
+ * A preamble that starts just after its factor's CAD is caught one scan
+ * later and must still leave the receiver enough symbols to lock.
+ * Without a scan (minSf == maxSf) this is the library's 8 symbols.
+ */
+inline uint16_t linkPreambleSymbols(int sf, int minSf, int maxSf, long bandwidthHz) {
+    if (minSf >= maxSf) return 8;
+    uint32_t symbolUs = linkSymbolUs(sf, bandwidthHz);
+    uint32_t needUs = linkScanCycleUs(minSf, maxSf, bandwidthHz) +
+                      (LINK_CAD_SYMBOLS + LINK_RX_LOCK_SYMBOLS) * symbolUs;
+    uint32_t symbols = (needUs + symbolUs - 1) / symbolUs;
+    return (uint16_t)(symbols < 8 ? 8 : symbols);
+}
+
+// ============================================================================
+// Base Station: Per-Hive Advice
+// ============================================================================
+
+class LinkTracker {
+public:
+    /**
+     * @param minSf Fastest factor the receiver scans
+     * @param maxSf Slowest factor, used whenever nothing faster holds
+     * @param marginDb SNR kept above the floor (fading, interference)
+     */
+    void begin(int minSf, int maxSf, float marginDb) {
+        minSf_ = minSf;
+        maxSf_ = maxSf;
+        marginDb_ = marginDb;
+        memset(count_, 0, sizeof(count_));
+        memset(next_, 0, sizeof(next_));
+    }
+
+    /**
+     * Record a frame from a hive and advise its next settings
+     *
+     * @param used Settings the frame was sent with
+     * @param snr Packet SNR in dB
+     */
+    LinkSettings update(uint8_t hiveId, LinkSettings used, float snr) {
+        history_[hiveId][next_[hiveId]] = snr + (float)(LINK_POWER_MAX_DBM - used.txPowerDbm);
+        next_[hiveId] = (uint8_t)((next_[hiveId] + 1) % LINK_HISTORY);
+        if (count_[hiveId] < LINK_HISTORY) count_[hiveId]++;
+
+        float worst = history_[hiveId][0];
+        for (int i = 1; i < count_[hiveId]; i++) {
+            if (history_[hiveId][i] < worst) worst = history_[hiveId][i];
+        }
+        return advise(worst);
+    }
+
+    // Settings for a link with this SNR at full power
+    LinkSettings advise(float snrAtMaxPower) const {
+        LinkSettings settings;
+        settings.sf = (uint8_t)maxSf_;
+        settings.txPowerDbm = LINK_POWER_MAX_DBM;
+        for (int sf = minSf_; sf <= maxSf_; sf++) {
+            float spare = snrAtMaxPower - linkRequiredSnr(sf) - marginDb_;
+            if (spare < 0.0f) continue;
+            int power = LINK_POWER_MAX_DBM - (int)(spare / LINK_POWER_STEP_DB) * LINK_POWER_STEP_DB;
+            settings.sf = (uint8_t)sf;
+            settings.txPowerDbm = (int8_t)(power < LINK_POWER_MIN_DBM ? LINK_POWER_MIN_DBM : power);
+            break;
+        }
+        return settings;
+    }
+
+private:
+    int minSf_ = 7;
+    int maxSf_ = 10;
+    float marginDb_ = 5.0f;
+    float history_[256][LINK_HISTORY];  // SNR normalized to full power
+    uint8_t count_[256];
+    uint8_t next_[256];
+};
+
+// ============================================================================
+// Sensor: Settings Across Deep Sleep
+// ============================================================================
+
+// Keep in RTC memory
+struct LinkState {
+    LinkSettings settings;
+    uint8_t missedAcks;
+};
+
+/**
+ * An ACK came back: take the advice it carries, if any, within the scan
+ * range
+ */
+inline void linkAcknowledged(LinkState& state, uint8_t advice, int minSf, int maxSf) {
+    state.missedAcks = 0;
+    LinkSettings settings;
+    if (!linkDecode(advice, settings) || settings.sf < minSf || settings.sf > maxSf) return;
+    if (settings.txPowerDbm < LINK_POWER_MIN_DBM) settings.txPowerDbm = LINK_POWER_MIN_DBM;
+    if (settings.txPowerDbm > LINK_POWER_MAX_DBM) settings.txPowerDbm = LINK_POWER_MAX_DBM;
+    state.settings = settings;
+}
+
+/**
+ * A message got no ACK at all: every LINK_FALLBACK_MISSES in a row, go
+ * to full power, then one factor slower
+ *
+ * @return true if the settings changed
+ */
+inline bool linkMissed(LinkState& state, int maxSf) {
+    if (++state.missedAcks < LINK_FALLBACK_MISSES) return false;
+    state.missedAcks = 0;
+    if (state.settings.txPowerDbm < LINK_POWER_MAX_DBM) {
+        state.settings.txPowerDbm = LINK_POWER_MAX_DBM;
+        return true;
+    }
+    if (state.settings.sf < maxSf) {
+        state.settings.sf++;
+        return true;
+    }
+    return false;
+}
+
+#endif // LINK_ADAPTATION_H
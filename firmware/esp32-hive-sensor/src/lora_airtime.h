@@ -0,0 +1,40 @@
+/**
+ * LoRa Time-on-Air
+ *
+ * SX1276 datasheet formula (section 4.1.1.7) for explicit-header packets
+ * with CRC, as sent by the LoRa library. Low data rate optimization is
+ * assumed on whenever a symbol lasts longer than 16 ms (SF11/SF12 at
+ * 125 kHz), matching the library's automatic setting.
+ */
+
+#ifndef LORA_AIRTIME_H
+#define LORA_AIRTIME_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Time on air of one packet in microseconds
+ *
+ * @param payloadBytes Payload length
+ * @param sf Spreading factor (6-12)
+ * @param bandwidthHz Signal bandwidth, e.g. 125000
+ * @param codingRate Denominator of the 4/x coding rate (5-8)
+ * @param preambleSymbols Programmed preamble length (library default 8)
+ */
+inline uint32_t loraAirtimeUs(size_t payloadBytes, int sf, long bandwidthHz,
+                              int codingRate = 5, int preambleSymbols = 8) {
+    float symbolUs = (float)(1L << sf) * 1e6f / (float)bandwidthHz;
+    int lowDataRate = symbolUs > 16000.0f ? 1 : 0;
+
+    // 8*PL - 4*SF + 28 + 16 (CRC) - 0 (explicit header)
+    long bits = 8L * (long)payloadBytes - 4L * sf + 28 + 16;
+    long perBlock = 4L * (sf - 2 * lowDataRate);
+    long blocks = bits > 0 ? (bits + perBlock - 1) / perBlock : 0;
+    long payloadSymbols = 8 + blocks * codingRate;
+
+    float preambleUs = (preambleSymbols + 4.25f) * symbolUs;
+    return (uint32_t)(preambleUs + payloadSymbols * symbolUs + 0.5f);
+}
+
+#endif // LORA_AIRTIME_H
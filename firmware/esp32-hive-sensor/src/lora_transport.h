@@ -0,0 +1,456 @@
+/**
+ * LoRa Fragmentation Transport with Selective Acknowledgement
+ *
+ * Carries messages larger than one LoRa packet (255 bytes) - audio clips,
+ * float feature vectors - as up to 255 fragments:
+ *
+ *   [TransportHeader 10 bytes][payload: fragmentSize bytes, last one shorter]
+ *
+ * The sender transmits every fragment it believes missing and flags the
+ * last one with TRANSPORT_ACK_REQUEST. The receiver answers with a bitmap
+ * of the fragments it holds, and the next round resends only the gaps.
+ * If the ACK does not come, the sender polls with a single fragment
+ * rather than resending everything, since the ACK may be what was lost.
+ *
+ * The receiver reassembles into a fixed pool of slots, one message per
+ * hive; a completed message is remembered until its slot is reused, so a
+ * retransmission after a lost final ACK is re-acknowledged but not
+ * delivered twice. Slots idle for longer than the timeout are freed.
+ *
+ * Each header also carries one byte of link settings for adaptive data
+ * rate (link_adaptation.h): the sender's own in data frames, the
+ * receiver's advice in ACKs. The transport only passes it along.
+ *
+ * The radio is a template parameter so the same code runs over LoRa on
+ * the ESP32 and over a simulated lossy channel on a host
+ * (tools/transport_sim.cpp). A Radio provides:
+ *   void transmit(const uint8_t* frame, size_t length);
+ *   int receive(uint8_t* frame, size_t capacity, uint32_t timeoutMs);  // 0 on timeout
+ *   uint32_t nowMs();
+ *
+ * Portable C++ (no Arduino dependencies). Shared by both firmwares: the
+ * base station includes this copy (see its platformio.ini).
+ */
+
+#ifndef LORA_TRANSPORT_H
+#define LORA_TRANSPORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define TRANSPORT_MAGIC 0xB7
+#define TRANSPORT_MAX_FRAME 255
+#define TRANSPORT_MAX_FRAGMENTS 255
+#define TRANSPORT_BITMAP_BYTES ((TRANSPORT_MAX_FRAGMENTS + 7) / 8)
+
+// Frame kinds; the low bit of a data frame's kind asks for an ACK
+#define TRANSPORT_DATA 0x10
+#define TRANSPORT_ACK 0x20
+#define TRANSPORT_ACK_REQUEST 0x01
+
+// Application message types
+#define TRANSPORT_MSG_FEATURES_FULL 1   // BuzzhivePacketFull (78 floats)
+#define TRANSPORT_MSG_AUDIO_CLIP 2      // AudioClipInfo + ADPCM blocks
+#define TRANSPORT_MSG_FEATURES 3        // BuzzhiveFeaturePacket, for its ACK
+#define TRANSPORT_MSG_BATCH 4           // Batch of readings (report_batch.h)
+
+struct __attribute__((packed)) TransportHeader {
+    uint8_t magic;            // TRANSPORT_MAGIC
+    uint8_t kind;             // TRANSPORT_DATA [| TRANSPORT_ACK_REQUEST] or TRANSPORT_ACK
+    uint8_t hiveId;
+    uint8_t messageId;        // Per-hive message counter, wraps
+    uint8_t index;            // Fragment index (0 in an ACK)
+    uint8_t count;            // Fragments in the message
+    uint8_t fragmentSize;     // Payload bytes of every fragment but the last
+    uint8_t type;             // TRANSPORT_MSG_*
+    uint8_t link;             // Link settings or advice, 0 = none (see above)
+    uint8_t crc;              // CRC-8 of the bytes above
+};
+
+#define TRANSPORT_MAX_PAYLOAD (TRANSPORT_MAX_FRAME - sizeof(TransportHeader))
+
+// Largest message: 255 fragments of TRANSPORT_MAX_PAYLOAD bytes
+#define TRANSPORT_MAX_MESSAGE_BYTES (TRANSPORT_MAX_FRAGMENTS * TRANSPORT_MAX_PAYLOAD)
+
+// ============================================================================
+// Frame Helpers
+// ============================================================================
+
+// CRC-8, polynomial 0x07
+inline uint8_t transportCrc8(const uint8_t* data, size_t length) {
+    uint8_t crc = 0;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) crc = (uint8_t)((crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1);
+    }
+    return crc;
+}
+
+inline void transportSeal(TransportHeader& header) {
+    header.magic = TRANSPORT_MAGIC;
+    header.crc = transportCrc8((const uint8_t*)&header, sizeof(header) - 1);
+}
+
+/**
+ * Check that a received packet is a well-formed transport frame
+ *
+ * The header CRC keeps other packet formats that happen to start with
+ * TRANSPORT_MAGIC from being taken for transport frames.
+ */
+inline bool transportParse(const uint8_t* frame, size_t length, TransportHeader& header) {
+    if (length < sizeof(TransportHeader) || frame[0] != TRANSPORT_MAGIC) return false;
+    memcpy(&header, frame, sizeof(header));
+    if (transportCrc8(frame, sizeof(header) - 1) != header.crc) return false;
+    if (header.count == 0) return false;
+
+    size_t payload = length - sizeof(header);
+    if ((header.kind & ~TRANSPORT_ACK_REQUEST) == TRANSPORT_DATA) {
+        if (header.index >= header.count || header.fragmentSize == 0 || payload == 0) return false;
+        bool last = header.index == header.count - 1;
+        return last ? payload <= header.fragmentSize : payload == header.fragmentSize;
+    }
+    return header.kind == TRANSPORT_ACK && payload == (size_t)(header.count + 7) / 8;
+}
+
+inline bool bitmapGet(const uint8_t* bitmap, int i) { return (bitmap[i >> 3] >> (i & 7)) & 1; }
+inline void bitmapSet(uint8_t* bitmap, int i) { bitmap[i >> 3] |= (uint8_t)(1 << (i & 7)); }
+
+// ============================================================================
+// Sender
+// ============================================================================
+
+struct TransportSenderStats {
+    uint32_t messages;
+    uint32_t delivered;
+    uint32_t fragmentsSent;
+    uint32_t retransmissions;   // Fragments sent more than once
+    uint32_t acks;
+    uint32_t ackTimeouts;
+};
+
+class TransportSender {
+public:
+    /**
+     * @param fragmentSize Payload bytes per fragment (1-TRANSPORT_MAX_PAYLOAD);
+     *                     smaller fragments lose less per corrupted packet
+     * @param maxRounds Send/ACK rounds before giving up
+     * @param ackTimeoutMs Wait for an ACK after each round
+     */
+    void begin(uint8_t hiveId, uint8_t fragmentSize, uint8_t maxRounds, uint32_t ackTimeoutMs) {
+        hiveId_ = hiveId;
+        fragmentSize_ = fragmentSize > TRANSPORT_MAX_PAYLOAD ? TRANSPORT_MAX_PAYLOAD : fragmentSize;
+        maxRounds_ = maxRounds;
+        ackTimeoutMs_ = ackTimeoutMs;
+        memset(&stats_, 0, sizeof(stats_));
+    }
+
+    // Largest message at the configured fragment size
+    size_t maxMessage() const { return (size_t)TRANSPORT_MAX_FRAGMENTS * fragmentSize_; }
+
+    /**
+     * Send one message and wait until the receiver holds all of it
+     *
+     * @param messageId Must differ from the previous message's; keep the
+     *                  counter across deep sleep (RTC memory)
+     * @return true once acknowledged in full
+     */
+    template <class Radio>
+    bool send(Radio& radio, uint8_t messageId, uint8_t type, const uint8_t* data, size_t length) {
+        if (length == 0 || length > maxMessage()) return false;
+        int count = (int)((length + fragmentSize_ - 1) / fragmentSize_);
+        stats_.messages++;
+        ackLink_ = 0;
+
+        uint8_t missing[TRANSPORT_BITMAP_BYTES];
+        uint8_t sent[TRANSPORT_BITMAP_BYTES];
+        memset(missing, 0, sizeof(missing));
+        memset(sent, 0, sizeof(sent));
+        for (int i = 0; i < count; i++) bitmapSet(missing, i);
+
+        bool poll = false;
+        for (int round = 0; round < maxRounds_; round++) {
+            int last = count - 1;
+            while (!bitmapGet(missing, last)) last--;
+            for (int i = poll ? last : 0; i <= last; i++) {
+                if (!bitmapGet(missing, i)) continue;
+                if (bitmapGet(sent, i)) stats_.retransmissions++;
+                bitmapSet(sent, i);
+                sendFragment(radio, messageId, type, data, length, count, i, i == last);
+            }
+
+            if (!awaitAck(radio, messageId, count, missing)) {
+                stats_.ackTimeouts++;
+                poll = true;
+                continue;
+            }
+            stats_.acks++;
+            poll = false;
+            bool done = true;
+            for (int i = 0; i < count && done; i++) done = !bitmapGet(missing, i);
+            if (done) {
+                stats_.delivered++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Link settings sent in every data frame (link_adaptation.h)
+    void setLink(uint8_t link) { link_ = link; }
+
+    // Send/ACK rounds for the next messages, in place of begin()'s
+    void setMaxRounds(uint8_t maxRounds) { maxRounds_ = maxRounds; }
+
+    // Link byte of the last ACK for the last message, 0 if none came
+    uint8_t ackLink() const { return ackLink_; }
+
+    const TransportSenderStats& stats() const { return stats_; }
+
+private:
+    template <class Radio>
+    void sendFragment(Radio& radio, uint8_t messageId, uint8_t type, const uint8_t* data,
+                      size_t length, int count, int index, bool requestAck) {
+        uint8_t frame[TRANSPORT_MAX_FRAME];
+        TransportHeader header;
+        header.kind = TRANSPORT_DATA | (requestAck ? TRANSPORT_ACK_REQUEST : 0);
+        header.hiveId = hiveId_;
+        header.messageId = messageId;
+        header.index = (uint8_t)index;
+        header.count = (uint8_t)count;
+        header.fragmentSize = fragmentSize_;
+        header.type = type;
+        header.link = link_;
+        transportSeal(header);
+
+        size_t offset = (size_t)index * fragmentSize_;
+        size_t payload = length - offset < fragmentSize_ ? length - offset : fragmentSize_;
+        memcpy(frame, &header, sizeof(header));
+        memcpy(frame + sizeof(header), data + offset, payload);
+        radio.transmit(frame, sizeof(header) + payload);
+        stats_.fragmentsSent++;
+    }
+
+    // Wait for this message's ACK; clears the acknowledged bits of missing
+    template <class Radio>
+    bool awaitAck(Radio& radio, uint8_t messageId, int count, uint8_t* missing) {
+        uint32_t start = radio.nowMs();
+        uint32_t elapsed = 0;
+        while (elapsed < ackTimeoutMs_) {
+            uint8_t frame[TRANSPORT_MAX_FRAME];
+            int n = radio.receive(frame, sizeof(frame), ackTimeoutMs_ - elapsed);
+            if (n <= 0) return false;
+            elapsed = radio.nowMs() - start;
+
+            TransportHeader header;
+            if (!transportParse(frame, (size_t)n, header) || header.kind != TRANSPORT_ACK ||
+                header.hiveId != hiveId_ || header.messageId != messageId || header.count != count) {
+                continue;  // Someone else's traffic
+            }
+            ackLink_ = header.link;
+            const uint8_t* have = frame + sizeof(header);
+            for (int i = 0; i < count; i++) {
+                if (bitmapGet(have, i)) missing[i >> 3] &= (uint8_t)~(1 << (i & 7));
+            }
+            return true;
+        }
+        return false;
+    }
+
+    uint8_t hiveId_ = 0;
+    uint8_t fragmentSize_ = TRANSPORT_MAX_PAYLOAD;
+    uint8_t maxRounds_ = 8;
+    uint32_t ackTimeoutMs_ = 1000;
+    uint8_t link_ = 0;
+    uint8_t ackLink_ = 0;
+    TransportSenderStats stats_ = {};
+};
+
+// ============================================================================
+// Receiver
+// ============================================================================
+
+enum TransportResult {
+    TRANSPORT_PARTIAL,     // Stored (or a duplicate); message not complete yet
+    TRANSPORT_COMPLETE,    // message holds a newly completed message
+    TRANSPORT_REJECTED     // Not a data frame, too large, or no free slot
+};
+
+struct TransportMessage {
+    uint8_t hiveId;
+    uint8_t messageId;
+    uint8_t type;
+    const uint8_t* data;      // Valid until the next receive()
+    size_t length;
+};
+
+struct TransportReceiverStats {
+    uint32_t fragments;
+    uint32_t duplicates;
+    uint32_t delivered;
+    uint32_t rejected;
+    uint32_t dropped;         // Incomplete messages timed out or superseded
+};
+
+/**
+ * Reassembly into Slots fixed buffers of MaxMessage bytes each
+ */
+template <size_t Slots, size_t MaxMessage>
+class TransportReceiver {
+public:
+    void begin(uint32_t timeoutMs) {
+        timeoutMs_ = timeoutMs;
+        memset(&stats_, 0, sizeof(stats_));
+        for (size_t s = 0; s < Slots; s++) slots_[s].used = false;
+    }
+
+    /**
+     * Take one received frame
+     *
+     * @param ack Output buffer of TRANSPORT_MAX_FRAME bytes
+     * @param ackLength Set to the ACK's length if one should be sent now
+     *                  (before handling a completed message), else 0
+     * @param message Filled when the result is TRANSPORT_COMPLETE
+     * @param ackLink Link advice to put in the ACK (link_adaptation.h)
+     */
+    TransportResult receive(const uint8_t* frame, size_t length, uint32_t nowMs,
+                            uint8_t* ack, size_t& ackLength, TransportMessage& message,
+                            uint8_t ackLink = 0) {
+        ackLength = 0;
+        TransportHeader header;
+        if (!transportParse(frame, length, header) || (header.kind & ~TRANSPORT_ACK_REQUEST) != TRANSPORT_DATA ||
+            (size_t)header.count * header.fragmentSize > MaxMessage + header.fragmentSize - 1) {
+            stats_.rejected++;
+            return TRANSPORT_REJECTED;
+        }
+
+        Slot* slot = findSlot(header, nowMs);
+        if (!slot) {
+            stats_.rejected++;
+            return TRANSPORT_REJECTED;
+        }
+        stats_.fragments++;
+        slot->lastMs = nowMs;
+
+        TransportResult result = TRANSPORT_PARTIAL;
+        if (bitmapGet(slot->have, header.index)) {
+            stats_.duplicates++;
+        } else if (!slot->complete) {
+            size_t payload = length - sizeof(header);
+            size_t offset = (size_t)header.index * header.fragmentSize;
+            if (offset + payload > MaxMessage) {
+                stats_.rejected++;
+                return TRANSPORT_REJECTED;
+            }
+            memcpy(slot->data + offset, frame + sizeof(header), payload);
+            bitmapSet(slot->have, header.index);
+            slot->received++;
+            if (header.index == header.count - 1) slot->length = offset + payload;
+
+            if (slot->received == slot->count) {
+                slot->complete = true;
+                stats_.delivered++;
+                message.hiveId = slot->hiveId;
+                message.messageId = slot->messageId;
+                message.type = slot->type;
+                message.data = slot->data;
+                message.length = slot->length;
+                result = TRANSPORT_COMPLETE;
+            }
+        }
+
+        if (header.kind & TRANSPORT_ACK_REQUEST) {
+            TransportHeader reply = header;
+            reply.kind = TRANSPORT_ACK;
+            reply.index = 0;
+            reply.link = ackLink;
+            transportSeal(reply);
+            size_t bitmapBytes = (size_t)(slot->count + 7) / 8;
+            memcpy(ack, &reply, sizeof(reply));
+            memcpy(ack + sizeof(reply), slot->have, bitmapBytes);
+            ackLength = sizeof(reply) + bitmapBytes;
+        }
+        return result;
+    }
+
+    // Free slots idle for longer than the timeout
+    void expire(uint32_t nowMs) {
+        for (size_t s = 0; s < Slots; s++) {
+            Slot& slot = slots_[s];
+            if (slot.used && nowMs - slot.lastMs > timeoutMs_) {
+                if (!slot.complete) stats_.dropped++;
+                slot.used = false;
+            }
+        }
+    }
+
+    const TransportReceiverStats& stats() const { return stats_; }
+
+private:
+    struct Slot {
+        bool used;
+        bool complete;
+        uint8_t hiveId;
+        uint8_t messageId;
+        uint8_t type;
+        uint8_t count;
+        uint8_t fragmentSize;
+        uint16_t received;
+        size_t length;
+        uint32_t lastMs;
+        uint8_t have[TRANSPORT_BITMAP_BYTES];
+        uint8_t data[MaxMessage];
+    };
+
+    /**
+     * The hive's slot: its current message, or reset for a new one (the
+     * sender gave up on the old one). A new hive takes a free slot, else
+     * the least recently used slot that is complete or timed out; if every
+     * slot is busy the frame is dropped and the sender retries after its
+     * ACK timeout.
+     */
+    Slot* findSlot(const TransportHeader& header, uint32_t nowMs) {
+        Slot* slot = nullptr;
+        for (size_t s = 0; s < Slots && !slot; s++) {
+            if (slots_[s].used && slots_[s].hiveId == header.hiveId) slot = &slots_[s];
+        }
+        if (slot && slot->messageId == header.messageId) {
+            if (slot->count != header.count || slot->fragmentSize != header.fragmentSize ||
+                slot->type != header.type) {
+                return nullptr;  // Inconsistent with the fragments already held
+            }
+            return slot;
+        }
+        if (!slot) {
+            for (size_t s = 0; s < Slots; s++) {
+                Slot& candidate = slots_[s];
+                bool reusable = !candidate.used || candidate.complete ||
+                                nowMs - candidate.lastMs > timeoutMs_;
+                if (!reusable) continue;
+                if (!slot || !candidate.used || (slot->used && candidate.lastMs < slot->lastMs)) {
+                    slot = &candidate;
+                }
+            }
+            if (!slot) return nullptr;
+        }
+        if (slot->used && !slot->complete) stats_.dropped++;
+
+        slot->used = true;
+        slot->complete = false;
+        slot->hiveId = header.hiveId;
+        slot->messageId = header.messageId;
+        slot->type = header.type;
+        slot->count = header.count;
+        slot->fragmentSize = header.fragmentSize;
+        slot->received = 0;
+        slot->length = 0;
+        memset(slot->have, 0, sizeof(slot->have));
+        return slot;
+    }
+
+    Slot slots_[Slots];
+    uint32_t timeoutMs_ = 60000;
+    TransportReceiverStats stats_ = {};
+};
+
+#endif // LORA_TRANSPORT_H
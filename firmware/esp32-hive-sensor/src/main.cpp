@@ -15,13 +15,28 @@
 
 #include <Arduino.h>
 #include <driver/i2s.h>
+#include <time.h>
+#include <sys/time.h>
 #include <LoRa.h>
 #include <Wire.h>
 #include <Adafruit_SHT31.h>
 #include <ArduinoJson.h>
 #include "config.h"
 #include "mfcc.h"
+#include "audio_conditioning.h"
+#include "capture_pipeline.h"
+#include "activity_gate.h"
+#ifdef MFCC_FIXED_POINT
+#include "mfcc_fixed.h"
+#endif
 #include "audio_compression.h"
+#include "feature_packet.h"
+#include "lora_airtime.h"
+#include "lora_transport.h"
+#include "link_adaptation.h"
+#include "downlink.h"
+#include "report_batch.h"
+#include "slot_schedule.h"
 
 // ============================================================================
 // Configuration
@@ -33,7 +48,11 @@
 // Recording parameters
 #define SAMPLE_RATE 22050
 #define RECORD_DURATION_SEC 10
-#define AUDIO_BUFFER_SIZE (SAMPLE_RATE * RECORD_DURATION_SEC)
+#define AUDIO_CLIP_SAMPLES (SAMPLE_RATE * RECORD_DURATION_SEC)
+#define I2S_CHUNK_SAMPLES PIPELINE_BLOCK_SAMPLES
+
+// Capture -> extract ring depth (blocks of 512 samples, ~23 ms each)
+#define PIPELINE_RING_BLOCKS 16
 
 // Sleep intervals (milliseconds)
 #define ACTIVE_SEASON_INTERVAL_MS (15 * 60 * 1000)   // 15 minutes
@@ -56,9 +75,31 @@
 // ============================================================================
 
 Adafruit_SHT31 sht31 = Adafruit_SHT31();
-int16_t* audioBuffer = nullptr;
+#ifdef MFCC_FIXED_POINT
+MfccStreamQ15 mfccStream;
+#else
+MfccStream mfccStream;
+#endif
+AudioConditioner conditioner;
 float mfccFeatures[78];  // 13 MFCCs + 13 deltas + 13 delta-deltas * (mean + std)
 
+#ifdef USE_ACTIVITY_GATE
+ActivityGate activityGate;
+RTC_DATA_ATTR GateSignature gateSignature;   // Probe of the last full report
+GateDecision gateDecision = GATE_ACTIVE;
+#endif
+
+#ifdef USE_DOWNLINK
+// Schedule from the last answer (downlink.h), kept across deep sleep
+RTC_DATA_ATTR uint8_t downlinkFlags = 0;
+RTC_DATA_ATTR uint16_t downlinkWakeIntervalS = 0;
+RTC_DATA_ATTR uint8_t downlinkMisses = 0;     // Reports unanswered in a row
+
+bool alertMode() {
+    return (downlinkFlags & DOWNLINK_ALERT) != 0;
+}
+#endif
+
 // Transmission packet structure
 struct __attribute__((packed)) BuzzhivePacket {
     uint8_t hiveId;
@@ -71,6 +112,15 @@ struct __attribute__((packed)) BuzzhivePacket {
     uint8_t featureHash[4];   // Quick hash of MFCC features for validation
 };
 
+// Sent instead of a full report when the activity gate skips a cycle
+struct __attribute__((packed)) BuzzhiveHeartbeat {
+    uint8_t hiveId;
+    uint8_t gateStatus;       // GateDecision: 2 = silent, 3 = unchanged
+    int16_t temperature;      // x100 for 2 decimal precision
+    uint8_t humidity;
+    uint16_t batteryMv;
+};
+
 // ============================================================================
 // I2S Microphone Setup
 // ============================================================================
@@ -105,30 +155,219 @@ void setupI2S() {
 // Audio Recording
 // ============================================================================
 
+#ifdef USE_AUDIO_CLIP_UPLINK
+
+#define AUDIO_CLIP_BLOCKS ADPCM_CLIP_BLOCKS(AUDIO_CLIP_SAMPLE_RATE * AUDIO_CLIP_SEC)
+
+// AudioClipInfo, then the blocks as the encoder writes them
+static uint8_t clipMessage[sizeof(AudioClipInfo) + AUDIO_CLIP_BLOCKS * ADPCM_BLOCK_BYTES];
+AudioClipEncoder clipEncoder;
+bool clipRecording = false;
+RTC_DATA_ATTR uint16_t reportsSinceClip = AUDIO_CLIP_EVERY_N_REPORTS - 1;  // First report sends one
+RTC_DATA_ATTR uint8_t clipId = 0;
+
+// Start compressing the raw audio if this cycle's report carries a clip
+void beginAudioClip() {
+    clipRecording = reportsSinceClip + 1 >= AUDIO_CLIP_EVERY_N_REPORTS;
+    if (clipRecording) {
+        clipEncoder.begin(SAMPLE_RATE, AUDIO_CLIP_SAMPLE_RATE,
+                          clipMessage + sizeof(AudioClipInfo), AUDIO_CLIP_BLOCKS);
+    }
+}
+
+#endif // USE_AUDIO_CLIP_UPLINK
+
+// Condition one block and fold it into the running MFCC statistics
+static void processAudioBlock(int16_t* samples, size_t count) {
+#ifdef USE_AUDIO_CLIP_UPLINK
+    // Raw audio, before conditioning rewrites the block in place
+    if (clipRecording) clipEncoder.push(samples, count);
+#endif
+    conditioner.process(samples, count);
+#ifdef USE_ACTIVITY_GATE
+    activityGate.addSamples(samples, count);
+#endif
+    mfccStream.push(samples, count);
+}
+
+#ifdef USE_ACTIVITY_GATE
+
+void beginActivityGate() {
+    gateDecision = GATE_PENDING;
+    activityGate.begin((GATE_PROBE_MS * SAMPLE_RATE / 1000) / HOP_LENGTH);
+}
+
+/**
+ * Check the probe once it is ready
+ * 
+ * @return true if recording should stop early (nothing new to report)
+ */
+bool activityGateSaysStop() {
+    if (gateDecision != GATE_PENDING || !activityGate.ready()) return false;
+    
+    gateDecision = activityGate.evaluate(gateSignature, GATE_SILENCE_DBFS,
+                                         GATE_CHANGE_DB, GATE_FLUX_RATIO);
+    const GateSignature& sig = activityGate.signature();
+    Serial.printf("🚦 Gate: %.1f dBFS, flux %.2f -> %s\n", sig.rmsDb, sig.flux,
+                  gateDecision == GATE_SILENT ? "silent" :
+                  gateDecision == GATE_UNCHANGED ? "unchanged" : "active");
+    
+    if (gateDecision != GATE_ACTIVE && gateSignature.skippedCycles >= GATE_MAX_SKIPPED_CYCLES) {
+        Serial.println("   Skip limit reached, forcing full report");
+        gateDecision = GATE_ACTIVE;
+    }
+#ifdef USE_DOWNLINK
+    if (gateDecision != GATE_ACTIVE && alertMode()) {
+        Serial.println("   Alert mode, forcing full report");
+        gateDecision = GATE_ACTIVE;
+    }
+#endif
+    return gateDecision != GATE_ACTIVE;
+}
+
+#endif // USE_ACTIVITY_GATE
+
+#ifdef USE_CAPTURE_PIPELINE
+
+CapturePipeline<PIPELINE_RING_BLOCKS> capturePipeline;
+TaskHandle_t extractTaskHandle = NULL;
+TaskHandle_t captureTaskHandle = NULL;
+
+// Extraction task: drains the ring on the other core until capture ends
+void extractTask(void* param) {
+    while (!capturePipeline.finished()) {
+        if (!capturePipeline.consumeOne(processAudioBlock)) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(5));
+        }
+    }
+    xTaskNotifyGive(captureTaskHandle);
+    vTaskDelete(NULL);
+}
+
+/**
+ * Record a clip while the extraction task computes MFCCs on the other core
+ * 
+ * This (loop) task only moves DMA blocks into the ring; by the time the
+ * last block is read, all but the last few frames are already done.
+ */
+bool recordAudio() {
+    Serial.println("🎤 Recording audio (pipelined)...");
+    
+    size_t bytesRead = 0;
+    size_t totalSamples = 0;
+    bool ok = true;
+    
+    mfccStream.begin(SAMPLE_RATE);
+    conditioner.begin();
+    capturePipeline.begin();
+#ifdef USE_ACTIVITY_GATE
+    beginActivityGate();
+#endif
+#ifdef USE_AUDIO_CLIP_UPLINK
+    beginAudioClip();
+#endif
+    captureTaskHandle = xTaskGetCurrentTaskHandle();
+    xTaskCreatePinnedToCore(extractTask, "mfcc", 8192, NULL, 2,
+                            &extractTaskHandle, EXTRACT_TASK_CORE);
+    
+    unsigned long startTime = millis();
+    
+    while (totalSamples < AUDIO_CLIP_SAMPLES) {
+        // Timeout protection
+        if (millis() - startTime > (RECORD_DURATION_SEC + 2) * 1000) {
+            Serial.println("⚠️ Recording timeout");
+            ok = false;
+            break;
+        }
+        
+        AudioBlock* block = capturePipeline.beginWrite();
+        if (!block) {
+            // Extraction is a full ring behind; DMA buffers absorb the wait
+            vTaskDelay(1);
+            continue;
+        }
+        
+        size_t toRead = min((size_t)I2S_CHUNK_SAMPLES, AUDIO_CLIP_SAMPLES - totalSamples) * 2;
+        i2s_read(I2S_PORT, block->samples, toRead, &bytesRead, portMAX_DELAY);
+        block->count = bytesRead / 2;
+        capturePipeline.commitWrite();
+        xTaskNotifyGive(extractTaskHandle);
+        totalSamples += block->count;
+        
+#ifdef USE_ACTIVITY_GATE
+        // Nothing new in the probe: stop recording early
+        if (activityGateSaysStop()) break;
+#endif
+    }
+    
+    capturePipeline.endCapture();
+    xTaskNotifyGive(extractTaskHandle);
+    
+    // Wait for the extraction task to drain the ring and exit
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    
+    if (ok) {
+        Serial.printf("✅ Recorded %d samples in %lu ms (ring max depth %lu, stalls %lu)\n",
+                      totalSamples, millis() - startTime,
+                      (unsigned long)capturePipeline.maxDepth(),
+                      (unsigned long)capturePipeline.producerStalls());
+    }
+    return ok;
+}
+
+#else
+
+/**
+ * Record a clip and feed it to the MFCC extractor as it arrives
+ * 
+ * Only one I2S chunk is held in RAM; frames are processed while the next
+ * DMA buffers fill, so extraction overlaps capture.
+ */
 bool recordAudio() {
     Serial.println("🎤 Recording audio...");
     
+    int16_t chunk[I2S_CHUNK_SAMPLES];
     size_t bytesRead = 0;
     size_t totalSamples = 0;
     
+    mfccStream.begin(SAMPLE_RATE);
+    conditioner.begin();
+#ifdef USE_ACTIVITY_GATE
+    beginActivityGate();
+#endif
+#ifdef USE_AUDIO_CLIP_UPLINK
+    beginAudioClip();
+#endif
+    
     unsigned long startTime = millis();
     
-    while (totalSamples < AUDIO_BUFFER_SIZE) {
-        size_t toRead = min((size_t)1024, (AUDIO_BUFFER_SIZE - totalSamples) * 2);
-        i2s_read(I2S_PORT, &audioBuffer[totalSamples], toRead, &bytesRead, portMAX_DELAY);
-        totalSamples += bytesRead / 2;
+    while (totalSamples < AUDIO_CLIP_SAMPLES) {
+        size_t toRead = min((size_t)I2S_CHUNK_SAMPLES, AUDIO_CLIP_SAMPLES - totalSamples) * 2;
+        i2s_read(I2S_PORT, chunk, toRead, &bytesRead, portMAX_DELAY);
+        size_t n = bytesRead / 2;
+        
+        // DC removal + pre-emphasis + peak tracking in one pass
+        processAudioBlock(chunk, n);
+        totalSamples += n;
         
         // Timeout protection
         if (millis() - startTime > (RECORD_DURATION_SEC + 2) * 1000) {
             Serial.println("⚠️ Recording timeout");
             return false;
         }
+        
+#ifdef USE_ACTIVITY_GATE
+        // Nothing new in the probe: stop recording early
+        if (activityGateSaysStop()) break;
+#endif
     }
     
     Serial.printf("✅ Recorded %d samples in %lu ms\n", totalSamples, millis() - startTime);
     return true;
 }
 
+#endif // USE_CAPTURE_PIPELINE
+
 // ============================================================================
 // MFCC Feature Extraction
 // ============================================================================
@@ -136,32 +375,108 @@ bool recordAudio() {
 void extractMFCCFeatures() {
     Serial.println("🔢 Extracting MFCC features...");
     
-    // Apply pre-emphasis filter
-    for (int i = AUDIO_BUFFER_SIZE - 1; i > 0; i--) {
-        audioBuffer[i] = audioBuffer[i] - 0.97 * audioBuffer[i - 1];
-    }
+    // Frames were computed during recording; flush the tail and aggregate.
+    // Peak normalization is a constant gain, applied in the log-mel domain.
+    mfccStream.finish(mfccFeatures, conditioner.gain());
     
-    // Normalize audio
-    int16_t maxVal = 0;
-    for (int i = 0; i < AUDIO_BUFFER_SIZE; i++) {
-        if (abs(audioBuffer[i]) > maxVal) maxVal = abs(audioBuffer[i]);
+    Serial.printf("✅ MFCC extraction complete (%d frames)\n", mfccStream.frameCount());
+}
+
+// ============================================================================
+// LoRa Transmission
+// ============================================================================
+
+// LoRa behind the Radio interface of lora_transport.h
+class LoRaRadio {
+public:
+    void transmit(const uint8_t* frame, size_t length) {
+        uint32_t start = millis();
+        LoRa.beginPacket();
+        LoRa.write(frame, length);
+        LoRa.endPacket();
+        txEndMs_ = millis();
+        txMs_ += txEndMs_ - start;
     }
-    if (maxVal > 0) {
-        for (int i = 0; i < AUDIO_BUFFER_SIZE; i++) {
-            audioBuffer[i] = (audioBuffer[i] * 32767) / maxVal;
+    
+    int receive(uint8_t* frame, size_t capacity, uint32_t timeoutMs) {
+        uint32_t start = millis();
+        int n = 0;
+        while (millis() - start < timeoutMs) {
+            if (LoRa.parsePacket() > 0) {
+                while (LoRa.available() && n < (int)capacity) frame[n++] = LoRa.read();
+                break;
+            }
+            delay(1);
         }
+        rxMs_ += millis() - start;
+        return n;
     }
     
-    // Extract MFCCs using our lightweight library
-    // This computes 13 MFCCs per frame, then aggregates
-    extractMFCC(audioBuffer, AUDIO_BUFFER_SIZE, SAMPLE_RATE, mfccFeatures);
+    uint32_t nowMs() { return millis(); }
+    
+    // Radio-on time this wake, and when the last frame finished sending
+    uint32_t txMs() const { return txMs_; }
+    uint32_t rxMs() const { return rxMs_; }
+    uint32_t txEndMs() const { return txEndMs_; }
     
-    Serial.println("✅ MFCC extraction complete");
+private:
+    uint32_t txMs_ = 0;
+    uint32_t rxMs_ = 0;
+    uint32_t txEndMs_ = 0;
+};
+
+LoRaRadio loraRadio;
+TransportSender transport;
+RTC_DATA_ATTR uint8_t transportMessageId = 0;   // Survives deep sleep
+uint8_t loraSpreadingFactor = LORA_SPREADING_FACTOR;
+uint16_t loraPreamble = 8;
+
+#ifdef USE_ADAPTIVE_LINK
+// Spreading factor and TX power advised by the base station
+RTC_DATA_ATTR LinkState linkState = {{LORA_SPREADING_FACTOR, LINK_POWER_MAX_DBM}, 0};
+
+// Keep the base station's advice, or fall back after missed ACKs; both
+// take effect at the next wake
+void updateLink(bool acknowledged) {
+    LinkSettings before = linkState.settings;
+    if (acknowledged) {
+        linkAcknowledged(linkState, transport.ackLink(), LINK_SF_MIN, LINK_SF_MAX);
+    } else {
+        linkMissed(linkState, LINK_SF_MAX);
+    }
+    if (linkState.settings.sf != before.sf || linkState.settings.txPowerDbm != before.txPowerDbm) {
+        Serial.printf("📶 Link: SF%d/%d dBm -> SF%d/%d dBm (%s)\n",
+                      before.sf, before.txPowerDbm, linkState.settings.sf,
+                      linkState.settings.txPowerDbm, acknowledged ? "advised" : "no ACK");
+    }
 }
+#endif
 
-// ============================================================================
-// LoRa Transmission
-// ============================================================================
+/**
+ * Send a message of any size up to 255 fragments, resending lost
+ * fragments until the base station acknowledges all of them
+ */
+bool transmitMessage(uint8_t type, const uint8_t* data, size_t length) {
+    uint32_t before = transport.stats().fragmentsSent;
+    uint32_t retx = transport.stats().retransmissions;
+#ifdef USE_ADAPTIVE_LINK
+    uint32_t acks = transport.stats().acks;
+#endif
+    unsigned long start = millis();
+    
+    transport.setMaxRounds(length <= TRANSPORT_FRAGMENT_BYTES ? TRANSPORT_REPORT_ROUNDS : TRANSPORT_MAX_ROUNDS);
+    bool ok = transport.send(loraRadio, transportMessageId++, type, data, length);
+#ifdef USE_ADAPTIVE_LINK
+    updateLink(transport.stats().acks != acks);
+#endif
+    
+    Serial.printf("%s Message %d bytes: %lu fragments (%lu resent) in %lu ms\n",
+                  ok ? "✅" : "❌", (int)length,
+                  (unsigned long)(transport.stats().fragmentsSent - before),
+                  (unsigned long)(transport.stats().retransmissions - retx),
+                  millis() - start);
+    return ok;
+}
 
 void setupLoRa() {
     LoRa.setPins(LORA_SS, LORA_RST, LORA_DIO0);
@@ -172,11 +487,24 @@ void setupLoRa() {
     }
     
     // Optimize for range (low data rate)
-    LoRa.setSpreadingFactor(10);
-    LoRa.setSignalBandwidth(125E3);
+    LoRa.setSignalBandwidth(LORA_BANDWIDTH);
     LoRa.setCodingRate4(5);
+#ifdef USE_ADAPTIVE_LINK
+    // As advised at the last wake; the preamble spans the base station's scan
+    loraSpreadingFactor = linkState.settings.sf;
+    loraPreamble = linkPreambleSymbols(loraSpreadingFactor, LINK_SF_MIN, LINK_SF_MAX, LORA_BANDWIDTH);
+    LoRa.setTxPower(linkState.settings.txPowerDbm);
+    LoRa.setPreambleLength(loraPreamble);
+    transport.setLink(linkEncode(linkState.settings));
+#endif
+    LoRa.setSpreadingFactor(loraSpreadingFactor);
     
-    Serial.println("✅ LoRa initialized");
+    transport.begin(HIVE_ID, TRANSPORT_FRAGMENT_BYTES, TRANSPORT_MAX_ROUNDS,
+                    loraAirtimeUs(sizeof(TransportHeader) + TRANSPORT_BITMAP_BYTES,
+                                  loraSpreadingFactor, LORA_BANDWIDTH, 5, loraPreamble) / 1000 +
+                    TRANSPORT_ACK_MARGIN_MS);
+    
+    Serial.printf("✅ LoRa initialized (SF%d)\n", loraSpreadingFactor);
 }
 
 void transmitData(uint8_t queenStatus, uint8_t anomalyScore) {
@@ -205,6 +533,312 @@ void transmitData(uint8_t queenStatus, uint8_t anomalyScore) {
     Serial.println("✅ Transmission complete");
 }
 
+#ifdef USE_FEATURE_UPLINK
+
+RTC_DATA_ATTR uint16_t uplinkSequence = 0;   // Survives deep sleep
+
+#ifdef USE_DOWNLINK
+// Radio and CPU asleep (light sleep) until the RTC timer wakes them
+void radioLightSleep(uint64_t us) {
+    LoRa.sleep();
+    Serial.flush();
+    esp_sleep_enable_timer_wakeup(us);
+    esp_light_sleep_start();
+    LoRa.idle();
+}
+#endif
+
+#ifdef USE_TDMA
+
+// This hive's report slot (slot_schedule.h), kept across deep sleep;
+// reports go out at random until two downlinks have timed the clock
+RTC_DATA_ATTR SlotState slotState = {0, 0, 0, 0, 0, 0, 0};
+RTC_DATA_ATTR uint32_t slotLeadMs = AUDIO_DURATION_SEC * 1000 + TDMA_WAKE_GUARD_MS;
+bool slotWaited = false;    // This wake's first report held for the slot
+
+// RTC clock (us), counting on through deep sleep
+int64_t rtcNowUs() {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_usec;
+}
+
+/**
+ * Hold this wake's first report until the hive's slot starts; without a
+ * slot, or between slots (alert mode), it goes at once
+ * 
+ * Wake to ready sets how early the next slot wake comes.
+ */
+void waitForSlot() {
+    if (slotState.slotAtUs == 0 || slotState.between || slotWaited) return;
+    slotWaited = true;
+    slotLeadMs = slotLead(slotLeadMs, millis(), TDMA_WAKE_GUARD_MS);
+    
+    int64_t waitUs = slotState.slotAtUs - rtcNowUs();
+    if (waitUs < 0) {
+        Serial.printf("⏰ Report ready %ld ms into its slot\n", (long)(-waitUs / 1000));
+        return;
+    }
+    Serial.printf("⏳ Waiting %ld ms for the slot\n", (long)(waitUs / 1000));
+    radioLightSleep((uint64_t)waitUs);
+}
+
+#endif // USE_TDMA
+
+/**
+ * Send the quantized MFCC features for classification at the base station
+ */
+void transmitFeatures() {
+    BuzzhiveFeaturePacket packet;
+    packet.header.version = FEATURE_PACKET_VERSION;
+    packet.header.hiveId = HIVE_ID;
+    packet.header.sequence = uplinkSequence++;
+    packet.header.bits = FEATURE_BITS;
+    packet.header.temperature = (int16_t)(sht31.readTemperature() * 100);
+    packet.header.humidity = (uint8_t)sht31.readHumidity();
+    packet.header.batteryMv = analogRead(A0) * 2;  // Assuming voltage divider
+    encodeFeatures(mfccFeatures, FEATURE_BITS, packet.payload);
+    
+    size_t size = featurePacketSize(FEATURE_BITS);
+    Serial.printf("📡 Transmitting features: #%u, %d bytes (%d-bit), ~%lu ms on air\n",
+                  packet.header.sequence, (int)size, FEATURE_BITS,
+                  (unsigned long)(loraAirtimeUs(size, loraSpreadingFactor, LORA_BANDWIDTH) / 1000));
+    
+#ifdef USE_TDMA
+    waitForSlot();
+#endif
+#ifdef USE_ADAPTIVE_LINK
+    // Acknowledged, so the ACK can bring link advice back
+    transmitMessage(TRANSPORT_MSG_FEATURES, (uint8_t*)&packet, size);
+#else
+    loraRadio.transmit((uint8_t*)&packet, size);
+    
+    Serial.println("✅ Transmission complete");
+#endif
+}
+
+#ifdef USE_DOWNLINK
+
+/**
+ * Listen for the base station's answer to the report just sent
+ * 
+ * @param sequence The report's (the newest reading's, for a batch)
+ * 
+ * The radio sleeps through the base station's inference (light sleep
+ * for the CPU too), then listens for one downlink's time on air plus
+ * the margins. Without an answer the last schedule stands, for up to
+ * DOWNLINK_MAX_MISSES reports; then the sensor goes back to its own.
+ */
+void receiveDownlink(uint16_t sequence) {
+    uint32_t airtimeMs = loraAirtimeUs(sizeof(BuzzhiveDownlink), loraSpreadingFactor,
+                                       LORA_BANDWIDTH, 5, loraPreamble) / 1000;
+    uint32_t openAt = loraRadio.txEndMs() + DOWNLINK_DELAY_MS - DOWNLINK_WINDOW_MARGIN_MS;
+    uint32_t windowMs = airtimeMs + 2 * DOWNLINK_WINDOW_MARGIN_MS;
+    
+    int32_t waitMs = (int32_t)(openAt - millis());
+    if (waitMs > 0) {
+        radioLightSleep((uint64_t)waitMs * 1000ULL);
+    }
+    
+    // Other hives' frames may land in the window too
+    BuzzhiveDownlink downlink;
+    uint32_t start = millis();
+    bool received = false;
+    while (!received && millis() - start < windowMs) {
+        int length = loraRadio.receive((uint8_t*)&downlink, sizeof(downlink),
+                                       windowMs - (millis() - start));
+        received = downlinkMatches(downlink, length, HIVE_ID, sequence);
+    }
+    LoRa.sleep();
+    if (!received) {
+        Serial.printf("📭 No downlink in %lu ms window\n", (unsigned long)windowMs);
+#ifdef USE_TDMA
+        slotMissed(slotState);
+#endif
+        if (++downlinkMisses >= DOWNLINK_MAX_MISSES && (downlinkFlags != 0 || downlinkWakeIntervalS != 0)) {
+            Serial.println("   Base station silent, back to own schedule");
+            downlinkFlags = 0;
+            downlinkWakeIntervalS = 0;
+        }
+        return;
+    }
+    downlinkMisses = 0;
+#ifdef USE_TDMA
+    // A slot is always less than a cycle away
+    if ((downlink.flags & DOWNLINK_SLOT) && downlink.slotInMs >= TDMA_CYCLE_MS) {
+        Serial.printf("⚠️ Slot %lu ms away is past the cycle, ignored\n", (unsigned long)downlink.slotInMs);
+        downlink.flags &= ~DOWNLINK_SLOT;
+    }
+    if (downlink.flags & DOWNLINK_SLOT) {
+        // Time reference: the downlink started one time on air ago
+        slotSync(slotState, rtcNowUs() - (int64_t)airtimeMs * 1000, downlink.baseTimeMs,
+                 downlink.slotInMs);
+        if (slotState.timed) {
+            Serial.printf("🕐 Slot in %lu ms, clock %+ld ppm\n",
+                          (unsigned long)downlink.slotInMs, (long)slotState.driftPpm);
+        } else {
+            Serial.println("🕐 First time reference; slotted from the next downlink");
+        }
+    }
+#endif
+    
+    downlinkFlags = downlink.flags;
+    downlinkWakeIntervalS = downlink.wakeIntervalS;
+    Serial.printf("📬 Base station: %s, anomaly %d%s\n", STATUS_NAMES[downlink.queenStatus & 3],
+                  downlink.anomalyScore, (downlink.flags & DOWNLINK_ALERT) ? ", ALERT MODE" : "");
+}
+
+#endif // USE_DOWNLINK
+
+#ifdef USE_REPORT_BATCH
+
+// Readings waiting to be sent (report_batch.h), kept across deep sleep;
+// time() keeps counting through deep sleep on the RTC clock
+RTC_DATA_ATTR BatchReading batchReadings[REPORT_BATCH_READINGS];
+RTC_DATA_ATTR uint8_t batchCount = 0;
+RTC_DATA_ATTR uint16_t batchSequence = 0;        // First reading's
+RTC_DATA_ATTR int16_t lastReadingTemperature = INT16_MIN;
+uint8_t batchFrame[BATCH_MAX_BYTES];
+
+/**
+ * Send the oldest count readings as one frame
+ * 
+ * @return The newest reading's sequence
+ */
+uint16_t sendBatch(int count) {
+    size_t length = batchEncode(batchReadings, count, HIVE_ID, batchSequence, REPORT_BATCH_FEATURE_BITS,
+                                (uint32_t)time(NULL), batchFrame, sizeof(batchFrame));
+    uint16_t newest = (uint16_t)(batchSequence + count - 1);
+    Serial.printf("📦 Transmitting batch #%u-#%u: %d readings, %d bytes, ~%lu ms on air\n",
+                  batchSequence, newest, count, (int)length,
+                  (unsigned long)(loraAirtimeUs(length, loraSpreadingFactor, LORA_BANDWIDTH) / 1000));
+    
+#ifdef USE_TDMA
+    waitForSlot();
+#endif
+#ifdef USE_ADAPTIVE_LINK
+    transmitMessage(TRANSPORT_MSG_BATCH, batchFrame, length);
+#else
+    loraRadio.transmit(batchFrame, length);
+#endif
+    
+    // Not kept for a retry: the next batch carries newer readings
+    batchCount -= count;
+    memmove(batchReadings, batchReadings + count, batchCount * sizeof(BatchReading));
+    batchSequence += count;
+    return newest;
+}
+
+/**
+ * Keep this wake's reading and send the batch when it is full or on an
+ * alert (downlink alert mode, a jump in hive temperature). A reading
+ * that would overflow the frame goes in the next batch.
+ * 
+ * @param status GateDecision; GATE_ACTIVE readings carry the features
+ */
+void addBatchReading(uint8_t status) {
+    if (batchCount == 0) batchSequence = uplinkSequence;
+    uplinkSequence++;
+    
+    BatchReading& reading = batchReadings[batchCount++];
+    reading.timeS = (uint32_t)time(NULL);
+    reading.temperature = (int16_t)(sht31.readTemperature() * 100);
+    reading.humidity = (uint8_t)sht31.readHumidity();
+    reading.batteryMv = analogRead(A0) * 2;  // Assuming voltage divider
+    reading.status = status;
+    reading.flags = status == GATE_ACTIVE ? READING_FEATURES : 0;
+    if (reading.flags) {
+        for (int i = 0; i < NUM_FEATURES; i++) {
+            reading.codes[i] = (int8_t)quantizeFeature(mfccFeatures[i], i, REPORT_BATCH_FEATURE_BITS);
+        }
+    }
+    
+    bool alert = lastReadingTemperature != INT16_MIN &&
+                 abs(reading.temperature - lastReadingTemperature) >= REPORT_BATCH_ALERT_TEMP_C * 100;
+    lastReadingTemperature = reading.temperature;
+#ifdef USE_DOWNLINK
+    alert = alert || alertMode();
+#endif
+    
+    int newest = -1;   // Sequence of the newest reading sent
+    bool fits = batchEncode(batchReadings, batchCount, HIVE_ID, batchSequence, REPORT_BATCH_FEATURE_BITS,
+                            reading.timeS, batchFrame, sizeof(batchFrame)) > 0;
+    if (!fits && batchCount > 1) {
+        newest = sendBatch(batchCount - 1);
+    }
+    if (batchCount >= REPORT_BATCH_READINGS || alert) {
+        if (alert) Serial.println("🚨 Alert: sending the batch now");
+        newest = sendBatch(batchCount);
+    }
+    if (newest < 0) {
+        Serial.printf("📦 Reading #%u kept (%d/%d)\n", (uint16_t)(uplinkSequence - 1),
+                      batchCount, REPORT_BATCH_READINGS);
+        return;
+    }
+#ifdef USE_DOWNLINK
+    receiveDownlink((uint16_t)newest);
+#endif
+}
+
+#endif // USE_REPORT_BATCH
+
+#endif // USE_FEATURE_UPLINK
+
+#ifdef USE_AUDIO_CLIP_UPLINK
+
+/**
+ * Send the clip compressed during recording as one transport message
+ * 
+ * Counts full reports between clips; a cycle without a clip only bumps
+ * the counter.
+ */
+void transmitAudioClip() {
+    if (!clipRecording) {
+        reportsSinceClip++;
+        return;
+    }
+    clipRecording = false;
+    clipEncoder.finish();
+    
+    AudioClipInfo info;
+    info.clipId = clipId;
+    info.blockCount = (uint16_t)clipEncoder.blockCount();
+    info.sampleRate = (uint16_t)clipEncoder.sampleRate();
+    memcpy(clipMessage, &info, sizeof(info));
+    
+    Serial.printf("🎵 Transmitting clip #%d: %lu samples at %d Hz, %d bytes\n",
+                  clipId, (unsigned long)clipEncoder.sampleCount(), clipEncoder.sampleRate(),
+                  (int)(sizeof(info) + clipEncoder.bytes()));
+    
+    transmitMessage(TRANSPORT_MSG_AUDIO_CLIP, clipMessage, sizeof(info) + clipEncoder.bytes());
+    
+    // Not retried next cycle: a clip is a sample, not a report
+    reportsSinceClip = 0;
+    clipId++;
+}
+
+#endif // USE_AUDIO_CLIP_UPLINK
+
+#ifdef USE_ACTIVITY_GATE
+
+void transmitHeartbeat(uint8_t gateStatus) {
+    BuzzhiveHeartbeat packet;
+    packet.hiveId = HIVE_ID;
+    packet.gateStatus = gateStatus;
+    packet.temperature = (int16_t)(sht31.readTemperature() * 100);
+    packet.humidity = (uint8_t)sht31.readHumidity();
+    packet.batteryMv = analogRead(A0) * 2;  // Assuming voltage divider
+    
+    Serial.printf("📡 Heartbeat (%d bytes)\n", sizeof(packet));
+    
+#ifdef USE_TDMA
+    waitForSlot();
+#endif
+    loraRadio.transmit((uint8_t*)&packet, sizeof(packet));
+}
+
+#endif // USE_ACTIVITY_GATE
+
 // ============================================================================
 // Power Management
 // ============================================================================
@@ -216,13 +850,40 @@ bool isWinterMode() {
 }
 
 uint32_t getSleepDuration() {
+#ifdef USE_DOWNLINK
+    // As the base station asked
+    if (downlinkWakeIntervalS > 0) {
+        return downlinkWakeIntervalS * 1000UL;
+    }
+    if (alertMode()) {
+        return ALERT_MODE_INTERVAL_MS;
+    }
+#endif
     if (isWinterMode()) {
         return WINTER_INTERVAL_MS;
     }
     return ACTIVE_SEASON_INTERVAL_MS;
 }
 
+/**
+ * Sleep until the next report: the wanted interval or, with a TDMA slot,
+ * until the lead before the slot a whole number of cycles on (or the
+ * wanted interval, when that is under half a cycle and comes first)
+ */
+uint32_t nextSleepMs() {
+#ifdef USE_TDMA
+    if (slotState.slotAtUs != 0) {
+        int64_t nowUs = rtcNowUs();
+        int64_t wakeUs = slotAdvance(slotState, nowUs, slotLeadMs, getSleepDuration(), TDMA_CYCLE_MS);
+        return (uint32_t)((wakeUs - nowUs) / 1000);
+    }
+#endif
+    return getSleepDuration();
+}
+
 void enterDeepSleep(uint32_t durationMs) {
+    Serial.printf("📻 Radio on this wake: TX %lu ms, RX %lu ms\n",
+                  (unsigned long)loraRadio.txMs(), (unsigned long)loraRadio.rxMs());
     Serial.printf("💤 Sleeping for %lu seconds...\n", durationMs / 1000);
     Serial.flush();
     
@@ -245,23 +906,13 @@ void setup() {
     Serial.println("\n🐝 Buzzhive Hive Sensor v1.0");
     Serial.printf("   Hive ID: %d\n", HIVE_ID);
     
-    // Allocate audio buffer in PSRAM if available
-    if (psramFound()) {
-        audioBuffer = (int16_t*)ps_malloc(AUDIO_BUFFER_SIZE * sizeof(int16_t));
-        Serial.println("   Using PSRAM for audio buffer");
-    } else {
-        audioBuffer = (int16_t*)malloc(AUDIO_BUFFER_SIZE * sizeof(int16_t));
-        Serial.println("   Using internal RAM for audio buffer");
-    }
-    
-    if (!audioBuffer) {
-        Serial.println("❌ Failed to allocate audio buffer!");
-        while (1);
-    }
-    
     // Initialize peripherals
     Wire.begin();
     
+#ifdef USE_ACTIVITY_GATE
+    mfccStream.setObserver(&activityGate);
+#endif
+    
     if (!sht31.begin(0x44)) {
         Serial.println("⚠️ SHT31 not found, continuing without temp/humidity");
     }
@@ -280,21 +931,53 @@ void loop() {
         return;
     }
     
+#ifdef USE_ACTIVITY_GATE
+    // Silent or same as last report: heartbeat only, no features or report
+    // (in alert mode the gate always lets the full recording through)
+    if (gateDecision != GATE_ACTIVE) {
+        gateSignature.skippedCycles++;
+#ifdef USE_REPORT_BATCH
+        addBatchReading(gateDecision);   // In place of a heartbeat
+#else
+        transmitHeartbeat(gateDecision);
+#endif
+        enterDeepSleep(nextSleepMs());
+        return;
+    }
+    if (activityGate.ready()) {
+        gateSignature = activityGate.signature();
+    }
+#endif
+    
     // 2. Extract MFCC features
     extractMFCCFeatures();
     
-    // 3. For now, send features to base station for classification
-    //    (Full on-device inference requires more memory)
-    //    Base station will return classification via LoRa ACK
-    
+#ifdef USE_FEATURE_UPLINK
+    // 3-4. Send the features (or batch them); the base station classifies them
+    //      (full on-device inference requires more memory)
+#ifdef USE_REPORT_BATCH
+    addBatchReading(GATE_ACTIVE);
+#else
+    transmitFeatures();
+#ifdef USE_DOWNLINK
+    receiveDownlink(uplinkSequence - 1);
+#endif
+#endif
+#else
     // Placeholder: In standalone mode, we could run a simpler model here
     uint8_t queenStatus = 3;  // Default: Queen_Accepted (normal)
     uint8_t anomalyScore = 0;
     
     // 4. Transmit data
     transmitData(queenStatus, anomalyScore);
+#endif
+    
+#ifdef USE_AUDIO_CLIP_UPLINK
+    // Occasional raw clip for labeling (compressed while recording)
+    transmitAudioClip();
+#endif
     
     // 5. Deep sleep until next reading
-    enterDeepSleep(getSleepDuration());
+    enterDeepSleep(nextSleepMs());
 }
 
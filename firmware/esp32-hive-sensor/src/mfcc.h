@@ -12,15 +12,18 @@
 #ifndef MFCC_H
 #define MFCC_H
 
-#include <Arduino.h>
+#include <stdint.h>
+#include <stddef.h>
 #include <math.h>
+#include <string.h>
+#include "dct.h"
 
 // Configuration
 #define N_MFCC 13
 #define N_FFT 2048
 #define HOP_LENGTH 512
 #define N_MELS 40
-#define FMIN 0.0
+#define FMIN 20.0
 #define FMAX 8000.0
 
 // Total features: (13 MFCCs + 13 deltas + 13 delta-deltas) * 2 (mean + std)
@@ -40,166 +43,468 @@ void extractMFCC(const int16_t* samples, size_t numSamples, int sampleRate, floa
 // Implementation
 // ============================================================================
 
-// Pre-computed Mel filterbank (simplified for ESP32)
-// In production, compute this based on sample rate and FFT size
+// ============================================================================
+// Real FFT (N_FFT-point real input via N_FFT/2-point complex FFT)
+// ============================================================================
+
+#define FFT_HALF (N_FFT / 2)
+#define N_BINS (N_FFT / 2 + 1)
+
+// Tables are built once on first use and shared by every frame:
+// - window: periodic Hann, the librosa.stft() default
+// - twiddle: e^(-2*pi*i*k/N_FFT) for k < N_FFT/2. The N_FFT/2-point complex
+//   FFT uses the even entries, the real-split step uses all of them.
+static float fftWindow[N_FFT];
+static float fftTwiddleRe[FFT_HALF];
+static float fftTwiddleIm[FFT_HALF];
+static bool fftTablesReady = false;
+
+static void initFFTTables() {
+    if (fftTablesReady) return;
+    for (int i = 0; i < N_FFT; i++) {
+        fftWindow[i] = (float)(0.5 - 0.5 * cos(2.0 * M_PI * i / N_FFT));
+    }
+    for (int k = 0; k < FFT_HALF; k++) {
+        fftTwiddleRe[k] = (float)cos(2.0 * M_PI * k / N_FFT);
+        fftTwiddleIm[k] = (float)-sin(2.0 * M_PI * k / N_FFT);
+    }
+    fftTablesReady = true;
+}
+
+// In-place radix-2 decimation-in-time complex FFT of FFT_HALF points
+static void complexFFT(float* re, float* im) {
+    // Bit-reversal permutation
+    for (int i = 1, j = 0; i < FFT_HALF; i++) {
+        int bit = FFT_HALF >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j |= bit;
+        if (i < j) {
+            float t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    // Butterflies; twiddle stride in the N_FFT table is 2 * (FFT_HALF / len)
+    for (int len = 2; len <= FFT_HALF; len <<= 1) {
+        int half = len >> 1;
+        int stride = N_FFT / len;
+        for (int start = 0; start < FFT_HALF; start += len) {
+            for (int j = 0; j < half; j++) {
+                float wr = fftTwiddleRe[j * stride];
+                float wi = fftTwiddleIm[j * stride];
+                int a = start + j;
+                int b = a + half;
+                float tr = re[b] * wr - im[b] * wi;
+                float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
+
+/**
+ * Compute the power spectrum |X[k]|^2 of one windowed frame
+ * 
+ * Matches librosa.stft(window='hann') followed by np.abs(S)**2.
+ * 
+ * @param frame N_FFT audio samples (int16_t)
+ * @param spectrum Output array of N_BINS floats (DC..Nyquist)
+ */
+static void computePowerSpectrum(const int16_t* frame, float* spectrum) {
+    static float re[FFT_HALF];
+    static float im[FFT_HALF];
+    const float scale = 1.0f / 32768.0f;
+
+    initFFTTables();
+
+    // Pack even samples into the real part, odd samples into the imaginary part
+    for (int n = 0; n < FFT_HALF; n++) {
+        re[n] = frame[2 * n] * fftWindow[2 * n] * scale;
+        im[n] = frame[2 * n + 1] * fftWindow[2 * n + 1] * scale;
+    }
+
+    complexFFT(re, im);
+
+    // Split the packed spectrum into the real-input spectrum. Bins k and
+    // FFT_HALF - k share the same inputs, so both are produced per iteration.
+    spectrum[0] = (re[0] + im[0]) * (re[0] + im[0]);
+    spectrum[FFT_HALF] = (re[0] - im[0]) * (re[0] - im[0]);
+
+    for (int k = 1; k <= FFT_HALF / 2; k++) {
+        int mk = FFT_HALF - k;
+        float er = 0.5f * (re[k] + re[mk]);
+        float ei = 0.5f * (im[k] - im[mk]);
+        float or_ = 0.5f * (im[k] + im[mk]);
+        float oi = -0.5f * (re[k] - re[mk]);
+
+        float wr = fftTwiddleRe[k];
+        float wi = fftTwiddleIm[k];
+        float tr = or_ * wr - oi * wi;
+        float ti = or_ * wi + oi * wr;
+
+        float xr = er + tr, xi = ei + ti;
+        spectrum[k] = xr * xr + xi * xi;
+        xr = er - tr; xi = -(ei - ti);
+        spectrum[mk] = xr * xr + xi * xi;
+    }
+}
+
+// ============================================================================
+// Mel Filterbank
+// ============================================================================
 
-static float melScale(float freq) {
-    return 2595.0 * log10(1.0 + freq / 700.0);
+// Slaney mel scale (librosa default, htk=False): linear below 1 kHz,
+// logarithmic above. Only used while building the filterbank.
+static double melScale(double freq) {
+    const double fSp = 200.0 / 3.0;
+    const double minLogHz = 1000.0;
+    const double minLogMel = minLogHz / fSp;
+    const double logStep = log(6.4) / 27.0;
+    if (freq < minLogHz) return freq / fSp;
+    return minLogMel + log(freq / minLogHz) / logStep;
 }
 
-static float invMelScale(float mel) {
-    return 700.0 * (pow(10.0, mel / 2595.0) - 1.0);
+static double invMelScale(double mel) {
+    const double fSp = 200.0 / 3.0;
+    const double minLogHz = 1000.0;
+    const double minLogMel = minLogHz / fSp;
+    const double logStep = log(6.4) / 27.0;
+    if (mel < minLogMel) return mel * fSp;
+    return minLogHz * exp(logStep * (mel - minLogMel));
 }
 
-// Simple DCT-II implementation
-static void dct(const float* input, float* output, int n) {
-    for (int k = 0; k < n; k++) {
-        float sum = 0.0;
-        for (int i = 0; i < n; i++) {
-            sum += input[i] * cos(M_PI * k * (2 * i + 1) / (2.0 * n));
+// Each bin overlaps at most two triangular filters
+#define MEL_MAX_WEIGHTS (2 * N_BINS)
+
+/**
+ * Sparse triangular mel filterbank
+ * 
+ * Band m covers bins [start[m], start[m] + length[m]) and its nonzero
+ * weights are stored contiguously at weights[offset[m]]. Weights use
+ * Slaney area normalization, matching librosa.filters.mel().
+ */
+struct MelFilterbank {
+    int sampleRate;
+    uint16_t start[N_MELS];
+    uint16_t length[N_MELS];
+    uint16_t offset[N_MELS];
+    float weights[MEL_MAX_WEIGHTS];
+};
+
+static void buildMelFilterbank(MelFilterbank* fb, int sampleRate) {
+    double melPoints[N_MELS + 2];
+    double hzPoints[N_MELS + 2];
+    double melMin = melScale(FMIN);
+    double melMax = melScale(FMAX);
+    for (int i = 0; i < N_MELS + 2; i++) {
+        melPoints[i] = melMin + i * (melMax - melMin) / (N_MELS + 1);
+        hzPoints[i] = invMelScale(melPoints[i]);
+    }
+
+    double binHz = (double)sampleRate / N_FFT;
+    int used = 0;
+    fb->sampleRate = sampleRate;
+
+    for (int m = 0; m < N_MELS; m++) {
+        double lo = hzPoints[m];
+        double center = hzPoints[m + 1];
+        double hi = hzPoints[m + 2];
+        double enorm = 2.0 / (hi - lo);
+
+        fb->start[m] = 0;
+        fb->length[m] = 0;
+        fb->offset[m] = used;
+
+        for (int b = 0; b < N_BINS; b++) {
+            double f = b * binHz;
+            double lower = (f - lo) / (center - lo);
+            double upper = (hi - f) / (hi - center);
+            double w = lower < upper ? lower : upper;
+            // A triangle's support is contiguous, so nonzero bins form one run
+            if (w <= 0.0 || used >= MEL_MAX_WEIGHTS) continue;
+            if (fb->length[m] == 0) fb->start[m] = b;
+            fb->weights[used++] = (float)(w * enorm);
+            fb->length[m]++;
         }
-        output[k] = sum;
     }
 }
 
-// Compute power spectrum using simple FFT approximation
-// Note: For production, use a proper FFT library like arduinoFFT
-static void computePowerSpectrum(const int16_t* frame, int frameSize, float* spectrum) {
-    // Apply Hamming window and compute magnitude
-    for (int i = 0; i < frameSize / 2; i++) {
-        float window = 0.54 - 0.46 * cos(2 * M_PI * i / (frameSize - 1));
-        float real = frame[i] * window / 32768.0;
-        float imag = frame[frameSize - 1 - i] * window / 32768.0;
-        spectrum[i] = real * real + imag * imag;
+/**
+ * Get the filterbank for a sample rate, building it on first use
+ * 
+ * The table only depends on (sampleRate, N_FFT, N_MELS, FMIN, FMAX), so the
+ * log/exp work happens once rather than on every frame.
+ */
+static const MelFilterbank* getMelFilterbank(int sampleRate) {
+    static MelFilterbank fb;
+    static bool ready = false;
+    if (!ready || fb.sampleRate != sampleRate) {
+        buildMelFilterbank(&fb, sampleRate);
+        ready = true;
     }
+    return &fb;
 }
 
-// Main MFCC extraction function
-void extractMFCC(const int16_t* samples, size_t numSamples, int sampleRate, float* features) {
-    int numFrames = (numSamples - N_FFT) / HOP_LENGTH + 1;
-    if (numFrames <= 0) numFrames = 1;
-    
-    // Allocate temporary buffers (stack allocation for small sizes)
-    float mfccFrames[100][N_MFCC];  // Max 100 frames
-    int actualFrames = min(numFrames, 100);
-    
-    float spectrum[N_FFT / 2];
-    float melEnergies[N_MELS];
-    float mfcc[N_MFCC];
-    
-    // Process each frame
-    for (int f = 0; f < actualFrames; f++) {
-        int offset = f * HOP_LENGTH;
-        
-        // Compute power spectrum
-        computePowerSpectrum(&samples[offset], N_FFT, spectrum);
-        
-        // Apply Mel filterbank (simplified)
+// Mel band energies from a power spectrum: a multiply-accumulate over each band's nonzero run
+static void applyMelFilterbank(const MelFilterbank* fb, const float* spectrum, float* melEnergies) {
+    for (int m = 0; m < N_MELS; m++) {
+        const float* w = &fb->weights[fb->offset[m]];
+        const float* p = &spectrum[fb->start[m]];
+        int len = fb->length[m];
+        float sum = 0.0f;
+        for (int i = 0; i < len; i++) {
+            sum += w[i] * p[i];
+        }
+        melEnergies[m] = sum;
+    }
+}
+
+// Orthonormal DCT-II over the mel bands, keeping the first N_MFCC outputs
+static DCT2<N_MELS, N_MFCC> mfccDct;
+
+/**
+ * Float per-frame MFCC kernel: power spectrum -> mel -> dB -> DCT
+ * 
+ * Frame kernels are plugged into MfccStreamT, which owns framing, deltas
+ * and statistics. A kernel provides begin(sampleRate) and
+ * compute(frame, mfcc) taking N_FFT samples to N_MFCC coefficients.
+ */
+class MfccFrameFloat {
+public:
+    void begin(int sampleRate) {
+        melFb_ = getMelFilterbank(sampleRate);
+    }
+
+    void compute(const int16_t* frame, float* mfcc) {
+        float melEnergies[N_MELS];
+
+        computePowerSpectrum(frame, spectrum_);
+        applyMelFilterbank(melFb_, spectrum_, melEnergies);
+
+        // Log power in dB, as librosa.power_to_db(ref=1.0, amin=1e-10)
         for (int m = 0; m < N_MELS; m++) {
-            float melLow = melScale(FMIN) + m * (melScale(FMAX) - melScale(FMIN)) / N_MELS;
-            float melHigh = melScale(FMIN) + (m + 1) * (melScale(FMAX) - melScale(FMIN)) / N_MELS;
-            
-            float sum = 0.0;
-            int binLow = (int)(invMelScale(melLow) * N_FFT / sampleRate);
-            int binHigh = (int)(invMelScale(melHigh) * N_FFT / sampleRate);
-            
-            for (int b = binLow; b < binHigh && b < N_FFT / 2; b++) {
-                sum += spectrum[b];
+            float e = melEnergies[m] > 1e-10f ? melEnergies[m] : 1e-10f;
+            melEnergies[m] = 10.0f * log10f(e);
+        }
+        mfccDct.compute(melEnergies, mfcc);
+    }
+
+private:
+    const MelFilterbank* melFb_;
+    float spectrum_[N_BINS];
+};
+
+// ============================================================================
+// Streaming Extractor
+// ============================================================================
+
+// Delta window in frames (librosa.feature.delta width, must be odd)
+#define DELTA_WIDTH 9
+#define DELTA_HALF (DELTA_WIDTH / 2)
+
+/**
+ * Receives each frame's MFCCs as they are computed (e.g. an activity gate
+ * that needs per-frame spectral information without a second FFT)
+ */
+class MfccFrameObserver {
+public:
+    virtual ~MfccFrameObserver() {}
+    virtual void onMfccFrame(const float* mfcc) = 0;
+};
+
+/**
+ * Frame-by-frame MFCC extractor with running statistics
+ * 
+ * Accepts audio in chunks of any size (e.g. straight from i2s_read) and
+ * keeps only one N_FFT sliding window plus the last DELTA_WIDTH frames of
+ * MFCCs. Each frame's MFCC, delta and delta-delta values are folded into
+ * Welford mean/variance accumulators, so every frame of the clip counts
+ * and nothing scales with clip length.
+ * 
+ * Matches librosa.feature.mfcc(center=True) followed by
+ * librosa.feature.delta(width=9, order=1/2), except that power_to_db's
+ * top_db clamp is not applied (it needs the whole spectrogram).
+ * 
+ * Usage:
+ *   stream.begin(sampleRate);
+ *   while (capturing) stream.push(chunk, n);
+ *   stream.finish(features);
+ */
+template <class FrameKernel>
+class MfccStreamT {
+public:
+    MfccStreamT() : observer_(nullptr) {}
+
+    // Optional per-frame hook; stays attached across begin() calls
+    void setObserver(MfccFrameObserver* observer) { observer_ = observer; }
+
+    void begin(int sampleRate) {
+        kernel_.begin(sampleRate);
+        // center=True: the first frame is centred on sample 0
+        memset(window_, 0, sizeof(window_));
+        fill_ = N_FFT / 2;
+        frames_ = 0;
+        historyCount_ = 0;
+        deltaCount_ = 0;
+        memset(mean_, 0, sizeof(mean_));
+        memset(m2_, 0, sizeof(m2_));
+        memset(lastDelta_, 0, sizeof(lastDelta_));
+        memset(lastDelta2_, 0, sizeof(lastDelta2_));
+    }
+
+    /**
+     * Feed audio samples
+     * 
+     * @param samples Audio samples (int16_t)
+     * @param count Number of samples, any size
+     */
+    void push(const int16_t* samples, size_t count) {
+        while (count > 0) {
+            size_t n = N_FFT - fill_;
+            if (n > count) n = count;
+            memcpy(&window_[fill_], samples, n * sizeof(int16_t));
+            fill_ += n;
+            samples += n;
+            count -= n;
+
+            if (fill_ == N_FFT) {
+                processFrame();
+                memmove(window_, &window_[HOP_LENGTH], (N_FFT - HOP_LENGTH) * sizeof(int16_t));
+                fill_ = N_FFT - HOP_LENGTH;
             }
-            melEnergies[m] = log(sum + 1e-10);
         }
-        
-        // Apply DCT to get MFCCs
-        dct(melEnergies, mfcc, N_MFCC);
-        
-        // Store frame MFCCs
-        for (int i = 0; i < N_MFCC; i++) {
-            mfccFrames[f][i] = mfcc[i];
+    }
+
+    /**
+     * Flush the trailing frames and write the 78 aggregated features
+     * 
+     * @param features Output array of N_FEATURES floats
+     * @param gain Linear gain to apply to the audio (e.g. peak normalization).
+     *             In the log-mel domain a gain only shifts MFCC 0, so it is
+     *             applied here instead of to every sample.
+     */
+    void finish(float* features, float gain = 1.0f) {
+        // center=True: pad N_FFT / 2 zeros after the last sample
+        static const int16_t zeros[HOP_LENGTH] = {0};
+        size_t pad = N_FFT / 2;
+        while (pad > 0) {
+            size_t n = pad < HOP_LENGTH ? pad : HOP_LENGTH;
+            push(zeros, n);
+            pad -= n;
         }
+
+        // librosa's 'interp' edge mode: the last window's polynomial fit
+        // gives the same derivative for the trailing DELTA_HALF frames
+        if (historyCount_ >= DELTA_WIDTH) {
+            for (int i = 0; i < DELTA_HALF; i++) accumulateDeltas(lastDelta_, lastDelta2_);
+        }
+
+        for (int i = 0; i < 3 * N_MFCC; i++) {
+            int n = (i < N_MFCC) ? frames_ : deltaCount_;
+            features[i] = mean_[i];
+            features[3 * N_MFCC + i] = n > 0 ? sqrtf(m2_[i] / n) : 0.0f;
+        }
+        if (gain > 0.0f && gain != 1.0f) {
+            features[0] += 20.0f * log10f(gain) * sqrtf((float)N_MELS);
+        }
+    }
+
+    int frameCount() const { return frames_; }
+
+private:
+    void processFrame() {
+        float* mfcc = history_[frames_ % DELTA_WIDTH];
+
+        kernel_.compute(window_, mfcc);
+        if (observer_) observer_->onMfccFrame(mfcc);
+
+        frames_++;
+        if (historyCount_ < DELTA_WIDTH) historyCount_++;
+
+        // MFCC statistics are kept in the first N_MFCC slots
+        for (int i = 0; i < N_MFCC; i++) welford(i, mfcc[i], frames_);
+
+        if (historyCount_ == DELTA_WIDTH) computeDeltas();
     }
-    
-    // Compute delta and delta-delta MFCCs
-    float deltaFrames[100][N_MFCC];
-    float delta2Frames[100][N_MFCC];
-    
-    for (int f = 0; f < actualFrames; f++) {
+
+    // Savitzky-Golay derivatives over the last DELTA_WIDTH frames, centred
+    // on frame (frames_ - 1 - DELTA_HALF)
+    void computeDeltas() {
+        float delta[N_MFCC];
+        float delta2[N_MFCC];
+        float norm1 = 0.0f;
+        float norm2 = 0.0f;
+        const float meanSq = DELTA_HALF * (DELTA_HALF + 1) / 3.0f;
+        for (int n = -DELTA_HALF; n <= DELTA_HALF; n++) {
+            norm1 += (float)(n * n);
+            norm2 += (n * n - meanSq) * (n * n - meanSq);
+        }
+
         for (int i = 0; i < N_MFCC; i++) {
-            // Delta: difference with adjacent frames
-            if (f > 0 && f < actualFrames - 1) {
-                deltaFrames[f][i] = (mfccFrames[f + 1][i] - mfccFrames[f - 1][i]) / 2.0;
-            } else {
-                deltaFrames[f][i] = 0;
+            delta[i] = 0.0f;
+            delta2[i] = 0.0f;
+        }
+        for (int n = -DELTA_HALF; n <= DELTA_HALF; n++) {
+            const float* c = history_[(frames_ - 1 - DELTA_HALF + n) % DELTA_WIDTH];
+            float w1 = n / norm1;
+            float w2 = 2.0f * (n * n - meanSq) / norm2;
+            for (int i = 0; i < N_MFCC; i++) {
+                delta[i] += w1 * c[i];
+                delta2[i] += w2 * c[i];
             }
         }
+
+        // The first full window also stands in for the leading edge frames
+        int repeats = (frames_ == DELTA_WIDTH) ? DELTA_HALF + 1 : 1;
+        for (int r = 0; r < repeats; r++) accumulateDeltas(delta, delta2);
+
+        memcpy(lastDelta_, delta, sizeof(delta));
+        memcpy(lastDelta2_, delta2, sizeof(delta2));
     }
-    
-    for (int f = 0; f < actualFrames; f++) {
+
+    void accumulateDeltas(const float* delta, const float* delta2) {
+        deltaCount_++;
         for (int i = 0; i < N_MFCC; i++) {
-            // Delta-delta
-            if (f > 0 && f < actualFrames - 1) {
-                delta2Frames[f][i] = (deltaFrames[f + 1][i] - deltaFrames[f - 1][i]) / 2.0;
-            } else {
-                delta2Frames[f][i] = 0;
-            }
+            welford(N_MFCC + i, delta[i], deltaCount_);
+            welford(2 * N_MFCC + i, delta2[i], deltaCount_);
         }
     }
-    
-    // Aggregate: compute mean and std for each feature
-    int idx = 0;
-    
-    // MFCCs mean
-    for (int i = 0; i < N_MFCC; i++) {
-        float sum = 0;
-        for (int f = 0; f < actualFrames; f++) sum += mfccFrames[f][i];
-        features[idx++] = sum / actualFrames;
-    }
-    
-    // Deltas mean
-    for (int i = 0; i < N_MFCC; i++) {
-        float sum = 0;
-        for (int f = 0; f < actualFrames; f++) sum += deltaFrames[f][i];
-        features[idx++] = sum / actualFrames;
-    }
-    
-    // Delta-deltas mean
-    for (int i = 0; i < N_MFCC; i++) {
-        float sum = 0;
-        for (int f = 0; f < actualFrames; f++) sum += delta2Frames[f][i];
-        features[idx++] = sum / actualFrames;
-    }
-    
-    // MFCCs std
-    for (int i = 0; i < N_MFCC; i++) {
-        float mean = features[i];
-        float sumSq = 0;
-        for (int f = 0; f < actualFrames; f++) {
-            float diff = mfccFrames[f][i] - mean;
-            sumSq += diff * diff;
-        }
-        features[idx++] = sqrt(sumSq / actualFrames);
-    }
-    
-    // Deltas std
-    for (int i = 0; i < N_MFCC; i++) {
-        float mean = features[N_MFCC + i];
-        float sumSq = 0;
-        for (int f = 0; f < actualFrames; f++) {
-            float diff = deltaFrames[f][i] - mean;
-            sumSq += diff * diff;
-        }
-        features[idx++] = sqrt(sumSq / actualFrames);
-    }
-    
-    // Delta-deltas std
-    for (int i = 0; i < N_MFCC; i++) {
-        float mean = features[2 * N_MFCC + i];
-        float sumSq = 0;
-        for (int f = 0; f < actualFrames; f++) {
-            float diff = delta2Frames[f][i] - mean;
-            sumSq += diff * diff;
-        }
-        features[idx++] = sqrt(sumSq / actualFrames);
+
+    void welford(int slot, float x, int n) {
+        float d = x - mean_[slot];
+        mean_[slot] += d / n;
+        m2_[slot] += d * (x - mean_[slot]);
     }
+
+    FrameKernel kernel_;
+    MfccFrameObserver* observer_;
+    int16_t window_[N_FFT];
+    size_t fill_;
+    int frames_;
+    int historyCount_;
+    int deltaCount_;
+    float history_[DELTA_WIDTH][N_MFCC];
+    float lastDelta_[N_MFCC];
+    float lastDelta2_[N_MFCC];
+    float mean_[3 * N_MFCC];
+    float m2_[3 * N_MFCC];
+};
+
+typedef MfccStreamT<MfccFrameFloat> MfccStream;
+
+/**
+ * Extract MFCC features from a complete clip
+ * 
+ * Convenience wrapper around MfccStream for audio already in memory.
+ */
+void extractMFCC(const int16_t* samples, size_t numSamples, int sampleRate, float* features) {
+    static MfccStream stream;
+    stream.begin(sampleRate);
+    stream.push(samples, numSamples);
+    stream.finish(features);
 }
 
 #endif // MFCC_H
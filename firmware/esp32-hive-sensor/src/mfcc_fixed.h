@@ -0,0 +1,314 @@
+/**
+ * Fixed-Point MFCC Frame Kernel
+ *
+ * Integer-only alternative to the float per-frame MFCC chain in mfcc.h:
+ * - Q15 Hann window and block-floating-point Q15 radix-2 FFT
+ * - Mel accumulation of Q15 weights into 64-bit (Q31-normalised) sums
+ * - Table-based log2 (256-entry mantissa table, linear interpolation)
+ * - Q15 DCT-II basis applied to Q7 dB values
+ *
+ * Frame scaling (input normalisation and FFT block exponents) is carried
+ * as an exponent and folded back in the log domain, so quiet frames keep
+ * their precision. Framing, deltas and statistics are shared with the
+ * float path through MfccStreamT.
+ *
+ * Error bound vs the float extractMFCC() (tools/bench_mfcc.cpp, 10 s
+ * synthetic hive-like clips from full scale down to -40 dB): per-frame
+ * MFCC error < 0.05, aggregated 78-feature error < 0.04 absolute and
+ * < 0.002 in StandardScaler units.
+ *
+ * Portable C++ (no Arduino dependencies) so it also builds on a host.
+ * Select it on the sensor with -DMFCC_FIXED_POINT.
+ */
+
+#ifndef MFCC_FIXED_H
+#define MFCC_FIXED_H
+
+#include "mfcc.h"
+
+// ============================================================================
+// Tables
+// ============================================================================
+
+#define LOG2_TABLE_BITS 8
+#define LOG2_TABLE_SIZE (1 << LOG2_TABLE_BITS)
+
+// 10 * log10(2) in Q14
+#define DB_PER_LOG2_Q14 49321
+
+// dB values fed to the DCT are Q7 (range +-256 dB)
+#define DB_Q 7
+
+// Floor matching power_to_db(amin=1e-10): -100 dB
+#define DB_FLOOR_Q7 (-100 * (1 << DB_Q))
+
+static int16_t q15Window[N_FFT];
+static int16_t q15TwiddleRe[FFT_HALF];
+static int16_t q15TwiddleIm[FFT_HALF];
+static uint32_t log2TableQ16[LOG2_TABLE_SIZE + 1];
+static bool q15TablesReady = false;
+
+static int16_t toQ15(double v) {
+    double r = floor(v * 32768.0 + 0.5);
+    if (r > 32767.0) r = 32767.0;
+    if (r < -32768.0) r = -32768.0;
+    return (int16_t)r;
+}
+
+static void initQ15Tables() {
+    if (q15TablesReady) return;
+    initFFTTables();
+    for (int i = 0; i < N_FFT; i++) q15Window[i] = toQ15(fftWindow[i]);
+    for (int k = 0; k < FFT_HALF; k++) {
+        q15TwiddleRe[k] = toQ15(fftTwiddleRe[k]);
+        q15TwiddleIm[k] = toQ15(fftTwiddleIm[k]);
+    }
+    for (int i = 0; i <= LOG2_TABLE_SIZE; i++) {
+        log2TableQ16[i] = (uint32_t)floor(log2(1.0 + (double)i / LOG2_TABLE_SIZE) * 65536.0 + 0.5);
+    }
+    q15TablesReady = true;
+}
+
+// ============================================================================
+// Log2
+// ============================================================================
+
+static inline int msb64(uint64_t x) {
+    return 63 - __builtin_clzll(x);
+}
+
+/**
+ * log2(x) in Q16 for x > 0
+ *
+ * Integer part from the MSB position, fraction from the mantissa table
+ * with linear interpolation on the next 16 bits.
+ */
+static int32_t log2Q16(uint64_t x) {
+    int e = msb64(x);
+    // Left-align the mantissa below the MSB into 32 bits
+    uint32_t mant = (e >= 32) ? (uint32_t)(x >> (e - 32)) : (uint32_t)(x << (32 - e));
+    uint32_t idx = mant >> (32 - LOG2_TABLE_BITS);
+    uint32_t frac = (mant >> (16 - LOG2_TABLE_BITS)) & 0xFFFF;
+    uint32_t lo = log2TableQ16[idx];
+    uint32_t hi = log2TableQ16[idx + 1];
+    uint32_t f = lo + (uint32_t)(((uint64_t)(hi - lo) * frac) >> 16);
+    return (int32_t)(e << 16) + (int32_t)f;
+}
+
+// ============================================================================
+// Q15 FFT
+// ============================================================================
+
+/**
+ * Block-floating-point radix-2 complex FFT of FFT_HALF points
+ *
+ * Values are kept below 2^15 in magnitude between stages: when a stage's
+ * output exceeds 2^14, the next stage halves its inputs and the block
+ * exponent is incremented. Returns the total number of right shifts.
+ */
+static int complexFFTQ15(int32_t* re, int32_t* im, int32_t peak) {
+    for (int i = 1, j = 0; i < FFT_HALF; i++) {
+        int bit = FFT_HALF >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j |= bit;
+        if (i < j) {
+            int32_t t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    int exponent = 0;
+    for (int len = 2; len <= FFT_HALF; len <<= 1) {
+        int shift = (peak >= (1 << 15)) ? 2 : (peak >= (1 << 14)) ? 1 : 0;
+        exponent += shift;
+        peak = 0;
+
+        int half = len >> 1;
+        int stride = N_FFT / len;
+        for (int start = 0; start < FFT_HALF; start += len) {
+            for (int j = 0; j < half; j++) {
+                int32_t wr = q15TwiddleRe[j * stride];
+                int32_t wi = q15TwiddleIm[j * stride];
+                int a = start + j;
+                int b = a + half;
+                int32_t ar = re[a] >> shift, ai = im[a] >> shift;
+                int32_t br = re[b] >> shift, bi = im[b] >> shift;
+                int32_t tr = (br * wr - bi * wi) >> 15;
+                int32_t ti = (br * wi + bi * wr) >> 15;
+                re[a] = ar + tr; im[a] = ai + ti;
+                re[b] = ar - tr; im[b] = ai - ti;
+
+                int32_t m = abs(re[a]) | abs(im[a]) | abs(re[b]) | abs(im[b]);
+                if (m > peak) peak = m;
+            }
+        }
+    }
+    return exponent;
+}
+
+// ============================================================================
+// Mel Filterbank (Q15)
+// ============================================================================
+
+/**
+ * Q15 copy of a MelFilterbank
+ *
+ * Weights are scaled so the largest is just under 1.0; log2Scale holds
+ * log2 of that scale factor (Q16) to be removed in the log domain.
+ */
+struct MelFilterbankQ15 {
+    const MelFilterbank* source;
+    int16_t weights[MEL_MAX_WEIGHTS];
+    int32_t log2ScaleQ16;
+};
+
+static void buildMelFilterbankQ15(MelFilterbankQ15* q, const MelFilterbank* fb) {
+    int total = fb->offset[N_MELS - 1] + fb->length[N_MELS - 1];
+    float maxW = 0.0f;
+    for (int i = 0; i < total; i++) {
+        if (fb->weights[i] > maxW) maxW = fb->weights[i];
+    }
+    double scale = (maxW > 0.0f) ? 32767.0 / 32768.0 / maxW : 1.0;
+    for (int i = 0; i < total; i++) q->weights[i] = toQ15(fb->weights[i] * scale);
+    q->log2ScaleQ16 = (int32_t)floor(log2(scale) * 65536.0 + 0.5);
+    q->source = fb;
+}
+
+// ============================================================================
+// Frame Kernel
+// ============================================================================
+
+/**
+ * Fixed-point per-frame MFCC kernel for MfccStreamT
+ *
+ * Drop-in replacement for MfccFrameFloat; only the final 13 coefficients
+ * are converted to float for the shared delta/statistics stage.
+ */
+class MfccFrameQ15 {
+public:
+    void begin(int sampleRate) {
+        initQ15Tables();
+        const MelFilterbank* fb = getMelFilterbank(sampleRate);
+        if (builtRate_ != sampleRate) {
+            buildMelFilterbankQ15(&melQ15_, fb);
+            builtRate_ = sampleRate;
+        }
+        if (!basisReady_) {
+            for (int k = 0; k < N_MFCC; k++) {
+                for (int m = 0; m < N_MELS; m++) basis_[k][m] = toQ15(mfccDct.row(k)[m]);
+            }
+            basisReady_ = true;
+        }
+    }
+
+    void compute(const int16_t* frame, float* mfcc) {
+        int16_t melDb[N_MELS];
+        melDecibelsQ7(frame, melDb);
+
+        // Q15 basis x Q7 dB -> Q22
+        for (int k = 0; k < N_MFCC; k++) {
+            const int16_t* row = basis_[k];
+            int64_t acc = 0;
+            for (int m = 0; m < N_MELS; m++) acc += (int32_t)row[m] * melDb[m];
+            mfcc[k] = (float)acc * (1.0f / (1 << (15 + DB_Q)));
+        }
+    }
+
+    /**
+     * Mel band log power in Q7 dB for one frame
+     *
+     * @param frame N_FFT audio samples (int16_t, full scale = 1.0)
+     * @param melDb Output array of N_MELS Q7 values, floored at -100 dB
+     */
+    void melDecibelsQ7(const int16_t* frame, int16_t* melDb) {
+        // Normalise the frame so its peak sits just below 2^14 after windowing
+        int32_t framePeak = 0;
+        for (int i = 0; i < N_FFT; i++) {
+            int32_t a = abs((int32_t)frame[i]);
+            if (a > framePeak) framePeak = a;
+        }
+        if (framePeak == 0) {
+            for (int m = 0; m < N_MELS; m++) melDb[m] = DB_FLOOR_Q7;
+            return;
+        }
+        int inShift = 0;
+        while (inShift < 15 && (framePeak << (inShift + 1)) < (1 << 14)) inShift++;
+
+        // Window (Q15) and pack even/odd samples as re/im
+        int32_t peak = 0;
+        for (int n = 0; n < FFT_HALF; n++) {
+            re_[n] = ((int32_t)frame[2 * n] * q15Window[2 * n]) >> (15 - inShift);
+            im_[n] = ((int32_t)frame[2 * n + 1] * q15Window[2 * n + 1]) >> (15 - inShift);
+            int32_t m = abs(re_[n]) | abs(im_[n]);
+            if (m > peak) peak = m;
+        }
+
+        int fftShift = complexFFTQ15(re_, im_, peak);
+
+        // Real-input split; E and O carry the 1/2 factors of the float version
+        power_[0] = sq64((re_[0] + im_[0]) >> 1) << 2;
+        power_[FFT_HALF] = sq64((re_[0] - im_[0]) >> 1) << 2;
+        for (int k = 1; k <= FFT_HALF / 2; k++) {
+            int mk = FFT_HALF - k;
+            int32_t er = (re_[k] + re_[mk]) >> 1;
+            int32_t ei = (im_[k] - im_[mk]) >> 1;
+            int32_t or_ = (im_[k] + im_[mk]) >> 1;
+            int32_t oi = -((re_[k] - re_[mk]) >> 1);
+            int32_t wr = q15TwiddleRe[k];
+            int32_t wi = q15TwiddleIm[k];
+            int32_t tr = (int32_t)(((int64_t)or_ * wr - (int64_t)oi * wi) >> 15);
+            int32_t ti = (int32_t)(((int64_t)or_ * wi + (int64_t)oi * wr) >> 15);
+            power_[k] = sq64(er + tr) + sq64(ei + ti);
+            power_[mk] = sq64(er - tr) + sq64(ti - ei);
+        }
+
+        // Fixed power = P * 2^(30 + 2*inShift - 2*fftShift); weights add
+        // log2Scale. Everything below is removed as one log2 offset.
+        int32_t offsetQ16 = ((30 + 2 * inShift - 2 * fftShift + 15) << 16) + melQ15_.log2ScaleQ16;
+
+        const MelFilterbank* fb = melQ15_.source;
+        for (int m = 0; m < N_MELS; m++) {
+            const int16_t* w = &melQ15_.weights[fb->offset[m]];
+            const uint64_t* p = &power_[fb->start[m]];
+            int len = fb->length[m];
+            uint64_t acc = 0;
+            for (int i = 0; i < len; i++) acc += p[i] * (uint16_t)w[i];
+
+            if (acc == 0) {
+                melDb[m] = DB_FLOOR_Q7;
+                continue;
+            }
+            int32_t l2 = log2Q16(acc) - offsetQ16;
+            // Q16 log2 * Q14 (dB per log2) -> Q7 dB
+            int32_t db = (int32_t)(((int64_t)l2 * DB_PER_LOG2_Q14) >> (16 + 14 - DB_Q));
+            melDb[m] = (int16_t)(db < DB_FLOOR_Q7 ? DB_FLOOR_Q7 : (db > 32767 ? 32767 : db));
+        }
+    }
+
+private:
+    static inline uint64_t sq64(int32_t v) {
+        return (uint64_t)((int64_t)v * v);
+    }
+
+    MelFilterbankQ15 melQ15_ = {nullptr, {0}, 0};
+    int builtRate_ = 0;
+    bool basisReady_ = false;
+    int16_t basis_[N_MFCC][N_MELS];
+    int32_t re_[FFT_HALF];
+    int32_t im_[FFT_HALF];
+    uint64_t power_[N_BINS];
+};
+
+typedef MfccStreamT<MfccFrameQ15> MfccStreamQ15;
+
+/**
+ * Fixed-point counterpart of extractMFCC()
+ */
+void extractMFCCFixed(const int16_t* samples, size_t numSamples, int sampleRate, float* features) {
+    static MfccStreamQ15 stream;
+    stream.begin(sampleRate);
+    stream.push(samples, numSamples);
+    stream.finish(features);
+}
+
+#endif // MFCC_FIXED_H
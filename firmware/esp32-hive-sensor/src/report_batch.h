@@ -0,0 +1,298 @@
+/**
+ * Batched Multi-Reading Uplink
+ *
+ * The sensor keeps each wake's reading in RTC memory and sends several
+ * in one frame, so the preamble, header and radio start-up are paid once
+ * per batch instead of once per reading:
+ *
+ *   [BatchHeader 7 bytes][bit stream, LSB first]
+ *
+ * The stream holds the newest reading's age at send time, then the
+ * readings oldest first. The first reading is absolute; each later one
+ * is coded against the one before it as Exp-Golomb deltas (small changes
+ * take few bits):
+ *
+ *   interval since the previous reading   seconds, k=9
+ *   temperature (x100), humidity, battery deltas, k=4 / 1 / 3
+ *   status                                2 bits (GateDecision)
+ *   features present                      1 bit
+ *   features                              per feature: delta from the
+ *       last reading with features (k=0), or absolute `bits`-bit codes
+ *       (offset binary) when that is shorter; 1 bit says which
+ *
+ * Feature codes are feature_packet.h's quantization at the batch's width.
+ * Gated wakes (activity_gate.h) add a reading without features.
+ *
+ * Portable C++ (no Arduino dependencies). Shared by both firmwares: the
+ * base station includes this copy (see its platformio.ini).
+ */
+
+#ifndef REPORT_BATCH_H
+#define REPORT_BATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "feature_packet.h"
+#include "lora_transport.h"
+
+#define BATCH_MAGIC 0xBA
+#define BATCH_MAX_READINGS 16
+
+// One frame with room for a transport header (TRANSPORT_FRAGMENT_BYTES)
+#define BATCH_MAX_BYTES 240
+
+// BatchReading::flags
+#define READING_FEATURES 0x01
+
+// One wake's reading, as kept in RTC memory and as decoded
+struct BatchReading {
+    uint32_t timeS;               // Sensor: capture time; decoded: age when the batch was sent
+    int16_t temperature;          // x100 for 2 decimal precision
+    uint8_t humidity;
+    uint16_t batteryMv;
+    uint8_t status;               // GateDecision of the wake
+    uint8_t flags;                // READING_FEATURES
+    int8_t codes[NUM_FEATURES];   // quantizeFeature() at the batch's width
+};
+
+struct __attribute__((packed)) BatchHeader {
+    uint8_t magic;            // BATCH_MAGIC
+    uint8_t hiveId;
+    uint16_t sequence;        // First reading's; the others count up from it
+    uint8_t count;            // Readings
+    uint8_t bits;             // Feature code width
+    uint8_t crc;              // CRC-8 of the frame with this byte as 0
+};
+
+// ============================================================================
+// Bit Stream
+// ============================================================================
+
+class BatchBitWriter {
+public:
+    BatchBitWriter(uint8_t* out, size_t capacity) : out_(out), capacity_(capacity) {
+        memset(out, 0, capacity);
+    }
+
+    void put(uint32_t value, int bits) {
+        for (int i = 0; i < bits; i++) {
+            if (bit_ >= capacity_ * 8) {
+                overflow_ = true;
+                return;
+            }
+            if ((value >> i) & 1) out_[bit_ >> 3] |= (uint8_t)(1 << (bit_ & 7));
+            bit_++;
+        }
+    }
+
+    // Exp-Golomb of order k: zeros, a one, then the low bits of v + 2^k
+    void putUnsigned(uint32_t v, int k) {
+        uint32_t w = v + (1u << k);
+        int n = 0;
+        while ((w >> n) > 1) n++;
+        for (int i = k; i < n; i++) put(0, 1);
+        put(1, 1);
+        put(w, n);
+    }
+
+    void putSigned(int32_t v, int k) {
+        putUnsigned(v >= 0 ? (uint32_t)v << 1 : ((uint32_t)-v << 1) - 1, k);
+    }
+
+    bool overflow() const { return overflow_; }
+    size_t bits() const { return bit_; }
+    size_t bytes() const { return (bit_ + 7) / 8; }
+
+private:
+    uint8_t* out_;
+    size_t capacity_;
+    size_t bit_ = 0;
+    bool overflow_ = false;
+};
+
+class BatchBitReader {
+public:
+    BatchBitReader(const uint8_t* in, size_t length) : in_(in), length_(length) {}
+
+    uint32_t get(int bits) {
+        uint32_t value = 0;
+        for (int i = 0; i < bits; i++) {
+            if (bit_ >= length_ * 8) {
+                overflow_ = true;
+                return 0;
+            }
+            value |= (uint32_t)((in_[bit_ >> 3] >> (bit_ & 7)) & 1) << i;
+            bit_++;
+        }
+        return value;
+    }
+
+    uint32_t getUnsigned(int k) {
+        int n = k;
+        while (get(1) == 0) {
+            if (overflow_ || ++n > 30) {
+                overflow_ = true;
+                return 0;
+            }
+        }
+        return ((1u << n) | get(n)) - (1u << k);
+    }
+
+    int32_t getSigned(int k) {
+        uint32_t z = getUnsigned(k);
+        return (z & 1) ? -(int32_t)((z + 1) >> 1) : (int32_t)(z >> 1);
+    }
+
+    bool overflow() const { return overflow_; }
+
+private:
+    const uint8_t* in_;
+    size_t length_;
+    size_t bit_ = 0;
+    bool overflow_ = false;
+};
+
+// ============================================================================
+// Encoding
+// ============================================================================
+
+// Bits to code a reading's features against the previous reading's
+inline size_t batchDeltaBits(const int8_t* codes, const int8_t* previous) {
+    uint8_t scratch[(NUM_FEATURES * 17 + 7) / 8];
+    BatchBitWriter writer(scratch, sizeof(scratch));
+    for (int i = 0; i < NUM_FEATURES; i++) writer.putSigned(codes[i] - previous[i], 0);
+    return writer.bits();
+}
+
+/**
+ * Build a batch frame from readings, oldest first
+ *
+ * @param nowS Sensor clock at send time (same clock as timeS)
+ * @return Frame bytes, or 0 if the readings do not fit in capacity
+ */
+inline size_t batchEncode(const BatchReading* readings, int count, uint8_t hiveId,
+                          uint16_t firstSequence, uint8_t bits, uint32_t nowS,
+                          uint8_t* frame, size_t capacity) {
+    if (count < 1 || count > BATCH_MAX_READINGS || capacity <= sizeof(BatchHeader)) return 0;
+    int codeMax = featureCodeMax(bits);
+
+    BatchBitWriter writer(frame + sizeof(BatchHeader), capacity - sizeof(BatchHeader));
+    writer.putUnsigned(nowS - readings[count - 1].timeS, 4);
+    const BatchReading* featured = NULL;
+    for (int r = 0; r < count; r++) {
+        const BatchReading& reading = readings[r];
+        if (r == 0) {
+            writer.put((uint16_t)reading.temperature, 16);
+            writer.put(reading.humidity, 8);
+            writer.put(reading.batteryMv, 16);
+        } else {
+            const BatchReading& previous = readings[r - 1];
+            writer.putUnsigned(reading.timeS - previous.timeS, 9);
+            writer.putSigned(reading.temperature - previous.temperature, 4);
+            writer.putSigned(reading.humidity - previous.humidity, 1);
+            writer.putSigned(reading.batteryMv - previous.batteryMv, 3);
+        }
+        writer.put(reading.status, 2);
+
+        bool hasFeatures = (reading.flags & READING_FEATURES) != 0;
+        writer.put(hasFeatures ? 1 : 0, 1);
+        if (!hasFeatures) continue;
+
+        bool delta = featured && batchDeltaBits(reading.codes, featured->codes) < (size_t)NUM_FEATURES * bits;
+        if (featured) writer.put(delta ? 0 : 1, 1);
+        for (int i = 0; i < NUM_FEATURES; i++) {
+            if (delta) {
+                writer.putSigned(reading.codes[i] - featured->codes[i], 0);
+            } else {
+                writer.put((uint32_t)(reading.codes[i] + codeMax), bits);
+            }
+        }
+        featured = &reading;
+    }
+    if (writer.overflow()) return 0;
+
+    BatchHeader header;
+    header.magic = BATCH_MAGIC;
+    header.hiveId = hiveId;
+    header.sequence = firstSequence;
+    header.count = (uint8_t)count;
+    header.bits = bits;
+    header.crc = 0;
+    memcpy(frame, &header, sizeof(header));
+    size_t length = sizeof(header) + writer.bytes();
+    frame[sizeof(header) - 1] = transportCrc8(frame, length);
+    return length;
+}
+
+// True if frame looks like a batch: magic, sane header and CRC
+inline bool batchValid(const uint8_t* frame, size_t length) {
+    if (length <= sizeof(BatchHeader) || length > TRANSPORT_MAX_FRAME) return false;
+    BatchHeader header;
+    memcpy(&header, frame, sizeof(header));
+    if (header.magic != BATCH_MAGIC || header.count < 1 || header.count > BATCH_MAX_READINGS ||
+        header.bits < FEATURE_MIN_BITS || header.bits > FEATURE_MAX_BITS) {
+        return false;
+    }
+    uint8_t copy[TRANSPORT_MAX_FRAME];
+    memcpy(copy, frame, length);
+    copy[sizeof(header) - 1] = 0;
+    return transportCrc8(copy, length) == header.crc;
+}
+
+/**
+ * Unpack a batch (batchValid() first) into readings, oldest first;
+ * timeS becomes each reading's age in seconds when the batch was sent
+ *
+ * @param readings Room for header.count readings
+ * @return false if the stream is malformed
+ */
+inline bool batchDecode(const uint8_t* frame, size_t length, BatchHeader& header,
+                        BatchReading* readings) {
+    memcpy(&header, frame, sizeof(header));
+    int codeMax = featureCodeMax(header.bits);
+
+    BatchBitReader reader(frame + sizeof(header), length - sizeof(header));
+    uint32_t newestAgeS = reader.getUnsigned(4);
+    const BatchReading* featured = NULL;
+    for (int r = 0; r < header.count; r++) {
+        BatchReading& reading = readings[r];
+        if (r == 0) {
+            reading.timeS = 0;
+            reading.temperature = (int16_t)reader.get(16);
+            reading.humidity = (uint8_t)reader.get(8);
+            reading.batteryMv = (uint16_t)reader.get(16);
+        } else {
+            const BatchReading& previous = readings[r - 1];
+            reading.timeS = previous.timeS + reader.getUnsigned(9);
+            reading.temperature = (int16_t)(previous.temperature + reader.getSigned(4));
+            reading.humidity = (uint8_t)(previous.humidity + reader.getSigned(1));
+            reading.batteryMv = (uint16_t)(previous.batteryMv + reader.getSigned(3));
+        }
+        reading.status = (uint8_t)reader.get(2);
+        reading.flags = reader.get(1) ? READING_FEATURES : 0;
+        if (!reading.flags) {
+            memset(reading.codes, 0, sizeof(reading.codes));
+            continue;
+        }
+
+        bool delta = featured && reader.get(1) == 0;
+        for (int i = 0; i < NUM_FEATURES; i++) {
+            int code = delta ? featured->codes[i] + reader.getSigned(0)
+                             : (int)reader.get(header.bits) - codeMax;
+            if (code < -codeMax || code > codeMax) return false;
+            reading.codes[i] = (int8_t)code;
+        }
+        featured = &reading;
+    }
+    if (reader.overflow()) return false;
+
+    // Capture times (from the first reading) to ages at send time
+    uint32_t newestS = readings[header.count - 1].timeS;
+    for (int r = 0; r < header.count; r++) {
+        readings[r].timeS = newestS - readings[r].timeS + newestAgeS;
+    }
+    return true;
+}
+
+#endif // REPORT_BATCH_H
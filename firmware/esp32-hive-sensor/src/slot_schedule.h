@@ -0,0 +1,199 @@
+/**
+ * TDMA Report Slots
+ *
+ * The base station divides a cycle (the sensors' active report interval)
+ * into fixed slots and gives each hive its own, so reports stop
+ * colliding. Every downlink (downlink.h) beacons the time: the base
+ * station's clock at its start, and how far that is from the hive's next
+ * slot. The sensor:
+ * - keeps its next slot on the RTC clock, which runs on through deep
+ *   sleep but drifts (the ESP32's internal 150 kHz oscillator, up to a
+ *   few thousand ppm with temperature);
+ * - measures the drift between two downlinks and stretches its waits to
+ *   match the base station's clock; until it has, it stays off the slots;
+ * - wakes its measured recording time before the slot, then holds the
+ *   report until the slot starts;
+ * - after TDMA_MAX_MISSES downlinks missed in a row, goes back to its own
+ *   timer (ALOHA) until a downlink gives it a slot again.
+ *
+ * Longer intervals (winter) skip whole cycles and keep the slot. Shorter
+ * ones (alert mode, a short downlink wake interval) cannot be kept in
+ * slots: the hive takes its slot every cycle and sends the extra reports
+ * in between at random (ALOHA), as without TDMA.
+ *
+ * Portable C++ (no Arduino dependencies). Shared by both firmwares and
+ * tools/tdma_sim.cpp: the base station includes this copy (see its
+ * platformio.ini).
+ */
+
+#ifndef SLOT_SCHEDULE_H
+#define SLOT_SCHEDULE_H
+
+#include <stdint.h>
+#include "downlink.h"
+
+// Downlinks missed in a row before the sensor drops its slot (4 hours at
+// 15 min). With its drift measured a hive stays close to its slot that
+// long, and each hive that falls back early sends random reports that
+// knock slotted ones out of a busy cycle (tools/tdma_sim.cpp).
+#define TDMA_MAX_MISSES 16
+
+// Drift is measured over at least this much base station time (1 ms of
+// timing error is then under 20 ppm) ...
+#define TDMA_MIN_REFERENCE_MS 60000
+
+// ... and believed up to this (a restarted base station clock reads as
+// a much larger one)
+#define TDMA_MAX_DRIFT_PPM 20000
+
+// ============================================================================
+// Base Station: Slot Assignment
+// ============================================================================
+
+/**
+ * Slot length for the longest report: its frames back to back,
+ * DOWNLINK_DELAY_MS, the downlink with its window margins, and guardMs
+ * for clock error
+ *
+ * @param uplinkMs Time on air of the longest uplink frame at the slowest
+ *                 spreading factor in use, with its preamble
+ */
+inline uint32_t slotLengthMs(uint32_t uplinkMs, int frames, uint32_t downlinkMs, uint32_t guardMs) {
+    return frames * uplinkMs + DOWNLINK_DELAY_MS + downlinkMs + 2 * DOWNLINK_WINDOW_MARGIN_MS + guardMs;
+}
+
+class SlotScheduler {
+public:
+    /**
+     * @param cycleMs Cycle every slot repeats in
+     * @param slotMs Slot length: report, downlink and guard
+     */
+    void begin(uint32_t cycleMs, uint32_t slotMs) {
+        cycleMs_ = cycleMs;
+        slotMs_ = slotMs;
+        slots_ = (int)(cycleMs / slotMs);
+        assigned_ = 0;
+        for (int i = 0; i < 256; i++) slotOf_[i] = -1;
+    }
+
+    int slots() const { return slots_; }
+    int assigned() const { return assigned_; }
+
+    // The hive's slot, given out on first use; -1 once all are taken
+    int assign(uint8_t hiveId) {
+        if (slotOf_[hiveId] < 0 && assigned_ < slots_) slotOf_[hiveId] = (int16_t)assigned_++;
+        return slotOf_[hiveId];
+    }
+
+    // Start of the slot's next occurrence at or after t (ms)
+    uint32_t nextStart(int slot, uint32_t t) const {
+        uint32_t phase = this->phase(slot, t);
+        return phase == 0 ? t : t + (cycleMs_ - phase);
+    }
+
+    // How far t is from the slot's nearest start (ms, + = late)
+    int32_t error(int slot, uint32_t t) const {
+        int32_t phase = (int32_t)this->phase(slot, t);
+        return phase > (int32_t)(cycleMs_ / 2) ? phase - (int32_t)cycleMs_ : phase;
+    }
+
+private:
+    // Time since the slot's last start
+    uint32_t phase(int slot, uint32_t t) const {
+        return (t % cycleMs_ + cycleMs_ - (uint32_t)slot * slotMs_) % cycleMs_;
+    }
+
+    uint32_t cycleMs_ = 1;
+    uint32_t slotMs_ = 1;
+    int slots_ = 0;
+    int assigned_ = 0;
+    int16_t slotOf_[256];
+};
+
+// ============================================================================
+// Sensor: Slot Timing Across Deep Sleep
+// ============================================================================
+
+// Keep in RTC memory; times are on the sensor's RTC clock (us)
+struct SlotState {
+    int64_t slotAtUs;         // Next slot start; 0 = none (own timer)
+    int64_t referenceUs;      // Last downlink's start; 0 = none yet
+    uint32_t referenceMs;     // ... on the base station's clock
+    int32_t driftPpm;         // RTC clock minus base station clock
+    uint8_t timed;            // driftPpm has been measured
+    uint8_t misses;           // Downlinks missed in a row
+    uint8_t between;          // Next wake is a report between slots
+};
+
+// Sensor-clock span for base station time ms
+inline int64_t slotLocalUs(const SlotState& state, uint32_t ms) {
+    return (int64_t)ms * 1000 + (int64_t)ms * state.driftPpm / 1000;
+}
+
+/**
+ * A downlink arrived: measure the drift since the last one, then take
+ * the slot once the drift is known
+ *
+ * @param downlinkStartUs When the downlink started, on the RTC clock
+ * @param baseTimeMs ... and on the base station's
+ * @param slotInMs From then to the hive's next slot
+ */
+inline void slotSync(SlotState& state, int64_t downlinkStartUs, uint32_t baseTimeMs,
+                     uint32_t slotInMs) {
+    uint32_t baseMs = baseTimeMs - state.referenceMs;
+    if (state.referenceUs != 0 && baseMs >= TDMA_MIN_REFERENCE_MS) {
+        int64_t ppm = (downlinkStartUs - state.referenceUs - (int64_t)baseMs * 1000) * 1000 / baseMs;
+        if (ppm > -TDMA_MAX_DRIFT_PPM && ppm < TDMA_MAX_DRIFT_PPM) {
+            state.driftPpm = (int32_t)ppm;
+            state.timed = 1;
+        }
+    }
+    if (state.referenceUs == 0 || baseMs >= TDMA_MIN_REFERENCE_MS) {
+        state.referenceUs = downlinkStartUs;
+        state.referenceMs = baseTimeMs;
+    }
+    state.misses = 0;
+    if (state.timed) state.slotAtUs = downlinkStartUs + slotLocalUs(state, slotInMs);
+}
+
+// A report went without a downlink: keep the slot a few times
+inline void slotMissed(SlotState& state) {
+    if (state.slotAtUs != 0 && ++state.misses >= TDMA_MAX_MISSES) {
+        state.slotAtUs = 0;
+        state.misses = 0;
+    }
+}
+
+/**
+ * Wake lead for the next slot: the time this wake took to have its
+ * report ready plus guardMs, or slowly down from a longer lead
+ */
+inline uint32_t slotLead(uint32_t leadMs, uint32_t readyMs, uint32_t guardMs) {
+    uint32_t wanted = readyMs + guardMs;
+    return wanted >= leadMs ? wanted : leadMs - (leadMs - wanted) / 8;
+}
+
+/**
+ * Move the slot past nowUs + leadMs, by whole report intervals of cycles
+ *
+ * An interval under half a cycle keeps the slot every cycle, and wakes
+ * every intervalMs before it for a report between slots (state.between).
+ *
+ * @param intervalMs Wanted report interval, rounded to whole cycles
+ * @return Sensor-clock time to wake at
+ */
+inline int64_t slotAdvance(SlotState& state, int64_t nowUs, uint32_t leadMs,
+                           uint32_t intervalMs, uint32_t cycleMs) {
+    uint32_t cycles = (intervalMs + cycleMs / 2) / cycleMs;
+    if (cycles == 0) cycles = 1;
+    int64_t leadUs = (int64_t)leadMs * 1000;
+    while (state.slotAtUs - leadUs <= nowUs) {
+        state.slotAtUs += slotLocalUs(state, cycles * cycleMs);
+    }
+    int64_t wakeUs = state.slotAtUs - leadUs;
+    int64_t betweenUs = nowUs + slotLocalUs(state, intervalMs);
+    state.between = intervalMs < cycleMs / 2 && betweenUs < wakeUs;
+    return state.between ? betweenUs : wakeUs;
+}
+
+#endif // SLOT_SCHEDULE_H
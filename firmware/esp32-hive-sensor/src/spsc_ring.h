@@ -0,0 +1,79 @@
+/**
+ * Lock-Free Single-Producer / Single-Consumer Ring
+ *
+ * Fixed-capacity ring of preallocated slots. The producer fills a slot in
+ * place (e.g. straight from i2s_read) and commits it; the consumer reads
+ * the slot in place and releases it. No copies, no locks, no heap.
+ *
+ * Exactly one thread/task may call the producer methods and exactly one
+ * the consumer methods. Indices are free-running and CAPACITY must be a
+ * power of two.
+ *
+ * Portable C++11 (std::atomic) so the same code runs on both ESP32 cores
+ * and on a host with std::thread.
+ */
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+template <typename T, uint32_t CAPACITY>
+class SpscRing {
+public:
+    static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0, "SpscRing capacity must be a power of two");
+
+    SpscRing() : head_(0), tail_(0) {}
+
+    // Only valid while neither side is running
+    void reset() {
+        head_.store(0, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_relaxed);
+    }
+
+    // ---- Producer side ----
+
+    // Next free slot, or nullptr if the ring is full
+    T* acquireWrite() {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == CAPACITY) return nullptr;
+        return &slots_[head & (CAPACITY - 1)];
+    }
+
+    // Publish the slot returned by acquireWrite()
+    void commitWrite() {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // ---- Consumer side ----
+
+    // Oldest filled slot, or nullptr if the ring is empty
+    T* acquireRead() {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (head_.load(std::memory_order_acquire) == tail) return nullptr;
+        return &slots_[tail & (CAPACITY - 1)];
+    }
+
+    // Return the slot returned by acquireRead() to the producer
+    void releaseRead() {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // ---- Either side (approximate while the other side runs) ----
+
+    uint32_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    T slots_[CAPACITY];
+    // Producer and consumer indices on separate cache lines
+    alignas(32) std::atomic<uint32_t> head_;
+    alignas(32) std::atomic<uint32_t> tail_;
+};
+
+#endif // SPSC_RING_H
@@ -0,0 +1,194 @@
+/**
+ * Batched Uplink Size & Airtime (host)
+ *
+ * Packs consecutive readings of one hive into report_batch.h frames, as
+ * the sensor does with USE_REPORT_BATCH, and compares per reading:
+ * - bytes, time on air (channel occupancy) and TX charge
+ * - against one BuzzhivePacket (16 bytes, no features) or one
+ *   BuzzhiveFeaturePacket per wake
+ * for batches of 1-16 readings at 4, 6 and 8 bits per feature, and for
+ * readings the activity gate left without features. A batch
+ * that would pass BATCH_MAX_BYTES is sent early, as on the sensor.
+ * Every frame is decoded again and checked against its readings.
+ *
+ * Build & run from the repository root:
+ *   g++ -std=c++17 -O2 -I firmware/esp32-hive-sensor/src -I models \
+ *       tools/batch_uplink.cpp -o batch_uplink && ./batch_uplink [features.csv]
+ *
+ * features.csv holds raw feature rows (78 values per line) of one hive in
+ * report order; without it, rows follow a per-feature AR(1) process around
+ * a hive baseline (0.5 SD spread, 0.9 correlation between reports).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <random>
+#include <vector>
+#include "buzzhive_ml.h"
+#include "feature_packet.h"
+#include "report_batch.h"
+#include "lora_airtime.h"
+#include "dataset_lite.h"
+
+static const long BANDWIDTH_HZ = 125000;
+static const double TX_CURRENT_MA = 120.0;        // SX1276 at +20 dBm
+static const uint32_t REPORT_INTERVAL_S = 15 * 60;
+static const size_t SUMMARY_BYTES = 16;           // BuzzhivePacket
+
+static void makeCorrelated(std::vector<float>& rows, std::mt19937& rng) {
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    const float rho = 0.9f, spread = 0.5f;
+    float baseline[NUM_FEATURES], z[NUM_FEATURES];
+    for (int i = 0; i < NUM_FEATURES; i++) {
+        baseline[i] = normal(rng);
+        z[i] = spread * normal(rng);
+    }
+    for (int s = 0; s < SYNTHETIC_ROWS; s++) {
+        for (int i = 0; i < NUM_FEATURES; i++) {
+            z[i] = rho * z[i] + spread * sqrtf(1.0f - rho * rho) * normal(rng);
+            rows.push_back(MEAN[i] + (baseline[i] + z[i]) * SCALE[i]);
+        }
+    }
+}
+
+// Readings as the sensor takes them: features plus slowly drifting
+// temperature, humidity and battery; wake times jitter by a few seconds
+static std::vector<BatchReading> makeReadings(const std::vector<float>& rows, uint8_t bits,
+                                              bool features, std::mt19937& rng) {
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    std::vector<BatchReading> readings(rows.size() / NUM_FEATURES);
+    float temperature = 34.5f, humidity = 60.0f, battery = 4100.0f;
+    uint32_t timeS = 1000;
+    for (size_t r = 0; r < readings.size(); r++) {
+        BatchReading& reading = readings[r];
+        temperature += 0.1f * normal(rng);
+        humidity += 0.5f * normal(rng);
+        battery -= 0.5f;
+        timeS += REPORT_INTERVAL_S + 12 + (uint32_t)(rng() % 4);   // Recording + jitter
+        reading.timeS = timeS;
+        reading.temperature = (int16_t)(temperature * 100);
+        reading.humidity = (uint8_t)humidity;
+        reading.batteryMv = (uint16_t)(battery + 8.0f * normal(rng));
+        reading.status = features ? 1 : 3;   // GATE_ACTIVE / GATE_UNCHANGED
+        reading.flags = features ? READING_FEATURES : 0;
+        for (int i = 0; i < NUM_FEATURES; i++) {
+            reading.codes[i] = (int8_t)quantizeFeature(rows[r * NUM_FEATURES + i], i, bits);
+        }
+    }
+    return readings;
+}
+
+static bool sameReading(const BatchReading& a, const BatchReading& b) {
+    return a.temperature == b.temperature && a.humidity == b.humidity &&
+           a.batteryMv == b.batteryMv && a.status == b.status && a.flags == b.flags &&
+           (!(a.flags & READING_FEATURES) || memcmp(a.codes, b.codes, sizeof(a.codes)) == 0);
+}
+
+struct Totals {
+    size_t frames = 0;
+    size_t readings = 0;
+    size_t bytes = 0;
+    double airtimeUs = 0.0;
+    bool ok = true;
+};
+
+/**
+ * Batch readings the sensor's way: add one per wake, send at `perBatch`,
+ * or send what fits when the next reading would not
+ */
+static Totals batchAll(const std::vector<BatchReading>& readings, int perBatch, uint8_t bits, int sf) {
+    Totals t;
+    uint8_t frame[BATCH_MAX_BYTES];
+    std::vector<BatchReading> decoded(BATCH_MAX_READINGS);
+    size_t first = 0;
+    while (first < readings.size()) {
+        int count = 0;
+        size_t length = 0;
+        while (count < perBatch && first + count < readings.size()) {
+            uint32_t nowS = readings[first + count].timeS + 2;
+            size_t next = batchEncode(&readings[first], count + 1, 1, (uint16_t)first, bits, nowS,
+                                      frame, sizeof(frame));
+            if (next == 0) break;
+            length = next;
+            count++;
+        }
+        if (count == 0) {
+            t.ok = false;
+            break;
+        }
+        // Re-encode what is sent and check it decodes back
+        uint32_t nowS = readings[first + count - 1].timeS + 2;
+        length = batchEncode(&readings[first], count, 1, (uint16_t)first, bits, nowS, frame, sizeof(frame));
+        BatchHeader header;
+        if (!batchValid(frame, length) || !batchDecode(frame, length, header, decoded.data()) ||
+            header.count != count || header.sequence != (uint16_t)first) {
+            t.ok = false;
+        } else {
+            for (int r = 0; r < count; r++) {
+                const BatchReading& original = readings[first + r];
+                if (!sameReading(original, decoded[r]) || decoded[r].timeS != nowS - original.timeS) {
+                    t.ok = false;
+                }
+            }
+        }
+        t.frames++;
+        t.readings += count;
+        t.bytes += length;
+        t.airtimeUs += loraAirtimeUs(length, sf, BANDWIDTH_HZ);
+        first += count;
+    }
+    return t;
+}
+
+int main(int argc, char** argv) {
+    std::mt19937 rng(7);
+    const char* csv = argc > 1 ? argv[1] : nullptr;
+    std::vector<float> rows;
+    if (csv) {
+        if (!loadCsv(csv, rows) || rows.empty()) {
+            fprintf(stderr, "error: no rows in %s\n", csv);
+            return 1;
+        }
+    } else {
+        makeCorrelated(rows, rng);
+    }
+    printf("%zu readings (%s), frames up to %d bytes, 125 kHz, CR 4/5\n",
+           rows.size() / NUM_FEATURES, csv ? csv : "synthetic", BATCH_MAX_BYTES);
+
+    const int sfs[] = {10, 7};
+    const int batchSizes[] = {1, 2, 4, 6, 8, 12, 16};
+    const uint8_t widths[] = {4, 6, 8, 0};   // 0: gated wakes, no features
+    bool ok = true;
+    for (int sf : sfs) {
+        double summaryMs = loraAirtimeUs(SUMMARY_BYTES, sf, BANDWIDTH_HZ) / 1000.0;
+        printf("\nSF%d: summary packet %zu bytes, %.1f ms per reading\n", sf, SUMMARY_BYTES, summaryMs);
+        for (uint8_t width : widths) {
+            std::mt19937 readingRng(3);
+            uint8_t bits = width ? width : FEATURE_MIN_BITS;
+            std::vector<BatchReading> readings = makeReadings(rows, bits, width != 0, readingRng);
+            size_t packetBytes = width ? featurePacketSize(bits) : SUMMARY_BYTES;
+            double packetMs = loraAirtimeUs(packetBytes, sf, BANDWIDTH_HZ) / 1000.0;
+            if (width) {
+                printf("  %d-bit features: feature packet %zu bytes, %.1f ms per reading\n",
+                       bits, packetBytes, packetMs);
+            } else {
+                printf("  Gated wakes (no features): vs packet = vs summary\n");
+            }
+            printf("    %6s %10s %10s %10s %12s %12s %10s\n", "batch", "per frame", "bytes/rdg",
+                   "ms/rdg", "vs packet", "vs summary", "mC/rdg");
+            for (int n : batchSizes) {
+                Totals t = batchAll(readings, n, bits, sf);
+                ok = ok && t.ok;
+                double perReadingMs = t.airtimeUs / 1000.0 / t.readings;
+                printf("    %6d %10.1f %10.1f %10.1f %11.1fx %11.1fx %10.2f%s\n", n,
+                       (double)t.readings / t.frames, (double)t.bytes / t.readings, perReadingMs,
+                       packetMs / perReadingMs, summaryMs / perReadingMs,
+                       TX_CURRENT_MA * perReadingMs / 1000.0, t.ok ? "" : "  ROUND-TRIP FAILED");
+            }
+        }
+    }
+    printf("\n  vs packet / vs summary: less time on air (and TX charge) per reading\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+/**
+ * Table vs Code-Generated Tree Ensemble Benchmark (host)
+ *
+ * Compares the two compile-time backends of the base station for one
+ * model size:
+ * - table:   xgboost_model.h      (TreeEnsemble node tables, walked by
+ *                                  tree_ensemble.h; USE_COMPILED_MODEL)
+ * - codegen: xgboost_model_code.h (straight-line compares; USE_CODEGEN_MODEL)
+ * Reports flash bytes, RAM, latency per sample and whether both give
+ * bit-identical probabilities.
+ *
+ * Code size is measured by placing the generated functions in their own
+ * section. It is x86-64 code without the float constants the compiler
+ * pools elsewhere; Xtensa sizes differ, so read `pio run` size output for
+ * the firmware. Both backends keep everything in flash (0 bytes of RAM)
+ * unless XGB_CODE_ATTR puts the code in IRAM, which then costs the code
+ * size in IRAM.
+ *
+ * Build & run from the repository root, once per model size (100, 200 and
+ * 800 trees for the 4-class model):
+ *   for r in 25 50 200; do
+ *     ./xgb_convert models/xgboost_queen_detector.json --rounds $r -o xgboost_model.h
+ *     ./xgb_convert models/xgboost_queen_detector.json --rounds $r --codegen
+ *     g++ -std=c++17 -O2 -I . -I firmware/esp32-base-station/src \
+ *         tools/bench_codegen.cpp -o bench_codegen && ./bench_codegen [features.csv]
+ *   done
+ * Pass the same --calibrate options to both conversions to compare the
+ * early-exit versions.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "buzzhive_ml.h"
+#include "tree_ensemble.h"
+#include "dataset_lite.h"
+#include "bench_timer.h"
+
+#define XGB_CODE_ATTR __attribute__((section("xgb_code")))
+#include "xgboost_model.h"
+#include "xgboost_model_code.h"
+
+// Linker-provided bounds of the xgb_code section
+extern "C" const char __start_xgb_code[];
+extern "C" const char __stop_xgb_code[];
+
+static const int REPEATS = 5;
+
+static void predictTable(const float* features, float* probs) {
+    ensemblePredictCascade(XGB_MODEL, XGB_CASCADE, features, probs);
+}
+
+static void predictCode(const float* features, float* probs) {
+    xgbCodePredict(features, probs);
+}
+
+// Best-of-REPEATS microseconds per sample on normalized rows
+template <class Fn>
+static double timePerSample(const std::vector<float>& rows, Fn predict) {
+    size_t count = rows.size() / NUM_FEATURES;
+    double best = 1e30;
+    for (int r = 0; r < REPEATS; r++) {
+        double t0 = nowMicros();
+        for (size_t s = 0; s < count; s++) {
+            float probs[NUM_CLASSES];
+            predict(&rows[s * NUM_FEATURES], probs);
+            doNotOptimize(probs[0]);
+        }
+        double us = (nowMicros() - t0) / count;
+        if (us < best) best = us;
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    if (XGB_CODE_NUM_TREES != XGB_MODEL.numTrees) {
+        fprintf(stderr, "error: xgboost_model.h has %u trees, xgboost_model_code.h %u; convert both with the same --rounds\n",
+                (unsigned)XGB_MODEL.numTrees, (unsigned)XGB_CODE_NUM_TREES);
+        return 1;
+    }
+
+    const char* csv = argc > 1 ? argv[1] : nullptr;
+    std::vector<float> rows;
+    if (csv) {
+        if (!loadCsv(csv, rows) || rows.empty()) {
+            fprintf(stderr, "error: no samples in %s\n", csv);
+            return 1;
+        }
+    } else {
+        makeSynthetic(rows);
+    }
+    size_t count = rows.size() / NUM_FEATURES;
+    for (size_t s = 0; s < count; s++) {
+        for (int i = 0; i < NUM_FEATURES; i++) {
+            rows[s * NUM_FEATURES + i] = (rows[s * NUM_FEATURES + i] - MEAN[i]) / SCALE[i];
+        }
+    }
+
+    size_t identical = 0;
+    for (size_t s = 0; s < count; s++) {
+        float a[NUM_CLASSES], b[NUM_CLASSES];
+        predictTable(&rows[s * NUM_FEATURES], a);
+        predictCode(&rows[s * NUM_FEATURES], b);
+        if (memcmp(a, b, sizeof(a)) == 0) identical++;
+    }
+
+    size_t tableBytes = sizeof(XGB_NODES) + sizeof(XGB_TREE_ROOTS) + sizeof(XGB_TREE_CLASS);
+    size_t codeBytes = (size_t)(__stop_xgb_code - __start_xgb_code);
+    double tableUs = timePerSample(rows, predictTable);
+    double codeUs = timePerSample(rows, predictCode);
+
+    printf("%u trees, %zu samples (%s)\n", (unsigned)XGB_MODEL.numTrees, count, csv ? csv : "synthetic");
+    printf("  %-10s %12s %14s %12s\n", "backend", "flash bytes", "RAM (IRAM)", "us/sample");
+    printf("  %-10s %12zu %14s %12.2f\n", "table", tableBytes, "0", tableUs);
+    char ram[32];
+    snprintf(ram, sizeof(ram), "0 (%zu)", codeBytes);
+    printf("  %-10s %12zu %14s %12.2f\n", "codegen", codeBytes, ram, codeUs);
+    printf("  identical probabilities: %zu / %zu\n", identical, count);
+    return identical == count ? 0 : 1;
+}
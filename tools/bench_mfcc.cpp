@@ -0,0 +1,151 @@
+/**
+ * MFCC Stage Benchmark (host)
+ *
+ * Times the per-frame DCT stage of the hive sensor MFCC pipeline: the
+ * original O(N^2) loop with a cos() per term against the cached-basis
+ * DCT2 from dct.h. Also reports the full per-frame cost (FFT + mel + log
+ * + DCT) for context.
+ *
+ * The second part compares the fixed-point kernel (mfcc_fixed.h) against
+ * the float extractMFCC() on synthetic 10 s clips at several levels:
+ * feature error in raw and StandardScaler units, and clip throughput.
+ *
+ * Exits non-zero if the cached-basis DCT is off by more than
+ * DCT_TOLERANCE.
+ *
+ * Build & run from the repository root:
+ *   g++ -std=c++17 -O2 -I firmware/esp32-hive-sensor/src -I models \
+ *       tools/bench_mfcc.cpp -o bench_mfcc && ./bench_mfcc
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "mfcc.h"
+#include "mfcc_fixed.h"
+#include "buzzhive_ml.h"
+#include "bench_timer.h"
+
+static const int ITERATIONS = 20000;
+
+// Largest |cached - reference| DCT output on the -80..0 dB test frame:
+// float rounding gives ~2e-5, a wrong basis entry far more
+static const double DCT_TOLERANCE = 1e-3;
+
+// The DCT that mfcc.h used before the cached basis: one cos() per (k, i)
+static void dctReference(const float* input, float* output) {
+    for (int k = 0; k < N_MFCC; k++) {
+        float sum = 0.0;
+        for (int i = 0; i < N_MELS; i++) {
+            sum += input[i] * cos(M_PI * k * (2 * i + 1) / (2.0 * N_MELS));
+        }
+        output[k] = sum;
+    }
+}
+
+static const int SAMPLE_RATE = 22050;
+static const int CLIP_SAMPLES = SAMPLE_RATE * 10;
+
+// Hive-like test clip: 200-500 Hz harmonics with slow amplitude modulation
+// plus broadband noise, at the given peak level (full scale = 1.0)
+static void makeClip(std::vector<int16_t>& clip, double level, unsigned seed) {
+    srand(seed);
+    clip.resize(CLIP_SAMPLES);
+    double f0 = 200.0 + 300.0 * rand() / RAND_MAX;
+    for (int i = 0; i < CLIP_SAMPLES; i++) {
+        double t = (double)i / SAMPLE_RATE;
+        double env = 0.6 + 0.4 * sin(2.0 * M_PI * 0.3 * t);
+        double v = 0.0;
+        for (int h = 1; h <= 5; h++) v += sin(2.0 * M_PI * f0 * h * t) / h;
+        v = 0.35 * env * v + 0.15 * (2.0 * rand() / RAND_MAX - 1.0);
+        clip[i] = (int16_t)(level * 32767.0 * (v > 1.0 ? 1.0 : (v < -1.0 ? -1.0 : v)));
+    }
+}
+
+static void reportFixedPoint() {
+    const double levels[] = {1.0, 0.1, 0.01};
+    std::vector<int16_t> clip;
+    float ref[N_FEATURES];
+    float fixedOut[N_FEATURES];
+
+    printf("\nFixed-point (Q15) vs float extractMFCC(), 10 s clips\n");
+    printf("  level    max |err|   max |err|/SCALE   feature\n");
+    double floatUs = 0.0, fixedUs = 0.0;
+    int clips = 0;
+    for (double level : levels) {
+        for (unsigned seed = 1; seed <= 3; seed++) {
+            makeClip(clip, level, seed);
+            double t0 = nowMicros();
+            extractMFCC(clip.data(), clip.size(), SAMPLE_RATE, ref);
+            double t1 = nowMicros();
+            extractMFCCFixed(clip.data(), clip.size(), SAMPLE_RATE, fixedOut);
+            double t2 = nowMicros();
+            floatUs += t1 - t0;
+            fixedUs += t2 - t1;
+            clips++;
+
+            double maxErr = 0.0, maxScaled = 0.0;
+            int worst = 0;
+            for (int i = 0; i < N_FEATURES; i++) {
+                double err = fabs(ref[i] - fixedOut[i]);
+                if (err > maxErr) maxErr = err;
+                if (err / SCALE[i] > maxScaled) {
+                    maxScaled = err / SCALE[i];
+                    worst = i;
+                }
+            }
+            printf("  %5.2f   %9.4f   %15.5f   %7d\n", level, maxErr, maxScaled, worst);
+        }
+    }
+    printf("  float: %8.1f ms/clip   fixed: %8.1f ms/clip\n", floatUs / clips / 1000.0, fixedUs / clips / 1000.0);
+}
+
+template <typename Fn>
+static double cyclesPerCall(Fn fn, int iterations) {
+    uint64_t start = cycleCount();
+    for (int i = 0; i < iterations; i++) fn();
+    return (double)(cycleCount() - start) / iterations;
+}
+
+int main() {
+    float mel[N_MELS];
+    float out[N_MFCC];
+    srand(42);
+    for (int i = 0; i < N_MELS; i++) mel[i] = -80.0f + 80.0f * rand() / RAND_MAX;
+
+    double before = cyclesPerCall([&] { dctReference(mel, out); doNotOptimize(out[0]); }, ITERATIONS);
+    double after = cyclesPerCall([&] { mfccDct.compute(mel, out); doNotOptimize(out[0]); }, ITERATIONS);
+
+    // Cached basis is orthonormal; the reference is unscaled
+    float ref[N_MFCC];
+    dctReference(mel, ref);
+    mfccDct.compute(mel, out);
+    double maxErr = 0.0;
+    for (int k = 0; k < N_MFCC; k++) {
+        double scale = (k == 0) ? sqrt(1.0 / N_MELS) : sqrt(2.0 / N_MELS);
+        double err = fabs(ref[k] * scale - out[k]);
+        if (err > maxErr) maxErr = err;
+    }
+
+    static int16_t frame[N_FFT];
+    for (int i = 0; i < N_FFT; i++) frame[i] = (int16_t)((rand() % 20000) - 10000);
+    static float spectrum[N_BINS];
+    const MelFilterbank* fb = getMelFilterbank(22050);
+    double frameCycles = cyclesPerCall([&] {
+        computePowerSpectrum(frame, spectrum);
+        applyMelFilterbank(fb, spectrum, mel);
+        for (int m = 0; m < N_MELS; m++) mel[m] = 10.0f * log10f(mel[m] > 1e-10f ? mel[m] : 1e-10f);
+        mfccDct.compute(mel, out);
+        doNotOptimize(out[0]);
+    }, ITERATIONS / 10);
+
+    printf("DCT-II %d -> %d, %d iterations\n", N_MELS, N_MFCC, ITERATIONS);
+    printf("  cos() per term:   %10.0f cycles/frame\n", before);
+    printf("  cached basis:     %10.0f cycles/frame  (%.1fx)\n", after, before / after);
+    printf("  max |error|:      %10.2e  (limit %.0e) -> %s\n", maxErr, DCT_TOLERANCE,
+           maxErr <= DCT_TOLERANCE ? "PASS" : "FAIL");
+    printf("Full frame (FFT %d + mel + log + DCT): %.0f cycles/frame\n", N_FFT, frameCycles);
+
+    reportFixedPoint();
+    return maxErr <= DCT_TOLERANCE ? 0 : 1;
+}
@@ -0,0 +1,311 @@
+/**
+ * Tree Ensemble Benchmark (host)
+ *
+ * Compares the two compiled model formats of the base station on the same
+ * samples:
+ * - TreeEnsemble:  normalizeFeatures() + float thresholds, 8-byte nodes
+ * - QuantEnsemble: scaler folded in, 16-bit bins, 4-byte nodes
+ * Reports model size, latency per sample and whether the class
+ * probabilities match bit for bit. If the images carry calibrated
+ * early-exit stages (xgb_convert --calibrate), the cascade is timed too,
+ * with its mean tree count and class agreement against the full ensemble.
+ *
+ * The batch section compares single-sample scoring with the feature-major
+ * batch API (ensemblePredictBatch / quantPredictBatch) in samples per
+ * second, and checks that both give bit-identical probabilities.
+ *
+ * The uplink section feeds the float ensemble features the way the base
+ * station gets them from a sensor (feature_packet.h, report_batch.h):
+ * quantized at each width 4-8 bits and dequantized again. It prints how
+ * often the class matches the one from the raw features, and the largest
+ * probability difference. Check the width a sensor uses here before
+ * lowering FEATURE_BITS or REPORT_BATCH_FEATURE_BITS.
+ *
+ * The dual-core section times the full ensemble split across a worker
+ * thread and the calling thread (parallel_ensemble.h, std::thread backend)
+ * against one thread, with class agreement and the largest probability
+ * difference (the split only changes the rounding of one add per class).
+ * Run it on a machine with at least two free cores.
+ *
+ * Both models are loaded as binary images through model_store.h, the
+ * same mmap + parseModelImage() path the base station uses on flash.
+ *
+ * Generate both images, then build & run from the repository root:
+ *   ./xgb_convert models/xgboost_queen_detector.json --binary
+ *   ./xgb_convert models/xgboost_queen_detector.json --binary --quantized
+ *   g++ -std=c++17 -O2 -pthread -I firmware/esp32-base-station/src \
+ *       -I firmware/esp32-hive-sensor/src tools/bench_trees.cpp -o bench_trees
+ *   ./bench_trees xgboost_model.bin xgboost_model_quant.bin [features.csv]
+ *
+ * features.csv holds one sample per line: 78 raw features, comma
+ * separated (extra trailing columns such as a label are ignored). Without
+ * it, synthetic samples are drawn from the scaler's mean and scale.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include "buzzhive_ml.h"
+#include "tree_ensemble.h"
+#include "model_store.h"
+#include "feature_packet.h"
+#include "parallel_ensemble.h"
+#include "dataset_lite.h"
+#include "bench_timer.h"
+
+static const int REPEATS = 5;
+
+// Same arithmetic as normalizeFeatures() in xgboost_inference.h
+static void normalizeFeatures(const float* raw, float* normalized) {
+    for (int i = 0; i < NUM_FEATURES; i++) {
+        normalized[i] = (raw[i] - MEAN[i]) / SCALE[i];
+    }
+}
+
+static ModelImage floatModel;
+static ModelImage quantModel;
+
+static void predictFloat(const float* raw, float* probs) {
+    float normalized[NUM_FEATURES];
+    normalizeFeatures(raw, normalized);
+    ensemblePredict(floatModel.trees, normalized, probs);
+}
+
+static void predictQuant(const float* raw, float* probs) {
+    quantPredict(quantModel.quant, raw, probs);
+}
+
+// As the base station decodes a sensor's features sent at `bits`
+static void predictUplink(const float* raw, uint8_t bits, float* probs) {
+    float normalized[NUM_FEATURES];
+    for (int i = 0; i < NUM_FEATURES; i++) {
+        normalized[i] = dequantizeFeature(quantizeFeature(raw[i], i, bits), bits);
+    }
+    ensemblePredict(floatModel.trees, normalized, probs);
+}
+
+static DualCoreEnsemble dualCore;
+
+static void predictFloatDual(const float* raw, float* probs) {
+    float normalized[NUM_FEATURES];
+    normalizeFeatures(raw, normalized);
+    dualCore.predict(floatModel.trees, normalized, probs);
+}
+
+static void predictQuantDual(const float* raw, float* probs) {
+    dualCore.predict(quantModel.quant, raw, probs);
+}
+
+static void predictQuantCascade(const float* raw, float* probs) {
+    quantPredictCascade(quantModel.quant, quantModel.cascade, raw, probs);
+}
+
+static int argmax(const float* v) {
+    int best = 0;
+    for (int c = 1; c < NUM_CLASSES; c++) {
+        if (v[c] > v[best]) best = c;
+    }
+    return best;
+}
+
+static bool loadModel(const char* path, ModelKind kind, MappedModel* mapped, ModelImage* model) {
+    ModelStatus status = openModel(path, mapped, model);
+    if (status != MODEL_OK) {
+        fprintf(stderr, "error: %s: %s\n", path, modelStatusName(status));
+        return false;
+    }
+    if (model->kind != kind) {
+        fprintf(stderr, "error: %s: expected a %s model\n", path, kind == MODEL_KIND_FLOAT ? "float" : "quantized");
+        return false;
+    }
+    return true;
+}
+
+// Best-of-REPEATS microseconds per sample
+template <class Fn>
+static double timePerSample(const std::vector<float>& samples, Fn predict) {
+    size_t count = samples.size() / NUM_FEATURES;
+    double best = 1e30;
+    for (int r = 0; r < REPEATS; r++) {
+        double t0 = nowMicros();
+        for (size_t s = 0; s < count; s++) {
+            float probs[NUM_CLASSES];
+            predict(&samples[s * NUM_FEATURES], probs);
+            doNotOptimize(probs[0]);
+        }
+        double us = (nowMicros() - t0) / count;
+        if (us < best) best = us;
+    }
+    return best;
+}
+
+// Best-of-REPEATS microseconds per sample for a whole-set batch call
+template <class Fn>
+static double timeBatch(size_t count, Fn predictAll) {
+    double best = 1e30;
+    for (int r = 0; r < REPEATS; r++) {
+        double t0 = nowMicros();
+        predictAll();
+        double us = (nowMicros() - t0) / count;
+        if (us < best) best = us;
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: bench_trees <model.bin> <model_quant.bin> [features.csv]\n");
+        return 2;
+    }
+    MappedModel floatMap, quantMap;
+    if (!loadModel(argv[1], MODEL_KIND_FLOAT, &floatMap, &floatModel)) return 1;
+    if (!loadModel(argv[2], MODEL_KIND_QUANTIZED, &quantMap, &quantModel)) return 1;
+
+    const char* csv = argc > 3 ? argv[3] : nullptr;
+    std::vector<float> samples;
+    if (csv) {
+        if (!loadCsv(csv, samples) || samples.empty()) {
+            fprintf(stderr, "error: no samples in %s\n", csv);
+            return 1;
+        }
+    } else {
+        makeSynthetic(samples);
+    }
+    size_t count = samples.size() / NUM_FEATURES;
+
+    // Agreement
+    size_t identical = 0;
+    size_t sameClass = 0;
+    for (size_t s = 0; s < count; s++) {
+        float a[NUM_CLASSES], b[NUM_CLASSES];
+        predictFloat(&samples[s * NUM_FEATURES], a);
+        predictQuant(&samples[s * NUM_FEATURES], b);
+        if (memcmp(a, b, sizeof(a)) == 0) identical++;
+        if (argmax(a) == argmax(b)) sameClass++;
+    }
+
+    // Cascade on the quantized model
+    size_t cascadeSameClass = 0;
+    double cascadeTrees = 0.0;
+    for (size_t s = 0; s < count; s++) {
+        float full[NUM_CLASSES], early[NUM_CLASSES];
+        predictQuant(&samples[s * NUM_FEATURES], full);
+        cascadeTrees += quantPredictCascade(quantModel.quant, quantModel.cascade,
+                                            &samples[s * NUM_FEATURES], early);
+        if (argmax(full) == argmax(early)) cascadeSameClass++;
+    }
+    cascadeTrees /= count;
+
+    ModelImageHeader floatHeader, quantHeader;
+    memcpy(&floatHeader, floatMap.data, sizeof(floatHeader));
+    memcpy(&quantHeader, quantMap.data, sizeof(quantHeader));
+    size_t floatBytes = sizeof(ModelImageHeader) + floatHeader.payloadBytes;
+    size_t quantBytes = sizeof(ModelImageHeader) + quantHeader.payloadBytes;
+
+    double floatUs = timePerSample(samples, predictFloat);
+    double quantUs = timePerSample(samples, predictQuant);
+    double cascadeUs = timePerSample(samples, predictQuantCascade);
+
+    printf("Tree ensemble: %u trees, %zu samples (%s)\n", (unsigned)floatModel.trees.numTrees, count,
+           csv ? csv : "synthetic");
+    printf("  %-28s %10s %12s\n", "format", "image bytes", "us/sample");
+    printf("  %-28s %10zu %12.2f\n", "float thresholds (8 B node)", floatBytes, floatUs);
+    printf("  %-28s %10zu %12.2f\n", "quantized bins (4 B node)", quantBytes, quantUs);
+    printf("  identical probabilities: %zu / %zu, same class: %zu / %zu\n",
+           identical, count, sameClass, count);
+    if (quantModel.cascade.numStages > 0) {
+        printf("  %-28s %10s %12.2f\n", "quantized + cascade", "", cascadeUs);
+        printf("  cascade: %u stages, %.1f trees per sample (%.2fx fewer), same class as full: %zu / %zu\n",
+               (unsigned)quantModel.cascade.numStages, cascadeTrees,
+               quantModel.quant.numTrees / cascadeTrees, cascadeSameClass, count);
+    }
+
+    // Quantized uplink widths against the raw features
+    printf("  %-33s %10s %10s\n", "uplink features (float model):", "same class", "max diff");
+    for (int bits = FEATURE_MAX_BITS; bits >= FEATURE_MIN_BITS; bits--) {
+        size_t uplinkSameClass = 0;
+        float uplinkMaxDiff = 0.0f;
+        for (size_t s = 0; s < count; s++) {
+            float raw[NUM_CLASSES], sent[NUM_CLASSES];
+            predictFloat(&samples[s * NUM_FEATURES], raw);
+            predictUplink(&samples[s * NUM_FEATURES], (uint8_t)bits, sent);
+            if (argmax(raw) == argmax(sent)) uplinkSameClass++;
+            for (int c = 0; c < NUM_CLASSES; c++) uplinkMaxDiff = fmaxf(uplinkMaxDiff, fabsf(raw[c] - sent[c]));
+        }
+        char label[16];
+        snprintf(label, sizeof(label), "%d bits", bits);
+        printf("  %-33s %9.1f%% %10.1e\n", label, 100.0 * uplinkSameClass / count, uplinkMaxDiff);
+    }
+
+    // Batch API on feature-major copies of the samples
+    std::vector<float> rawSoA(samples.size());
+    for (size_t s = 0; s < count; s++) {
+        for (int f = 0; f < NUM_FEATURES; f++) rawSoA[f * count + s] = samples[s * NUM_FEATURES + f];
+    }
+    std::vector<float> normalizedSoA(samples.size());
+    std::vector<float> single(count * NUM_CLASSES), batch(count * NUM_CLASSES);
+
+    auto floatBatch = [&] {
+        for (int f = 0; f < NUM_FEATURES; f++) {
+            for (size_t s = 0; s < count; s++) {
+                normalizedSoA[f * count + s] = (rawSoA[f * count + s] - MEAN[f]) / SCALE[f];
+            }
+        }
+        ensemblePredictBatch(floatModel.trees, normalizedSoA.data(), count, count, batch.data());
+    };
+    auto quantBatch = [&] {
+        quantPredictBatch(quantModel.quant, rawSoA.data(), count, count, batch.data());
+    };
+
+    for (size_t s = 0; s < count; s++) predictFloat(&samples[s * NUM_FEATURES], &single[s * NUM_CLASSES]);
+    floatBatch();
+    bool floatBatchIdentical = memcmp(single.data(), batch.data(), single.size() * sizeof(float)) == 0;
+    for (size_t s = 0; s < count; s++) predictQuant(&samples[s * NUM_FEATURES], &single[s * NUM_CLASSES]);
+    quantBatch();
+    bool quantBatchIdentical = memcmp(single.data(), batch.data(), single.size() * sizeof(float)) == 0;
+
+    double floatBatchUs = timeBatch(count, floatBatch);
+    double quantBatchUs = timeBatch(count, quantBatch);
+
+    printf("  batch API (%d-sample blocks):    %12s %12s %10s\n", TREE_BATCH_BLOCK, "single/s", "batch/s", "identical");
+    printf("  %-33s %12.0f %12.0f %10s\n", "float thresholds", 1e6 / floatUs, 1e6 / floatBatchUs,
+           floatBatchIdentical ? "yes" : "NO");
+    printf("  %-33s %12.0f %12.0f %10s\n", "quantized bins", 1e6 / quantUs, 1e6 / quantBatchUs,
+           quantBatchIdentical ? "yes" : "NO");
+
+    // Dual-core split of the full ensemble
+    dualCore.begin(1);
+    size_t dualSameClass[2] = {0, 0};
+    float dualMaxDiff[2] = {0.0f, 0.0f};
+    for (size_t s = 0; s < count; s++) {
+        const float* x = &samples[s * NUM_FEATURES];
+        float one[NUM_CLASSES], two[NUM_CLASSES];
+        for (int k = 0; k < 2; k++) {
+            if (k == 0) {
+                predictFloat(x, one);
+                predictFloatDual(x, two);
+            } else {
+                predictQuant(x, one);
+                predictQuantDual(x, two);
+            }
+            if (argmax(one) == argmax(two)) dualSameClass[k]++;
+            for (int c = 0; c < NUM_CLASSES; c++) dualMaxDiff[k] = fmaxf(dualMaxDiff[k], fabsf(one[c] - two[c]));
+        }
+    }
+    double floatDualUs = timePerSample(samples, predictFloatDual);
+    double quantDualUs = timePerSample(samples, predictQuantDual);
+    dualCore.end();
+
+    printf("  dual-core split (us/sample):     %12s %12s %10s %10s\n", "1 core", "2 cores", "same class", "max diff");
+    printf("  %-33s %12.2f %12.2f %10zu %10.1e\n", "float thresholds", floatUs, floatDualUs,
+           dualSameClass[0], dualMaxDiff[0]);
+    printf("  %-33s %12.2f %12.2f %10zu %10.1e\n", "quantized bins", quantUs, quantDualUs,
+           dualSameClass[1], dualMaxDiff[1]);
+
+    unmapModel(&floatMap);
+    unmapModel(&quantMap);
+    return (identical == count && floatBatchIdentical && quantBatchIdentical &&
+            dualSameClass[0] == count && dualSameClass[1] == count) ? 0 : 1;
+}
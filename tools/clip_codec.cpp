@@ -0,0 +1,264 @@
+/**
+ * Audio Clip Codec Round Trip (host)
+ *
+ * Runs a clip through the sensor's clip encoder (audio_compression.h) and
+ * the base station's decoder, once at the capture rate and once
+ * downsampled to 8 kHz, and reports:
+ * - bytes on air and compression against 16-bit PCM at the capture rate
+ * - ADPCM SNR, decoded vs the (downsampled) input the encoder saw
+ * - encoder and decoder throughput in samples/s of captured audio
+ * - at the capture rate, the MFCC features the base station re-extracts
+ *   from the decoded clip vs the original, in StandardScaler units
+ *
+ * Build & run from the repository root:
+ *   g++ -std=c++17 -O2 -I firmware/esp32-hive-sensor/src -I models \
+ *       tools/clip_codec.cpp -o clip_codec && ./clip_codec [clip.wav] [-o decoded.wav]
+ *
+ * clip.wav is 16-bit PCM (first channel used); without it a synthetic
+ * 10 s hive-like clip at 22050 Hz is used. -o writes the decoded 8 kHz
+ * clip for listening.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include "audio_compression.h"
+#include "audio_conditioning.h"
+#include "mfcc.h"
+#include "buzzhive_ml.h"
+#include "bench_timer.h"
+
+static const int SYNTHETIC_RATE = 22050;
+static const int SYNTHETIC_SECONDS = 10;
+static const int LABEL_RATE = 8000;
+static const int REPEATS = 5;
+static const int CHUNK = 512;   // I2S_CHUNK_SAMPLES on the sensor
+
+static uint32_t readLe(const uint8_t* p, int bytes) {
+    uint32_t v = 0;
+    for (int i = bytes - 1; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+// 16-bit PCM WAV, first channel
+static bool loadWav(const char* path, std::vector<int16_t>& samples, int& rate) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    std::vector<uint8_t> data;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + n);
+    fclose(f);
+    if (data.size() < 12 || memcmp(&data[0], "RIFF", 4) != 0 || memcmp(&data[8], "WAVE", 4) != 0) {
+        return false;
+    }
+
+    int channels = 0, bits = 0;
+    size_t pos = 12;
+    while (pos + 8 <= data.size()) {
+        uint32_t size = readLe(&data[pos + 4], 4);
+        const uint8_t* body = &data[pos + 8];
+        if (pos + 8 + size > data.size()) size = (uint32_t)(data.size() - pos - 8);
+        if (memcmp(&data[pos], "fmt ", 4) == 0 && size >= 16) {
+            channels = (int)readLe(body + 2, 2);
+            rate = (int)readLe(body + 4, 4);
+            bits = (int)readLe(body + 14, 2);
+        } else if (memcmp(&data[pos], "data", 4) == 0 && channels > 0) {
+            if (bits != 16) return false;
+            size_t frames = size / (2 * channels);
+            samples.resize(frames);
+            for (size_t i = 0; i < frames; i++) {
+                samples[i] = (int16_t)readLe(body + i * 2 * channels, 2);
+            }
+            return true;
+        }
+        pos += 8 + size + (size & 1);
+    }
+    return false;
+}
+
+static bool writeWav(const char* path, const std::vector<int16_t>& samples, int rate) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    uint32_t dataBytes = (uint32_t)(samples.size() * 2);
+    uint8_t h[44];
+    auto put = [&](int at, uint32_t v, int bytes) {
+        for (int i = 0; i < bytes; i++) h[at + i] = (uint8_t)(v >> (8 * i));
+    };
+    memcpy(h, "RIFF", 4);
+    put(4, 36 + dataBytes, 4);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    put(16, 16, 4);
+    put(20, 1, 2);          // PCM
+    put(22, 1, 2);          // Mono
+    put(24, rate, 4);
+    put(28, rate * 2, 4);
+    put(32, 2, 2);
+    put(34, 16, 2);
+    memcpy(h + 36, "data", 4);
+    put(40, dataBytes, 4);
+    bool ok = fwrite(h, 1, sizeof(h), f) == sizeof(h) &&
+              fwrite(samples.data(), 2, samples.size(), f) == samples.size();
+    fclose(f);
+    return ok;
+}
+
+// Hive-like test clip: 200-500 Hz harmonics with slow amplitude modulation
+// plus broadband noise, peaking around -10 dBFS
+static void makeClip(std::vector<int16_t>& clip, int rate) {
+    srand(7);
+    clip.resize(rate * SYNTHETIC_SECONDS);
+    double f0 = 240.0;
+    for (size_t i = 0; i < clip.size(); i++) {
+        double t = (double)i / rate;
+        double env = 0.6 + 0.4 * sin(2.0 * M_PI * 0.3 * t);
+        double v = 0.0;
+        for (int h = 1; h <= 5; h++) v += sin(2.0 * M_PI * f0 * h * t) / h;
+        v = 0.35 * env * v + 0.15 * (2.0 * rand() / RAND_MAX - 1.0);
+        clip[i] = (int16_t)(0.3 * 32767.0 * (v > 1.0 ? 1.0 : (v < -1.0 ? -1.0 : v)));
+    }
+}
+
+// Encode in capture-sized chunks, as the sensor does
+static void encodeClip(const std::vector<int16_t>& input, int inRate, int outRate,
+                       std::vector<uint8_t>& buffer, AudioClipEncoder& encoder) {
+    size_t capacity = ADPCM_CLIP_BLOCKS(input.size() * (size_t)outRate / inRate + 1);
+    buffer.assign(capacity * ADPCM_BLOCK_BYTES, 0);
+    encoder.begin(inRate, outRate, buffer.data(), capacity);
+    for (size_t i = 0; i < input.size(); i += CHUNK) {
+        size_t n = input.size() - i < (size_t)CHUNK ? input.size() - i : (size_t)CHUNK;
+        encoder.push(&input[i], n);
+    }
+    encoder.finish();
+}
+
+static void decodeClip(const AudioClipEncoder& encoder, std::vector<int16_t>& out) {
+    out.resize(encoder.blockCount() * ADPCM_BLOCK_SAMPLES);
+    for (size_t b = 0; b < encoder.blockCount(); b++) {
+        adpcmDecodeBlock(encoder.block(b), &out[b * ADPCM_BLOCK_SAMPLES]);
+    }
+    out.resize(encoder.sampleCount());
+}
+
+// What the encoder saw: the input after the downsampler alone
+static void downsample(const std::vector<int16_t>& input, int inRate, int outRate,
+                       std::vector<int16_t>& out) {
+    AudioDownsampler ds;
+    ds.begin(inRate, outRate);
+    out.resize(ds.maxOutput(input.size()));
+    out.resize(ds.process(input.data(), input.size(), out.data()));
+}
+
+static double snrDb(const std::vector<int16_t>& ref, const std::vector<int16_t>& test) {
+    double signal = 0.0, noise = 0.0;
+    size_t n = ref.size() < test.size() ? ref.size() : test.size();
+    for (size_t i = 0; i < n; i++) {
+        double d = (double)ref[i] - test[i];
+        signal += (double)ref[i] * ref[i];
+        noise += d * d;
+    }
+    return noise > 0.0 ? 10.0 * log10(signal / noise) : INFINITY;
+}
+
+// The base station's re-analysis path (extractClipFeatures)
+static void clipFeatures(const std::vector<int16_t>& clip, int rate, float* features) {
+    MfccStream stream;
+    AudioConditioner conditioner;
+    std::vector<int16_t> block(CHUNK);
+    stream.begin(rate);
+    conditioner.begin();
+    for (size_t i = 0; i < clip.size(); i += CHUNK) {
+        size_t n = clip.size() - i < (size_t)CHUNK ? clip.size() - i : (size_t)CHUNK;
+        memcpy(block.data(), &clip[i], n * sizeof(int16_t));
+        conditioner.process(block.data(), n);
+        stream.push(block.data(), n);
+    }
+    stream.finish(features, conditioner.gain());
+}
+
+int main(int argc, char** argv) {
+    const char* wavPath = nullptr;
+    const char* outPath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            outPath = argv[++i];
+        } else {
+            wavPath = argv[i];
+        }
+    }
+
+    std::vector<int16_t> input;
+    int rate = SYNTHETIC_RATE;
+    if (wavPath) {
+        if (!loadWav(wavPath, input, rate) || input.empty()) {
+            fprintf(stderr, "error: %s is not a 16-bit PCM WAV file\n", wavPath);
+            return 1;
+        }
+    } else {
+        makeClip(input, rate);
+    }
+    double seconds = (double)input.size() / rate;
+    printf("%s: %.1f s at %d Hz, %zu bytes as 16-bit PCM\n\n", wavPath ? wavPath : "synthetic clip",
+           seconds, rate, input.size() * 2);
+
+    printf("  %-8s %10s %7s %8s %9s %14s %14s\n", "rate", "bytes", "ratio", "packets",
+           "SNR (dB)", "encode (Ms/s)", "decode (Ms/s)");
+    const int rates[] = { rate, LABEL_RATE };
+    int rateCount = rate > LABEL_RATE ? 2 : 1;
+    bool ok = true;
+    for (int r = 0; r < rateCount; r++) {
+        int outRate = rates[r];
+        std::vector<uint8_t> buffer;
+        AudioClipEncoder encoder;
+        std::vector<int16_t> decoded, reference;
+
+        double encodeUs = 1e30, decodeUs = 1e30;
+        for (int rep = 0; rep < REPEATS; rep++) {
+            double t0 = nowMicros();
+            encodeClip(input, rate, outRate, buffer, encoder);
+            double t1 = nowMicros();
+            decodeClip(encoder, decoded);
+            double t2 = nowMicros();
+            doNotOptimize(decoded[0]);
+            if (t1 - t0 < encodeUs) encodeUs = t1 - t0;
+            if (t2 - t1 < decodeUs) decodeUs = t2 - t1;
+        }
+        downsample(input, rate, outRate, reference);
+        double snr = snrDb(reference, decoded);
+        if (decoded.size() != reference.size() || snr < 15.0) ok = false;
+
+        printf("  %-8d %10zu %6.1fx %8zu %9.1f %14.1f %14.1f\n", outRate, encoder.bytes(),
+               (double)input.size() * 2 / encoder.bytes(), encoder.blockCount(), snr,
+               input.size() / encodeUs, input.size() / decodeUs);
+
+        if (outRate == rate) {
+            float original[N_FEATURES], roundTrip[N_FEATURES];
+            clipFeatures(input, rate, original);
+            clipFeatures(decoded, rate, roundTrip);
+            double sum = 0.0, worst = 0.0;
+            int worstIndex = 0;
+            for (int i = 0; i < N_FEATURES; i++) {
+                double err = fabs(roundTrip[i] - original[i]) / SCALE[i];
+                sum += err;
+                if (err > worst) {
+                    worst = err;
+                    worstIndex = i;
+                }
+            }
+            printf("           MFCC features after round trip: mean %.3f SD, max %.3f SD (feature %d)\n",
+                   sum / N_FEATURES, worst, worstIndex);
+        }
+        if (outRate == LABEL_RATE && outPath) {
+            if (!writeWav(outPath, decoded, outRate)) {
+                fprintf(stderr, "error: cannot write %s\n", outPath);
+                return 1;
+            }
+            printf("           wrote %s\n", outPath);
+        }
+    }
+    printf("\n  Ms/s: million captured samples per second (host); the sensor captures %.3f Ms/s\n",
+           rate / 1e6);
+    return ok ? 0 : 1;
+}
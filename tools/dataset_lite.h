@@ -0,0 +1,70 @@
+/**
+ * Feature rows shared by the host tools in tools/
+ *
+ * Raw MFCC feature rows (NUM_FEATURES values each, as the sensor computes
+ * them), read from a CSV or drawn around the scaler from buzzhive_ml.h.
+ * Include buzzhive_ml.h first.
+ */
+
+#ifndef DATASET_LITE_H
+#define DATASET_LITE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+// Rows makeSynthetic() draws
+static const int SYNTHETIC_ROWS = 2000;
+
+/**
+ * Append the rows of a CSV: NUM_FEATURES numbers per line, separated by
+ * commas, spaces or semicolons; extra trailing columns (a label) are
+ * ignored, headers and short lines skipped
+ *
+ * @return false if the file cannot be opened
+ */
+static inline bool loadCsv(const char* path, std::vector<float>& rows) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    char line[16384];
+    while (fgets(line, sizeof(line), f)) {
+        char* p = line;
+        float row[NUM_FEATURES];
+        int n = 0;
+        while (n < NUM_FEATURES) {
+            char* end;
+            row[n] = strtof(p, &end);
+            if (end == p) break;
+            n++;
+            p = end;
+            while (*p == ',' || *p == ' ' || *p == ';') p++;
+        }
+        if (n == NUM_FEATURES) rows.insert(rows.end(), row, row + NUM_FEATURES);
+    }
+    fclose(f);
+    return true;
+}
+
+// SYNTHETIC_ROWS rows around the scaler's mean, one scale per feature;
+// the same rows on every call
+static inline void makeSynthetic(std::vector<float>& rows) {
+    srand(11);
+    for (int s = 0; s < SYNTHETIC_ROWS; s++) {
+        for (int i = 0; i < NUM_FEATURES; i++) {
+            // Sum of uniforms: roughly normal with unit variance
+            float z = 0.0f;
+            for (int k = 0; k < 12; k++) z += (float)rand() / RAND_MAX;
+            rows.push_back(MEAN[i] + (z - 6.0f) * SCALE[i]);
+        }
+    }
+}
+
+// Standardize rows in place with the scaler
+static inline void normalizeRows(std::vector<float>& rows) {
+    for (size_t k = 0; k < rows.size(); k++) {
+        int i = (int)(k % NUM_FEATURES);
+        rows[k] = (rows[k] - MEAN[i]) / SCALE[i];
+    }
+}
+
+#endif // DATASET_LITE_H
@@ -0,0 +1,162 @@
+/**
+ * Minimal JSON DOM shared by the model converters in tools/
+ *
+ * Enough for XGBoost models and exported network weights: no \u escapes
+ * beyond skipping them, numbers as double.
+ */
+
+#ifndef JSON_LITE_H
+#define JSON_LITE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <utility>
+
+// ============================================================================
+// JSON DOM
+// ============================================================================
+
+struct JsonValue {
+    enum Type { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT } type = NUL;
+    double number = 0.0;
+    std::string str;
+    std::vector<JsonValue> items;
+    std::vector<std::pair<std::string, JsonValue>> members;
+
+    const JsonValue* get(const char* key) const {
+        for (const auto& m : members) {
+            if (m.first == key) return &m.second;
+        }
+        return nullptr;
+    }
+
+    // XGBoost stores many numbers as strings ("5E-1")
+    double asNumber() const {
+        if (type == STRING) return strtod(str.c_str(), nullptr);
+        if (type == BOOL) return number;
+        return number;
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : s_(text), pos_(0) {}
+
+    bool parse(JsonValue& out) {
+        if (!parseValue(out)) return false;
+        skipSpace();
+        return pos_ == s_.size();
+    }
+
+    size_t position() const { return pos_; }
+
+private:
+    void skipSpace() {
+        while (pos_ < s_.size() && (s_[pos_] == ' ' || s_[pos_] == '\n' || s_[pos_] == '\r' || s_[pos_] == '\t')) pos_++;
+    }
+
+    bool match(const char* lit) {
+        size_t n = strlen(lit);
+        if (s_.compare(pos_, n, lit) != 0) return false;
+        pos_ += n;
+        return true;
+    }
+
+    bool parseString(std::string& out) {
+        if (s_[pos_] != '"') return false;
+        pos_++;
+        out.clear();
+        while (pos_ < s_.size() && s_[pos_] != '"') {
+            char c = s_[pos_++];
+            if (c == '\\' && pos_ < s_.size()) {
+                char e = s_[pos_++];
+                switch (e) {
+                    case 'n': out += '\n'; break;
+                    case 't': out += '\t'; break;
+                    case 'r': out += '\r'; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'u': out += '?'; pos_ += 4; break;  // Names only; not needed
+                    default: out += e; break;
+                }
+            } else {
+                out += c;
+            }
+        }
+        if (pos_ >= s_.size()) return false;
+        pos_++;
+        return true;
+    }
+
+    bool parseValue(JsonValue& v) {
+        skipSpace();
+        if (pos_ >= s_.size()) return false;
+        char c = s_[pos_];
+        if (c == '{') {
+            v.type = JsonValue::OBJECT;
+            pos_++;
+            skipSpace();
+            if (s_[pos_] == '}') { pos_++; return true; }
+            while (true) {
+                skipSpace();
+                std::string key;
+                if (!parseString(key)) return false;
+                skipSpace();
+                if (s_[pos_++] != ':') return false;
+                v.members.emplace_back(key, JsonValue());
+                if (!parseValue(v.members.back().second)) return false;
+                skipSpace();
+                if (s_[pos_] == ',') { pos_++; continue; }
+                if (s_[pos_] == '}') { pos_++; return true; }
+                return false;
+            }
+        }
+        if (c == '[') {
+            v.type = JsonValue::ARRAY;
+            pos_++;
+            skipSpace();
+            if (s_[pos_] == ']') { pos_++; return true; }
+            while (true) {
+                v.items.emplace_back();
+                if (!parseValue(v.items.back())) return false;
+                skipSpace();
+                if (s_[pos_] == ',') { pos_++; continue; }
+                if (s_[pos_] == ']') { pos_++; return true; }
+                return false;
+            }
+        }
+        if (c == '"') {
+            v.type = JsonValue::STRING;
+            return parseString(v.str);
+        }
+        if (match("true")) { v.type = JsonValue::BOOL; v.number = 1; return true; }
+        if (match("false")) { v.type = JsonValue::BOOL; v.number = 0; return true; }
+        if (match("null")) { v.type = JsonValue::NUL; return true; }
+
+        char* end = nullptr;
+        v.number = strtod(s_.c_str() + pos_, &end);
+        if (end == s_.c_str() + pos_) return false;
+        v.type = JsonValue::NUMBER;
+        pos_ = end - s_.c_str();
+        return true;
+    }
+
+    const std::string& s_;
+    size_t pos_;
+};
+
+// Whole file into a string
+static bool readFile(const char* path, std::string& out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+    fclose(f);
+    return true;
+}
+
+#endif // JSON_LITE_H
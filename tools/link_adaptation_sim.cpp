@@ -0,0 +1,274 @@
+/**
+ * Adaptive Data Rate Simulation (host)
+ *
+ * Places hives around one base station and runs three days of 15-minute
+ * feature reports through the firmware's own code: the sensor's
+ * TransportSender with link settings from RTC (LinkState), the base
+ * station's TransportReceiver and LinkTracker advising in every ACK
+ * (link_adaptation.h, lora_transport.h). Each frame is delivered when its
+ * SNR clears the SX1276 floor for its spreading factor:
+ *
+ *   SNR = TX power - path loss - noise floor (-117 dBm at 125 kHz)
+ *   path loss = 31.7 dB + 35 log10(d) + per-hive shadowing (sd 4 dB)
+ *   per-frame fading sd 2 dB; reported SNR saturates at +10 dB
+ *
+ * The last day is compared against today's fixed SF10 at 17 dBm without
+ * ACKs: spreading factors in use, time on air per report (channel
+ * capacity), sensor radio charge per report (battery), delivery rate,
+ * apart for hives with 3 dB to spare at SF10 and those at its edge.
+ *
+ * Build & run from the repository root:
+ *   g++ -std=c++17 -O2 -I firmware/esp32-hive-sensor/src -I models \
+ *       tools/link_adaptation_sim.cpp -o link_adaptation_sim && ./link_adaptation_sim [hives]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <random>
+#include <vector>
+#include "feature_packet.h"
+#include "lora_airtime.h"
+#include "lora_transport.h"
+#include "link_adaptation.h"
+
+static const long BANDWIDTH_HZ = 125000;
+static const int SF_MIN = 7;                  // LINK_SF_MIN / LINK_SF_MAX
+static const int SF_MAX = 10;
+static const int FIXED_SF = 10;               // LORA_SPREADING_FACTOR today
+static const int FIXED_POWER_DBM = 17;        // LoRa library default
+static const float MARGIN_DB = 5.0f;          // LINK_MARGIN_DB
+static const int REPORTS_PER_DAY = 96;
+static const int DAYS = 3;
+static const double RADIUS_M = 2000.0;
+static const double NOISE_FLOOR_DBM = -117.0;
+static const double SHADOWING_SD_DB = 4.0;
+static const double FADING_SD_DB = 2.0;
+static const double SNR_REPORT_MAX_DB = 10.0;
+static const int BASE_POWER_DBM = 17;         // ACKs
+static const double TURNAROUND_MS = 50.0;
+static const uint32_t ACK_MARGIN_MS = 300;    // TRANSPORT_ACK_MARGIN_MS
+static const uint8_t REPORT_ROUNDS = 3;       // TRANSPORT_REPORT_ROUNDS
+static const double RX_CURRENT_MA = 11.0;
+
+// SX1276 PA_BOOST supply current, approximate
+static double txCurrentMa(int dbm) {
+    return 30.0 + 3.4 * (dbm - LINK_POWER_MIN_DBM);
+}
+
+static double airtimeMs(size_t bytes, int sf, int preamble) {
+    return loraAirtimeUs(bytes, sf, BANDWIDTH_HZ, 5, preamble) / 1000.0;
+}
+
+static int preambleFor(int sf) {
+    return linkPreambleSymbols(sf, SF_MIN, SF_MAX, BANDWIDTH_HZ);
+}
+
+struct Totals {
+    double ms = 0.0;
+    double mc = 0.0;
+    int delivered = 0;
+    int reports = 0;
+
+    void add(double reportMs, double reportMc, bool ok) {
+        ms += reportMs;
+        mc += reportMc;
+        delivered += ok ? 1 : 0;
+        reports++;
+    }
+    double meanMs() const { return ms / reports; }
+    double meanMc() const { return mc / reports; }
+    double deliveredPercent() const { return 100.0 * delivered / reports; }
+};
+
+typedef TransportReceiver<2, 512> Receiver;
+static Receiver receiver;
+static LinkTracker tracker;
+
+struct Hive {
+    uint8_t id;
+    double pathLossDb;
+    LinkState link;
+    uint8_t messageId;
+};
+
+/**
+ * One hive's radio: frames reach the receiver (and ACKs the hive) when
+ * their SNR clears the floor; time and charge are accounted per report
+ */
+class FadingRadio {
+public:
+    FadingRadio(Hive& hive, std::mt19937& rng) : hive_(hive), rng_(rng), fading_(0.0, FADING_SD_DB) {}
+
+    void transmit(const uint8_t* frame, size_t length) {
+        int sf = hive_.link.settings.sf;
+        double ms = airtimeMs(length, sf, preambleFor(sf));
+        clockMs_ += ms;
+        txMs_ += ms;
+        txChargeMc_ += ms * txCurrentMa(hive_.link.settings.txPowerDbm) / 1000.0;
+
+        double snr = hive_.link.settings.txPowerDbm - hive_.pathLossDb - NOISE_FLOOR_DBM + fading_(rng_);
+        if (snr < linkRequiredSnr(sf)) return;
+        delivered_ = true;
+
+        // Base station side, as processTransportFrame()
+        TransportHeader header;
+        uint8_t advice = 0;
+        LinkSettings used;
+        if (transportParse(frame, length, header) && linkDecode(header.link, used)) {
+            double reported = snr < SNR_REPORT_MAX_DB ? snr : SNR_REPORT_MAX_DB;
+            advice = linkEncode(tracker.update(hive_.id, used, (float)reported));
+        }
+        uint8_t ack[TRANSPORT_MAX_FRAME];
+        size_t ackLength;
+        TransportMessage message;
+        receiver.receive(frame, length, (uint32_t)clockMs_, ack, ackLength, message, advice);
+
+        double downSnr = BASE_POWER_DBM - hive_.pathLossDb - NOISE_FLOOR_DBM + fading_(rng_);
+        if (ackLength > 0 && downSnr >= linkRequiredSnr(sf)) {
+            pendingAck_.assign(ack, ack + ackLength);
+            ackMs_ = TURNAROUND_MS + airtimeMs(ackLength, sf, preambleFor(sf));
+        }
+    }
+
+    int receive(uint8_t* frame, size_t capacity, uint32_t timeoutMs) {
+        if (!pendingAck_.empty() && pendingAck_.size() <= capacity) {
+            listen(ackMs_);
+            int n = (int)pendingAck_.size();
+            memcpy(frame, pendingAck_.data(), n);
+            pendingAck_.clear();
+            return n;
+        }
+        listen(timeoutMs);
+        return 0;
+    }
+
+    uint32_t nowMs() { return (uint32_t)clockMs_; }
+
+    double txMs() const { return txMs_; }
+    double chargeMc() const { return txChargeMc_ + rxMs_ * RX_CURRENT_MA / 1000.0; }
+    bool delivered() const { return delivered_; }
+
+private:
+    void listen(double ms) {
+        clockMs_ += ms;
+        rxMs_ += ms;
+    }
+
+    Hive& hive_;
+    std::mt19937& rng_;
+    std::normal_distribution<double> fading_;
+    double clockMs_ = 0.0;
+    double txMs_ = 0.0;
+    double txChargeMc_ = 0.0;
+    double rxMs_ = 0.0;
+    double ackMs_ = 0.0;
+    bool delivered_ = false;
+    std::vector<uint8_t> pendingAck_;
+};
+
+int main(int argc, char** argv) {
+    int hiveCount = argc > 1 ? atoi(argv[1]) : 200;
+    if (hiveCount < 1 || hiveCount > 255) hiveCount = 200;
+
+    std::mt19937 rng(2024);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::normal_distribution<double> shadowing(0.0, SHADOWING_SD_DB);
+    std::normal_distribution<double> fading(0.0, FADING_SD_DB);
+
+    std::vector<Hive> hives(hiveCount);
+    for (int i = 0; i < hiveCount; i++) {
+        double d = RADIUS_M * sqrt(uniform(rng));
+        if (d < 20.0) d = 20.0;
+        hives[i].id = (uint8_t)(i + 1);
+        hives[i].pathLossDb = 31.7 + 35.0 * log10(d) + shadowing(rng);
+        hives[i].link.settings.sf = FIXED_SF;
+        hives[i].link.settings.txPowerDbm = LINK_POWER_MAX_DBM;
+        hives[i].link.missedAcks = 0;
+        hives[i].messageId = 0;
+    }
+    receiver.begin(60000);
+    tracker.begin(SF_MIN, SF_MAX, MARGIN_DB);
+
+    BuzzhiveFeaturePacket packet;
+    memset(&packet, 0x5A, sizeof(packet));
+    size_t reportBytes = featurePacketSize(8);
+
+    // Fixed SF10 at 17 dBm, unacknowledged: one frame per report
+    double fixedMs = airtimeMs(reportBytes, FIXED_SF, 8);
+    double fixedChargeMc = fixedMs * txCurrentMa(FIXED_POWER_DBM) / 1000.0;
+
+    // Totals[0]: hives with 3 dB to spare at SF10 today; [1]: the rest
+    Totals fixed[2], adaptive[2];
+    int sfCount[13] = {0};
+    double powerSum = 0.0;
+    int measuredReports = 0;
+
+    for (int day = 0; day < DAYS; day++) {
+        bool measured = day == DAYS - 1;
+        for (int r = 0; r < REPORTS_PER_DAY; r++) {
+            for (Hive& hive : hives) {
+                double meanSnr = FIXED_POWER_DBM - hive.pathLossDb - NOISE_FLOOR_DBM;
+                int group = meanSnr >= linkRequiredSnr(FIXED_SF) + 3.0 ? 0 : 1;
+
+                // Today's fixed link
+                if (measured) {
+                    fixed[group].add(fixedMs, fixedChargeMc,
+                                     meanSnr + fading(rng) >= linkRequiredSnr(FIXED_SF));
+                }
+
+                // Adaptive link, as the sensor's setupLoRa() + transmitMessage()
+                int sf = hive.link.settings.sf;
+                TransportSender sender;
+                sender.begin(hive.id, 240, REPORT_ROUNDS,
+                             (uint32_t)airtimeMs(sizeof(TransportHeader) + TRANSPORT_BITMAP_BYTES, sf,
+                                                 preambleFor(sf)) + ACK_MARGIN_MS);
+                sender.setLink(linkEncode(hive.link.settings));
+                FadingRadio radio(hive, rng);
+                if (measured) {
+                    sfCount[sf]++;
+                    powerSum += hive.link.settings.txPowerDbm;
+                    measuredReports++;
+                }
+                sender.send(radio, hive.messageId++, TRANSPORT_MSG_FEATURES, (const uint8_t*)&packet,
+                            reportBytes);
+                if (sender.stats().acks > 0) {
+                    linkAcknowledged(hive.link, sender.ackLink(), SF_MIN, SF_MAX);
+                } else {
+                    linkMissed(hive.link, SF_MAX);
+                }
+                if (measured) adaptive[group].add(radio.txMs(), radio.chargeMc(), radio.delivered());
+            }
+        }
+    }
+
+    printf("%d hives within %.1f km, %zu-byte reports, SF%d-SF%d scan (%.1f ms), margin %.0f dB\n\n",
+           hiveCount, RADIUS_M / 1000.0, reportBytes, SF_MIN, SF_MAX,
+           linkScanCycleUs(SF_MIN, SF_MAX, BANDWIDTH_HZ) / 1000.0, MARGIN_DB);
+
+    printf("  Reports on the last day by spreading factor (preamble, time on air):\n");
+    for (int sf = SF_MIN; sf <= SF_MAX; sf++) {
+        printf("    SF%-2d %6.1f%%   %2d symbols, %6.1f ms (8-symbol preamble: %6.1f ms)\n", sf,
+               100.0 * sfCount[sf] / measuredReports, preambleFor(sf),
+               airtimeMs(sizeof(TransportHeader) + reportBytes, sf, preambleFor(sf)),
+               airtimeMs(reportBytes, sf, 8));
+    }
+    printf("    mean TX power %.1f dBm\n", powerSum / measuredReports);
+
+    const char* groups[] = {"hives with >= 3 dB to spare at SF10", "hives at the edge of SF10"};
+    for (int g = 0; g < 2; g++) {
+        if (fixed[g].reports == 0) continue;
+        printf("\n  %s (%d):\n", groups[g], fixed[g].reports / REPORTS_PER_DAY);
+        printf("    %-28s %12s %14s %10s\n", "", "on air (ms)", "radio (mC)", "delivered");
+        printf("    %-28s %12.1f %14.2f %9.1f%%\n", "fixed SF10, 17 dBm, no ACK", fixed[g].meanMs(),
+               fixed[g].meanMc(), fixed[g].deliveredPercent());
+        printf("    %-28s %12.1f %14.2f %9.1f%%\n", "adaptive, with ACK", adaptive[g].meanMs(),
+               adaptive[g].meanMc(), adaptive[g].deliveredPercent());
+        printf("    channel time x%.2f, radio charge x%.2f\n", adaptive[g].meanMs() / fixed[g].meanMs(),
+               adaptive[g].meanMc() / fixed[g].meanMc());
+    }
+    printf("\n  radio charge: TX at the PA_BOOST current for the power used, plus RX while\n"
+           "  waiting for ACKs (a lost report is sent up to %d rounds)\n", REPORT_ROUNDS);
+    return 0;
+}
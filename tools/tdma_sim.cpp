@@ -0,0 +1,290 @@
+/**
+ * TDMA Report Slots vs ALOHA (host)
+ *
+ * Replays two days of reports from N hives on one channel (SF10) and
+ * counts the reports the base station receives, for two report sizes:
+ * 8-bit feature packets (feature_packet.h), and full TRANSPORT_MAX_FRAME
+ * frames every cycle, the worst case of USE_REPORT_BATCH (a full batch at
+ * each wake, as in alert mode). Slots are sized for the report as the
+ * base station sizes them (slotLengthMs); hives beyond the slot count
+ * report at random. Modes:
+ * - aloha: the sensors' own timers, no downlink (USE_DOWNLINK off)
+ * - aloha+dl: the same with a downlink answering each report; the base
+ *   station cannot receive while it sends one
+ * - slotted: USE_TDMA, with the firmware's slot logic (slot_schedule.h):
+ *   the base station gives out slots as it hears hives and each downlink
+ *   beacons its clock; the sensor measures its clock drift between
+ *   downlinks, wakes its recording time plus TDMA_WAKE_GUARD_MS before
+ *   the slot and holds the report for it
+ *
+ * Frames that overlap on air are lost (no capture effect), as are frames
+ * that arrive while the base station transmits. Sensor clocks (the RTC's
+ * 150 kHz RC oscillator) run off by a fixed +/-2000 ppm plus a daily
+ * +/-500 ppm temperature swing; waking to a ready report takes 11 s
+ * +/- 0.3 s. Downlinks are also lost at random (DOWNLINK_LOSS).
+ *
+ * Build & run from the repository root:
+ *   g++ -std=c++17 -O2 -I firmware/esp32-hive-sensor/src -I models \
+ *       tools/tdma_sim.cpp -o tdma_sim && ./tdma_sim
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <queue>
+#include <random>
+#include <vector>
+#include "feature_packet.h"
+#include "lora_airtime.h"
+#include "lora_transport.h"
+#include "downlink.h"
+#include "slot_schedule.h"
+
+static const long BANDWIDTH_HZ = 125000;
+static const int SF = 10;
+static const double DAY_MS = 24 * 3600 * 1000.0;
+static const double RUN_MS = 2 * DAY_MS;
+
+static const uint32_t REPORT_INTERVAL_MS = 15 * 60 * 1000;   // ACTIVE_INTERVAL_MS
+static const uint32_t TDMA_CYCLE_MS = REPORT_INTERVAL_MS;    // Both config.h
+static const uint32_t TDMA_GUARD_MS = 500;                   // Base station config.h
+static const uint32_t TDMA_WAKE_GUARD_MS = 500;
+
+static const double READY_MS = 11000.0;        // Wake to report ready (recording + MFCC)
+static const double READY_SD_MS = 300.0;
+static const double DRIFT_PPM = 2000.0;        // Fixed clock error, +/-
+static const double DRIFT_SWING_PPM = 500.0;   // Daily temperature swing, +/-
+static const double DOWNLINK_LOSS = 0.02;
+static const double WAKE_SPAN_MS = 120000.0;   // Longer than any wake to report
+
+// The base station's tdmaSlotMs() for reports of uplinkBytes (one frame)
+static uint32_t slotMs(size_t uplinkBytes) {
+    uint32_t uplinkMs = loraAirtimeUs(uplinkBytes, SF, BANDWIDTH_HZ) / 1000;
+    uint32_t downlinkMs = loraAirtimeUs(sizeof(BuzzhiveDownlink), SF, BANDWIDTH_HZ) / 1000;
+    return slotLengthMs(uplinkMs, 1, downlinkMs, TDMA_GUARD_MS);
+}
+
+enum Mode { ALOHA, ALOHA_DOWNLINK, SLOTTED };
+static const char* MODE_NAMES[] = {"aloha", "aloha+dl", "slotted"};
+
+struct Frame {
+    double start;
+    double end;
+};
+
+struct Hive {
+    double driftPpm;           // True clock error, fixed part
+    double swingPhase;
+    double realAnchor;         // Last time its clock was read
+    double localAnchor;        // ... and what it read (ms)
+    SlotState slot;
+    uint32_t leadMs;
+    size_t frame;              // Its report this wake, index into frames
+};
+
+struct Event {
+    double t;
+    int hive;
+    bool answer;               // Downlink time of the hive's report; else a wake
+    bool operator<(const Event& other) const { return t > other.t; }
+};
+
+struct Result {
+    size_t reports = 0;
+    size_t delivered = 0;
+    size_t slotted = 0;        // Reports sent in a slot
+    std::vector<double> slotErrorMs;
+};
+
+class Simulation {
+public:
+    Simulation(Mode mode, int hives, size_t uplinkBytes, uint32_t seed)
+        : mode_(mode), rng_(seed), hives_(hives),
+          uplinkMs_(loraAirtimeUs(uplinkBytes, SF, BANDWIDTH_HZ) / 1000.0) {
+        scheduler_.begin(TDMA_CYCLE_MS, slotMs(uplinkBytes));
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        for (Hive& h : hives_) {
+            h.driftPpm = (2.0 * unit(rng_) - 1.0) * DRIFT_PPM;
+            h.swingPhase = 0.5 * unit(rng_);      // Hives in one apiary warm up together
+            h.realAnchor = 0.0;
+            h.localAnchor = unit(rng_) * 1e9;
+            h.slot = {0, 0, 0, 0, 0, 0};
+            h.leadMs = (uint32_t)READY_MS + TDMA_WAKE_GUARD_MS;
+        }
+        for (int i = 0; i < hives; i++) events_.push({unit(rng_) * REPORT_INTERVAL_MS, i, false});
+    }
+
+    Result run() {
+        while (!events_.empty() && events_.top().t < RUN_MS) {
+            Event e = events_.top();
+            events_.pop();
+            if (e.answer) {
+                answer(e.hive, e.t);
+            } else {
+                wake(e.hive, e.t);
+            }
+        }
+        return result_;
+    }
+
+private:
+    double drift(const Hive& h, double t) const {
+        return (h.driftPpm + DRIFT_SWING_PPM * sin(2.0 * M_PI * (t / DAY_MS + h.swingPhase))) * 1e-6;
+    }
+
+    // The hive's RTC clock at real time t (ms; t not before the last read)
+    double localAt(Hive& h, double t) {
+        h.localAnchor += (t - h.realAnchor) * (1.0 + drift(h, 0.5 * (h.realAnchor + t)));
+        h.realAnchor = t;
+        return h.localAnchor;
+    }
+
+    // Real time the hive's clock reads localMs (ms), at today's drift
+    double realAt(const Hive& h, double localMs) const {
+        return h.realAnchor + (localMs - h.localAnchor) / (1.0 + drift(h, h.realAnchor));
+    }
+
+    void wake(int i, double t) {
+        Hive& h = hives_[i];
+        std::normal_distribution<double> ready(READY_MS, READY_SD_MS);
+        double readyAt = t + std::max(1000.0, ready(rng_));
+        double start = readyAt;
+        localAt(h, t);
+        if (mode_ == SLOTTED && h.slot.slotAtUs != 0) {
+            // waitForSlot()
+            h.leadMs = slotLead(h.leadMs, (uint32_t)(readyAt - t), TDMA_WAKE_GUARD_MS);
+            double slotAt = realAt(h, h.slot.slotAtUs / 1000.0);
+            start = std::max(readyAt, slotAt);
+            result_.slotted++;
+        }
+        h.frame = frames_.size();
+        frames_.push_back({start, start + uplinkMs_});
+        result_.reports++;
+        if (mode_ == ALOHA) sleep(i, start + uplinkMs_);
+        events_.push({start + uplinkMs_ + DOWNLINK_DELAY_MS, i, true});
+    }
+
+    bool received(size_t f) const {
+        // Frames are pushed at wake, so in start order to within a wake's length
+        const Frame& frame = frames_[f];
+        for (size_t j = f; j-- > 0 && frames_[j].start > frame.start - WAKE_SPAN_MS;) {
+            if (frames_[j].start < frame.end && frames_[j].end > frame.start) return false;
+        }
+        for (size_t j = f + 1; j < frames_.size() && frames_[j].start < frame.end + WAKE_SPAN_MS; j++) {
+            if (frames_[j].start < frame.end && frames_[j].end > frame.start) return false;
+        }
+        for (const Frame& tx : baseTx_) {
+            if (tx.start < frame.end && tx.end > frame.start) return false;
+        }
+        return true;
+    }
+
+    // The report's downlink time: the base station answers what it received
+    void answer(int i, double t) {
+        Hive& h = hives_[i];
+        const Frame& frame = frames_[h.frame];
+        bool delivered = received(h.frame);
+        if (mode_ == ALOHA) {
+            result_.delivered += delivered;
+            return;
+        }
+        bool answered = false;
+        BuzzhiveDownlink downlink;
+        if (delivered) {
+            result_.delivered++;
+            // The radio cannot send two downlinks at once
+            bool busy = !baseTx_.empty() && baseTx_.back().end > t;
+            if (!busy) {
+                baseTx_.push_back({t, t + downlinkMs_});
+                while (baseTx_.size() > 64) baseTx_.erase(baseTx_.begin());
+                std::uniform_real_distribution<double> unit(0.0, 1.0);
+                answered = unit(rng_) >= DOWNLINK_LOSS;
+            }
+            int slot = mode_ == SLOTTED ? scheduler_.assign((uint8_t)i) : -1;
+            downlink.flags = slot >= 0 ? DOWNLINK_SLOT : 0;
+            if (slot >= 0) {
+                if (h.slot.slotAtUs != 0) {
+                    result_.slotErrorMs.push_back(scheduler_.error(slot, (uint32_t)frame.start));
+                }
+                downlink.baseTimeMs = (uint32_t)t;
+                downlink.slotInMs = scheduler_.nextStart(slot, (uint32_t)t) - (uint32_t)t;
+            }
+        }
+        double windowEnd = t + downlinkMs_ + DOWNLINK_WINDOW_MARGIN_MS;
+        if (mode_ == SLOTTED) {
+            if (answered && (downlink.flags & DOWNLINK_SLOT)) {
+                slotSync(h.slot, (int64_t)(localAt(h, t) * 1000.0), downlink.baseTimeMs,
+                         downlink.slotInMs);
+            } else if (!answered) {
+                slotMissed(h.slot);
+            }
+        }
+        sleep(i, windowEnd);
+    }
+
+    // nextSleepMs(): deep sleep to the next wake
+    void sleep(int i, double t) {
+        Hive& h = hives_[i];
+        double local = localAt(h, t);
+        if (mode_ == SLOTTED && h.slot.slotAtUs != 0) {
+            int64_t wakeUs = slotAdvance(h.slot, (int64_t)(local * 1000.0), h.leadMs,
+                                         REPORT_INTERVAL_MS, TDMA_CYCLE_MS);
+            events_.push({realAt(h, wakeUs / 1000.0), i, false});
+        } else {
+            events_.push({realAt(h, local + REPORT_INTERVAL_MS), i, false});
+        }
+    }
+
+    Mode mode_;
+    std::mt19937 rng_;
+    std::vector<Hive> hives_;
+    std::vector<Frame> frames_;     // Uplinks, in start order
+    std::vector<Frame> baseTx_;     // Recent downlinks
+    std::priority_queue<Event> events_;
+    SlotScheduler scheduler_;
+    Result result_;
+    double uplinkMs_;
+    double downlinkMs_ = loraAirtimeUs(sizeof(BuzzhiveDownlink), SF, BANDWIDTH_HZ) / 1000.0;
+};
+
+static double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0.0;
+    for (double& x : v) x = fabs(x);
+    std::sort(v.begin(), v.end());
+    return v[(size_t)(p * (v.size() - 1))];
+}
+
+int main() {
+    double downlinkMs = loraAirtimeUs(sizeof(BuzzhiveDownlink), SF, BANDWIDTH_HZ) / 1000.0;
+    printf("SF%d: downlink %.0f ms after %d ms; %u s cycle\n", SF, downlinkMs, DOWNLINK_DELAY_MS,
+           TDMA_CYCLE_MS / 1000);
+    printf("Clocks +/-%.0f ppm fixed, +/-%.0f ppm daily; %.0f%% downlinks lost; 2 days\n",
+           DRIFT_PPM, DRIFT_SWING_PPM, 100.0 * DOWNLINK_LOSS);
+
+    const size_t sizes[] = {featurePacketSize(8), TRANSPORT_MAX_FRAME};
+    const char* sizeNames[] = {"8-bit feature packets", "full batch frames"};
+    const int counts[] = {10, 25, 50, 100, 150, 200, 256};
+    for (int k = 0; k < 2; k++) {
+        uint32_t slot = slotMs(sizes[k]);
+        printf("\n%s: %zu bytes, %.0f ms on air; %u slots of %u ms\n", sizeNames[k], sizes[k],
+               loraAirtimeUs(sizes[k], SF, BANDWIDTH_HZ) / 1000.0, TDMA_CYCLE_MS / slot, slot);
+        printf("%6s %10s %10s %10s %10s %12s %12s\n", "hives", "aloha", "aloha+dl", "slotted",
+               "in slot", "|err| p50", "|err| p99");
+        for (int hives : counts) {
+            Result r[3];
+            for (int m = 0; m < 3; m++) r[m] = Simulation((Mode)m, hives, sizes[k], 11 + hives).run();
+            printf("%6d", hives);
+            for (int m = 0; m < 3; m++) printf(" %9.1f%%", 100.0 * r[m].delivered / r[m].reports);
+            printf(" %9.1f%% %10.0f ms %10.0f ms\n", 100.0 * r[SLOTTED].slotted / r[SLOTTED].reports,
+                   percentile(r[SLOTTED].slotErrorMs, 0.5), percentile(r[SLOTTED].slotErrorMs, 0.99));
+        }
+    }
+    printf("\n  %s / %s / %s: reports the base station received\n", MODE_NAMES[0], MODE_NAMES[1],
+           MODE_NAMES[2]);
+    printf("  in slot: slotted reports sent in the hive's slot (the rest before two downlinks,\n"
+           "           or from hives beyond the slot count)\n");
+    printf("  |err|: how far slotted reports started from their slot start\n");
+    printf("  slotted losses are mostly joining hives: their random reports hit slotted ones\n");
+    return 0;
+}
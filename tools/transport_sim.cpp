@@ -0,0 +1,146 @@
+/**
+ * LoRa Transport Simulation (host)
+ *
+ * Runs the sensor's TransportSender against the base station's
+ * TransportReceiver (lora_transport.h) over an in-memory channel that
+ * drops each frame, data or ACK, with probability p. Time is simulated:
+ * every frame costs its LoRa time on air (lora_airtime.h) and an ACK
+ * timeout costs the full wait, so the numbers are what a sensor at SF10
+ * would see.
+ *
+ * For each message size and loss rate it reports the share of messages
+ * delivered intact, goodput (payload bytes per second of link time),
+ * fragments sent per fragment needed, retransmissions and ACK timeouts
+ * per message. "send once" is the delivery rate without acknowledgement:
+ * every fragment must arrive the first time.
+ *
+ * Build & run from the repository root:
+ *   g++ -std=c++17 -O2 -I firmware/esp32-hive-sensor/src \
+ *       tools/transport_sim.cpp -o transport_sim && ./transport_sim
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <random>
+#include <vector>
+#include "lora_transport.h"
+#include "lora_airtime.h"
+
+static const int SPREADING_FACTOR = 10;
+static const long BANDWIDTH_HZ = 125000;
+static const uint8_t FRAGMENT_BYTES = 240;
+static const uint8_t MAX_ROUNDS = 12;
+static const double TURNAROUND_MS = 50.0;   // Base station: parse + switch to TX
+static const uint8_t HIVE_ID = 7;
+
+typedef TransportReceiver<2, 20000> Receiver;
+
+static double airtimeMs(size_t bytes) {
+    return loraAirtimeUs(bytes, SPREADING_FACTOR, BANDWIDTH_HZ) / 1000.0;
+}
+
+// ACK wait: the longest ACK on air plus the base station's turnaround
+static uint32_t ackTimeoutMs() {
+    return (uint32_t)(airtimeMs(sizeof(TransportHeader) + TRANSPORT_BITMAP_BYTES) + 2 * TURNAROUND_MS);
+}
+
+/**
+ * Sensor-side radio over a lossy channel to the receiver
+ */
+class LossyRadio {
+public:
+    LossyRadio(Receiver& receiver, double loss, unsigned seed)
+        : receiver_(receiver), loss_(loss), rng_(seed), uniform_(0.0, 1.0) {}
+
+    void transmit(const uint8_t* frame, size_t length) {
+        clockMs_ += airtimeMs(length);
+        if (uniform_(rng_) < loss_) return;
+
+        uint8_t ack[TRANSPORT_MAX_FRAME];
+        size_t ackLength;
+        TransportMessage message;
+        if (receiver_.receive(frame, length, (uint32_t)clockMs_, ack, ackLength, message) == TRANSPORT_COMPLETE) {
+            delivered_.assign(message.data, message.data + message.length);
+        }
+        if (ackLength > 0 && uniform_(rng_) >= loss_) {
+            pendingAck_.assign(ack, ack + ackLength);
+            ackArrivesMs_ = clockMs_ + TURNAROUND_MS + airtimeMs(ackLength);
+        }
+    }
+
+    int receive(uint8_t* frame, size_t capacity, uint32_t timeoutMs) {
+        if (!pendingAck_.empty() && ackArrivesMs_ <= clockMs_ + timeoutMs &&
+            pendingAck_.size() <= capacity) {
+            clockMs_ = ackArrivesMs_ > clockMs_ ? ackArrivesMs_ : clockMs_;
+            int n = (int)pendingAck_.size();
+            memcpy(frame, pendingAck_.data(), n);
+            pendingAck_.clear();
+            return n;
+        }
+        pendingAck_.clear();
+        clockMs_ += timeoutMs;
+        return 0;
+    }
+
+    uint32_t nowMs() { return (uint32_t)clockMs_; }
+
+    double clockMs() const { return clockMs_; }
+    const std::vector<uint8_t>& delivered() const { return delivered_; }
+    void clearDelivered() { delivered_.clear(); }
+
+private:
+    Receiver& receiver_;
+    double loss_;
+    std::mt19937 rng_;
+    std::uniform_real_distribution<double> uniform_;
+    double clockMs_ = 0.0;
+    std::vector<uint8_t> pendingAck_;
+    double ackArrivesMs_ = 0.0;
+    std::vector<uint8_t> delivered_;
+};
+
+static Receiver receiver;   // ~40 KB: keep off the stack
+
+static void runCase(const char* name, size_t bytes, int trials) {
+    std::vector<uint8_t> message(bytes);
+    for (size_t i = 0; i < bytes; i++) message[i] = (uint8_t)(i * 31 + 7);
+    int fragments = (int)((bytes + FRAGMENT_BYTES - 1) / FRAGMENT_BYTES);
+
+    printf("\n%s: %zu bytes, %d fragments, %d messages per loss rate\n", name, bytes, fragments, trials);
+    printf("  %5s %10s %10s %12s %10s %10s %10s %10s\n", "loss", "send once", "delivered",
+           "goodput B/s", "s/message", "sent/need", "retx/msg", "timeouts");
+
+    const double losses[] = {0.0, 0.01, 0.05, 0.10, 0.20, 0.30, 0.40};
+    for (double loss : losses) {
+        receiver.begin(60000);
+        LossyRadio radio(receiver, loss, 1234);
+        TransportSender sender;
+        sender.begin(HIVE_ID, FRAGMENT_BYTES, MAX_ROUNDS, ackTimeoutMs());
+
+        int intact = 0;
+        for (int t = 0; t < trials; t++) {
+            radio.clearDelivered();
+            message[0] = (uint8_t)t;   // Distinct content per message
+            sender.send(radio, (uint8_t)t, TRANSPORT_MSG_AUDIO_CLIP, message.data(), bytes);
+            if (radio.delivered() == message) intact++;
+        }
+
+        const TransportSenderStats& s = sender.stats();
+        double seconds = radio.clockMs() / 1000.0;
+        printf("  %4.0f%% %9.1f%% %9.1f%% %12.1f %10.1f %10.2f %10.2f %10.2f\n", loss * 100,
+               100.0 * pow(1.0 - loss, fragments), 100.0 * intact / trials,
+               intact * (double)bytes / seconds, seconds / trials,
+               (double)s.fragmentsSent / ((double)fragments * trials),
+               (double)s.retransmissions / trials, (double)s.ackTimeouts / trials);
+    }
+}
+
+int main() {
+    printf("SF%d, %ld kHz, %d-byte fragments, up to %d rounds, ACK timeout %u ms\n",
+           SPREADING_FACTOR, BANDWIDTH_HZ / 1000, FRAGMENT_BYTES, MAX_ROUNDS, ackTimeoutMs());
+    runCase("Float feature vector (BuzzhivePacketFull)", 318, 400);
+    runCase("Audio clip, 4 s at 8 kHz (AudioClipInfo + 125 ADPCM blocks)", 5 + 125 * 132, 40);
+    return 0;
+}
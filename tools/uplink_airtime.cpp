@@ -0,0 +1,124 @@
+/**
+ * Feature Uplink Airtime & Accuracy (host)
+ *
+ * Compares the sensor's report formats on air:
+ * - BuzzhivePacket (summary only, 17 bytes)
+ * - BuzzhivePacketFull (78 floats, 318 bytes: over the SX1276's 255-byte
+ *   FIFO, so it would need two packets)
+ * - BuzzhiveFeaturePacket at 4-8 bits per feature (feature_packet.h)
+ * For each: time on air per spreading factor, radio energy per report,
+ * and how many hives one gateway channel carries at the report interval
+ * (pure ALOHA, channel load kept under 18%).
+ *
+ * It also round-trips feature rows through encodeFeatures() /
+ * decodeFeatures() and reports the error in standard deviations.
+ *
+ * Build & run from the repository root:
+ *   g++ -std=c++17 -O2 -I firmware/esp32-hive-sensor/src -I models \
+ *       tools/uplink_airtime.cpp -o uplink_airtime && ./uplink_airtime [features.csv]
+ *
+ * features.csv holds raw feature rows (78 values per line); without it,
+ * synthetic rows are drawn around the scaler's mean.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include "buzzhive_ml.h"
+#include "feature_packet.h"
+#include "lora_airtime.h"
+#include "dataset_lite.h"
+
+static const long BANDWIDTH_HZ = 125000;
+static const double TX_CURRENT_MA = 120.0;        // SX1276 at +20 dBm
+static const double REPORT_INTERVAL_S = 15 * 60;  // ACTIVE_INTERVAL_MS
+static const double ALOHA_MAX_LOAD = 0.18;        // Pure ALOHA throughput peak
+
+struct Format {
+    char name[32];
+    size_t bytes;
+};
+
+int main(int argc, char** argv) {
+    std::vector<Format> formats;
+    formats.push_back({"summary (no features)", 17});
+    formats.push_back({"float features", 318});
+    for (int bits = FEATURE_MAX_BITS; bits >= FEATURE_MIN_BITS; bits--) {
+        Format f;
+        snprintf(f.name, sizeof(f.name), "%d-bit features", bits);
+        f.bytes = featurePacketSize((uint8_t)bits);
+        formats.push_back(f);
+    }
+
+    printf("Time on air per report (ms), 125 kHz, CR 4/5\n");
+    printf("  %-22s %6s", "format", "bytes");
+    for (int sf = 7; sf <= 12; sf++) printf("   SF%-3d", sf);
+    printf("\n");
+    for (const Format& f : formats) {
+        printf("  %-22s %6zu", f.name, f.bytes);
+        for (int sf = 7; sf <= 12; sf++) {
+            // Over 255 bytes: two packets, split evenly
+            uint32_t us = f.bytes > 255 ? 2 * loraAirtimeUs((f.bytes + 1) / 2, sf, BANDWIDTH_HZ)
+                                        : loraAirtimeUs(f.bytes, sf, BANDWIDTH_HZ);
+            printf(" %7.1f", us / 1000.0);
+        }
+        printf("%s\n", f.bytes > 255 ? "  (2 packets)" : "");
+    }
+
+    const int sf = 10;
+    uint32_t floatUs = 2 * loraAirtimeUs(159, sf, BANDWIDTH_HZ);
+    printf("\nAt SF%d, one report every %.0f min:\n", sf, REPORT_INTERVAL_S / 60);
+    printf("  %-22s %10s %12s %12s\n", "format", "airtime", "TX mAs", "hives/gw");
+    for (const Format& f : formats) {
+        uint32_t us = f.bytes > 255 ? floatUs : loraAirtimeUs(f.bytes, sf, BANDWIDTH_HZ);
+        double hives = ALOHA_MAX_LOAD * REPORT_INTERVAL_S / (us / 1e6);
+        printf("  %-22s %8.0fms %12.1f %12.0f\n", f.name, us / 1000.0, TX_CURRENT_MA * us / 1e6, hives);
+    }
+    printf("  8-bit vs float features: %.1fx less airtime\n",
+           (double)floatUs / loraAirtimeUs(featurePacketSize(8), sf, BANDWIDTH_HZ));
+
+    // Quantization error
+    const char* csv = argc > 1 ? argv[1] : nullptr;
+    std::vector<float> rows;
+    if (csv) {
+        if (!loadCsv(csv, rows) || rows.empty()) {
+            fprintf(stderr, "error: no rows in %s\n", csv);
+            return 1;
+        }
+    } else {
+        makeSynthetic(rows);
+    }
+    size_t count = rows.size() / NUM_FEATURES;
+    printf("\nRound-trip error in standard deviations (%zu rows, %s):\n", count, csv ? csv : "synthetic");
+    printf("  %-6s %10s %10s %10s\n", "bits", "mean", "max", "clipped");
+    bool ok = true;
+    for (int bits = FEATURE_MAX_BITS; bits >= FEATURE_MIN_BITS; bits--) {
+        double sum = 0.0, worst = 0.0;
+        size_t clipped = 0;
+        for (size_t s = 0; s < count; s++) {
+            const float* raw = &rows[s * NUM_FEATURES];
+            uint8_t payload[FEATURE_PAYLOAD_BYTES(FEATURE_MAX_BITS)];
+            float decoded[NUM_FEATURES];
+            encodeFeatures(raw, (uint8_t)bits, payload);
+            if (!decodeFeatures(payload, (uint8_t)bits, decoded)) ok = false;
+            for (int i = 0; i < NUM_FEATURES; i++) {
+                float z = (raw[i] - MEAN[i]) / SCALE[i];
+                if (fabsf(z) > FEATURE_RANGE_SD) {
+                    clipped++;
+                    continue;
+                }
+                double err = fabs(decoded[i] - z);
+                sum += err;
+                if (err > worst) worst = err;
+            }
+        }
+        size_t values = count * NUM_FEATURES - clipped;
+        printf("  %-6d %10.4f %10.4f %9.3f%%\n", bits, values ? sum / values : 0.0, worst,
+               100.0 * clipped / (count * NUM_FEATURES));
+        // Within range the error is at most half a step
+        if (worst > 0.5 * FEATURE_RANGE_SD / featureCodeMax((uint8_t)bits) + 1e-5) ok = false;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,372 @@
+/**
+ * VAE Weights -> Int8 Dense Network Converter (host)
+ *
+ * Quantizes the trained VAE for the base station's dense_network.h /
+ * vae_anomaly.h and checks the int8 network against the float one:
+ * - weights: symmetric int8, one scale per output channel
+ * - activations: symmetric int8, one scale per layer input, taken from
+ *   the largest float activation seen on the calibration rows
+ * - errorScale: the calibration rows' 99th percentile reconstruction
+ *   error maps to anomaly score 128
+ *
+ * Input is JSON with the layers in evaluation order (encoder hidden
+ * layers, latent mean head, decoder layers), weights as [outputs][inputs]
+ * like torch.nn.Linear. The log-variance head is not needed. E.g.:
+ *   layers = [enc1, enc2, fc_mu, dec1, dec2, dec_out]
+ *   acts = ["relu", "relu", "linear", "relu", "relu", "linear"]
+ *   json.dump({"layers": [{"weight": l.weight.tolist(), "bias": l.bias.tolist(),
+ *                          "activation": a} for l, a in zip(layers, acts)]}, f)
+ *
+ * Build from the repository root:
+ *   g++ -std=c++17 -O2 -I firmware/esp32-base-station/src \
+ *       tools/vae_convert.cpp -o vae_convert
+ *
+ * Usage:
+ *   vae_convert models/vae_weights.json --calibrate features.csv \
+ *       -o firmware/esp32-base-station/src/vae_model.h
+ *
+ * Options:
+ *   -o <file>          Output C header (default: vae_model.h)
+ *   --calibrate <csv>  Raw feature rows (78 values per line, e.g. the
+ *                      training set). Without it, synthetic rows drawn
+ *                      around the scaler's mean are used.
+ *   --percentile <p>   Activation range percentile (default: 100; lower
+ *                      values clip the tails that anomalies live in)
+ *   --max-diff <n>     Largest allowed |int8 - float| score difference
+ *                      on the calibration rows (default: 8)
+ *
+ * After writing the header it prints the parity check (reconstruction
+ * error and 0-255 score, int8 vs float) and microseconds per inference
+ * for both, and exits non-zero if the parity check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "buzzhive_ml.h"
+#include "dense_network.h"
+#include "vae_anomaly.h"
+#include "json_lite.h"
+#include "dataset_lite.h"
+#include "bench_timer.h"
+
+static const int REPEATS = 5;
+
+static bool fail(const char* msg) {
+    fprintf(stderr, "error: %s\n", msg);
+    return false;
+}
+
+// ============================================================================
+// Float Network
+// ============================================================================
+
+struct FloatLayer {
+    int inputs = 0;
+    int outputs = 0;
+    int activation = DENSE_LINEAR;
+    std::vector<float> weights;  // [outputs][inputs]
+    std::vector<float> bias;
+};
+
+static bool loadLayers(const JsonValue& root, std::vector<FloatLayer>& layers) {
+    const JsonValue* list = root.get("layers");
+    if (!list || list->type != JsonValue::ARRAY || list->items.empty()) return fail("no \"layers\" array");
+    for (const JsonValue& jl : list->items) {
+        const JsonValue* w = jl.get("weight");
+        const JsonValue* b = jl.get("bias");
+        const JsonValue* a = jl.get("activation");
+        if (!w || w->type != JsonValue::ARRAY || w->items.empty()) return fail("layer without \"weight\"");
+        FloatLayer layer;
+        layer.outputs = (int)w->items.size();
+        layer.inputs = (int)w->items[0].items.size();
+        for (const JsonValue& row : w->items) {
+            if ((int)row.items.size() != layer.inputs) return fail("ragged weight matrix");
+            for (const JsonValue& v : row.items) layer.weights.push_back((float)v.asNumber());
+        }
+        if (b) {
+            if ((int)b->items.size() != layer.outputs) return fail("bias length != outputs");
+            for (const JsonValue& v : b->items) layer.bias.push_back((float)v.asNumber());
+        } else {
+            layer.bias.assign(layer.outputs, 0.0f);
+        }
+        if (a && a->str == "relu") layer.activation = DENSE_RELU;
+        else if (a && a->str != "linear") return fail("activation must be \"relu\" or \"linear\"");
+        if (!layers.empty() && layers.back().outputs != layer.inputs) return fail("layer widths do not chain");
+        if (layer.inputs > DENSE_MAX_WIDTH || layer.outputs > DENSE_MAX_WIDTH) return fail("layer wider than DENSE_MAX_WIDTH");
+        layers.push_back(layer);
+    }
+    if (layers.front().inputs != NUM_FEATURES || layers.back().outputs != NUM_FEATURES) {
+        return fail("network must map NUM_FEATURES inputs back to NUM_FEATURES outputs");
+    }
+    return true;
+}
+
+/**
+ * Float forward pass
+ *
+ * @param layerInputs If set, receives every layer's input activations
+ */
+static void floatForward(const std::vector<FloatLayer>& layers, const float* input, float* output,
+                         std::vector<std::vector<float>>* layerInputs = nullptr) {
+    std::vector<float> x(input, input + layers.front().inputs), y;
+    for (size_t l = 0; l < layers.size(); l++) {
+        const FloatLayer& layer = layers[l];
+        if (layerInputs) (*layerInputs)[l].insert((*layerInputs)[l].end(), x.begin(), x.end());
+        y.assign(layer.outputs, 0.0f);
+        for (int o = 0; o < layer.outputs; o++) {
+            const float* w = &layer.weights[(size_t)o * layer.inputs];
+            float acc = layer.bias[o];
+            for (int i = 0; i < layer.inputs; i++) acc += w[i] * x[i];
+            if (layer.activation == DENSE_RELU && acc < 0.0f) acc = 0.0f;
+            y[o] = acc;
+        }
+        x.swap(y);
+    }
+    memcpy(output, x.data(), x.size() * sizeof(float));
+}
+
+static float floatError(const std::vector<FloatLayer>& layers, const float* normalized) {
+    float recon[DENSE_MAX_WIDTH];
+    floatForward(layers, normalized, recon);
+    float sum = 0.0f;
+    for (int i = 0; i < NUM_FEATURES; i++) {
+        float d = recon[i] - normalized[i];
+        sum += d * d;
+    }
+    return sum / NUM_FEATURES;
+}
+
+// ============================================================================
+// Calibration Rows
+// ============================================================================
+
+static float percentileAbs(std::vector<float> values, double percentile) {
+    if (values.empty()) return 0.0f;
+    for (float& v : values) v = fabsf(v);
+    size_t k = (size_t)(percentile / 100.0 * (values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
+}
+
+// ============================================================================
+// Quantization
+// ============================================================================
+
+struct QuantLayer {
+    std::vector<int8_t> weights;
+    std::vector<int32_t> bias;
+    std::vector<float> outScale;
+    float inputScale = 1.0f;
+};
+
+static void quantizeLayer(const FloatLayer& layer, float inputRange, QuantLayer& q) {
+    q.inputScale = inputRange > 1e-12f ? inputRange / 127.0f : 1.0f;
+    for (int o = 0; o < layer.outputs; o++) {
+        const float* w = &layer.weights[(size_t)o * layer.inputs];
+        float wmax = 0.0f;
+        for (int i = 0; i < layer.inputs; i++) wmax = fmaxf(wmax, fabsf(w[i]));
+        float ws = wmax > 0.0f ? wmax / 127.0f : 1.0f;
+        for (int i = 0; i < layer.inputs; i++) q.weights.push_back(quantizeInt8(w[i] / ws));
+        float scale = q.inputScale * ws;
+        q.outScale.push_back(scale);
+        q.bias.push_back((int32_t)lround(layer.bias[o] / scale));
+    }
+}
+
+static DenseLayer denseView(const FloatLayer& layer, const QuantLayer& q) {
+    DenseLayer d;
+    d.inputs = (uint16_t)layer.inputs;
+    d.outputs = (uint16_t)layer.outputs;
+    d.activation = (uint8_t)layer.activation;
+    d.inputScale = q.inputScale;
+    d.weights = q.weights.data();
+    d.bias = q.bias.data();
+    d.outScale = q.outScale.data();
+    return d;
+}
+
+// ============================================================================
+// Output
+// ============================================================================
+
+static std::string floatLiteral(float v) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.9g", v);
+    std::string s = buf;
+    if (s.find_first_of(".eEn") == std::string::npos) s += ".0";
+    return s + "f";
+}
+
+// Weights, biases and scales as stored in flash
+static size_t quantBytes(const std::vector<QuantLayer>& quant) {
+    size_t bytes = 0;
+    for (const QuantLayer& q : quant) {
+        bytes += q.weights.size() + q.bias.size() * sizeof(int32_t) + q.outScale.size() * sizeof(float);
+    }
+    return bytes;
+}
+
+static bool writeHeader(const char* path, const char* source, const std::vector<FloatLayer>& layers,
+                        const std::vector<QuantLayer>& quant, float errorScale) {
+    FILE* f = fopen(path, "w");
+    if (!f) return fail("cannot write output");
+    fprintf(f, "/**\n * VAE anomaly model (int8) - generated by tools/vae_convert.cpp\n *\n");
+    fprintf(f, " * Source: %s\n * Layers:", source);
+    for (const FloatLayer& layer : layers) {
+        fprintf(f, " %d->%d%s", layer.inputs, layer.outputs, layer.activation == DENSE_RELU ? "r" : "");
+    }
+    fprintf(f, "\n * Flash: %zu bytes\n */\n\n", quantBytes(quant));
+    fprintf(f, "#ifndef VAE_MODEL_H\n#define VAE_MODEL_H\n\n#include \"vae_anomaly.h\"\n\n");
+
+    for (size_t l = 0; l < layers.size(); l++) {
+        const QuantLayer& q = quant[l];
+        fprintf(f, "static const int8_t VAE_L%zu_WEIGHTS[%zu] = {", l, q.weights.size());
+        for (size_t i = 0; i < q.weights.size(); i++) {
+            fprintf(f, "%s%d,", i % 24 ? " " : "\n    ", q.weights[i]);
+        }
+        fprintf(f, "\n};\n\nstatic const int32_t VAE_L%zu_BIAS[%zu] = {", l, q.bias.size());
+        for (size_t i = 0; i < q.bias.size(); i++) {
+            fprintf(f, "%s%ld,", i % 8 ? " " : "\n    ", (long)q.bias[i]);
+        }
+        fprintf(f, "\n};\n\nstatic const float VAE_L%zu_SCALE[%zu] = {", l, q.outScale.size());
+        for (size_t i = 0; i < q.outScale.size(); i++) {
+            fprintf(f, "%s%s,", i % 6 ? " " : "\n    ", floatLiteral(q.outScale[i]).c_str());
+        }
+        fprintf(f, "\n};\n\n");
+    }
+
+    fprintf(f, "static const DenseLayer VAE_LAYERS[%zu] = {\n", layers.size());
+    for (size_t l = 0; l < layers.size(); l++) {
+        fprintf(f, "    {%d, %d, %s, %s, VAE_L%zu_WEIGHTS, VAE_L%zu_BIAS, VAE_L%zu_SCALE},\n",
+                layers[l].inputs, layers[l].outputs,
+                layers[l].activation == DENSE_RELU ? "DENSE_RELU" : "DENSE_LINEAR",
+                floatLiteral(quant[l].inputScale).c_str(), l, l, l);
+    }
+    fprintf(f, "};\n\n");
+    fprintf(f, "static const VaeModel VAE_MODEL = {{%zu, VAE_LAYERS}, %s};\n\n",
+            layers.size(), floatLiteral(errorScale).c_str());
+    fprintf(f, "#endif // VAE_MODEL_H\n");
+    fclose(f);
+    return true;
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+static void usage() {
+    fprintf(stderr, "usage: vae_convert <weights.json> [-o out] [--calibrate rows.csv] [--percentile p] [--max-diff n]\n");
+}
+
+int main(int argc, char** argv) {
+    const char* input = nullptr;
+    const char* output = "vae_model.h";
+    const char* calibration = nullptr;
+    double percentile = 100.0;
+    int maxDiff = 8;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-o") && i + 1 < argc) output = argv[++i];
+        else if (!strcmp(argv[i], "--calibrate") && i + 1 < argc) calibration = argv[++i];
+        else if (!strcmp(argv[i], "--percentile") && i + 1 < argc) percentile = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--max-diff") && i + 1 < argc) maxDiff = atoi(argv[++i]);
+        else if (argv[i][0] != '-' && !input) input = argv[i];
+        else { usage(); return 2; }
+    }
+    if (!input) { usage(); return 2; }
+
+    std::string text;
+    if (!readFile(input, text)) {
+        fprintf(stderr, "error: cannot read %s\n", input);
+        return 1;
+    }
+    JsonValue root;
+    JsonParser parser(text);
+    if (!parser.parse(root)) {
+        fprintf(stderr, "error: invalid JSON near byte %zu\n", parser.position());
+        return 1;
+    }
+    std::vector<FloatLayer> layers;
+    if (!loadLayers(root, layers)) return 1;
+
+    std::vector<float> rows;
+    if (calibration) {
+        if (!loadCsv(calibration, rows) || rows.empty()) {
+            fprintf(stderr, "error: no rows in %s\n", calibration);
+            return 1;
+        }
+    } else {
+        fprintf(stderr, "warning: no --calibrate rows, using synthetic ones\n");
+        makeSynthetic(rows);
+    }
+    normalizeRows(rows);
+    size_t count = rows.size() / NUM_FEATURES;
+
+    // Activation ranges and float reference errors
+    std::vector<std::vector<float>> layerInputs(layers.size());
+    std::vector<float> refErrors(count);
+    for (size_t s = 0; s < count; s++) {
+        float recon[DENSE_MAX_WIDTH];
+        floatForward(layers, &rows[s * NUM_FEATURES], recon, &layerInputs);
+        refErrors[s] = floatError(layers, &rows[s * NUM_FEATURES]);
+    }
+    float p99 = percentileAbs(refErrors, 99.0);
+    float errorScale = p99 > 0.0f ? 128.0f / p99 : 1.0f;
+
+    std::vector<QuantLayer> quant(layers.size());
+    std::vector<DenseLayer> dense;
+    for (size_t l = 0; l < layers.size(); l++) {
+        quantizeLayer(layers[l], percentileAbs(layerInputs[l], percentile), quant[l]);
+        dense.push_back(denseView(layers[l], quant[l]));
+    }
+    VaeModel model = {{(uint32_t)dense.size(), dense.data()}, errorScale};
+    if (!denseNetworkFits(model.net)) {
+        fail("network does not fit the arena");
+        return 1;
+    }
+
+    if (!writeHeader(output, input, layers, quant, errorScale)) return 1;
+
+    // Parity: int8 engine vs float reference
+    static DenseArena arena;
+    double sumRel = 0.0, maxRel = 0.0, sumScoreDiff = 0.0;
+    int maxScoreDiff = 0;
+    for (size_t s = 0; s < count; s++) {
+        float err = vaeReconstructionError(model, &rows[s * NUM_FEATURES], &arena);
+        double rel = fabs(err - refErrors[s]) / fmax(refErrors[s], 1e-12);
+        sumRel += rel;
+        maxRel = fmax(maxRel, rel);
+        int diff = abs((int)vaeScoreFromError(model, err) - (int)vaeScoreFromError(model, refErrors[s]));
+        sumScoreDiff += diff;
+        if (diff > maxScoreDiff) maxScoreDiff = diff;
+    }
+
+    // Latency
+    double floatUs = 1e30, int8Us = 1e30;
+    for (int r = 0; r < REPEATS; r++) {
+        double t0 = nowMicros();
+        for (size_t s = 0; s < count; s++) doNotOptimize(floatError(layers, &rows[s * NUM_FEATURES]));
+        floatUs = fmin(floatUs, (nowMicros() - t0) / count);
+        t0 = nowMicros();
+        for (size_t s = 0; s < count; s++) doNotOptimize(vaeAnomalyScore(model, &rows[s * NUM_FEATURES], &arena));
+        int8Us = fmin(int8Us, (nowMicros() - t0) / count);
+    }
+
+    size_t params = 0;
+    for (const FloatLayer& layer : layers) params += layer.weights.size() + layer.bias.size();
+    printf("%s: %zu layers, %zu parameters -> %s\n", input, layers.size(), params, output);
+    printf("  calibration: %zu rows (%s), p99 error %.4g -> score 128\n", count,
+           calibration ? calibration : "synthetic", p99);
+    printf("  %-22s %12s %12s\n", "", "float", "int8");
+    printf("  %-22s %12zu %12zu\n", "flash bytes", params * sizeof(float), quantBytes(quant));
+    printf("  %-22s %12.2f %12.2f\n", "us/inference", floatUs, int8Us);
+    printf("  reconstruction error: mean rel diff %.2e, max %.2e\n", sumRel / count, maxRel);
+    printf("  anomaly score: mean |diff| %.3f, max |diff| %d (limit %d) -> %s\n",
+           sumScoreDiff / count, maxScoreDiff, maxDiff, maxScoreDiff <= maxDiff ? "PASS" : "FAIL");
+    return maxScoreDiff <= maxDiff ? 0 : 1;
+}
@@ -0,0 +1,776 @@
+/**
+ * XGBoost JSON -> Flat Tree Ensemble Converter (host)
+ *
+ * Reads the trained model (models/xgboost_queen_detector.json) and writes
+ * the compact node tables used by the base station's tree_ensemble.h.
+ *
+ * Accepts either XGBoost JSON format:
+ * - Booster.save_model("*.json")         (learner / gradient_booster / trees)
+ * - Booster.get_dump(dump_format="json") (array of nested node objects)
+ *
+ * Build from the repository root:
+ *   g++ -std=c++17 -O2 -I firmware/esp32-base-station/src \
+ *       tools/xgb_convert.cpp -o xgb_convert
+ *
+ * Usage:
+ *   xgb_convert models/xgboost_queen_detector.json \
+ *       -o firmware/esp32-base-station/src/xgboost_model.h
+ *
+ * Options:
+ *   -o <file>        Output C header (default: xgboost_model.h)
+ *   --quantized      Write the quantized model (QuantEnsemble) instead:
+ *                    the StandardScaler from buzzhive_ml.h is folded into
+ *                    the thresholds, which become per-feature bin indices
+ *   --binary         Write a model image (model_format.h) for the flash
+ *                    "model" partition instead of a C header
+ *   --codegen        Write the trees as straight-line C++ instead of
+ *                    node tables (xgboost_model_code.h, USE_CODEGEN_MODEL)
+ *   --rounds <n>     Keep only the first n boosting rounds ("top-N trees")
+ *   --calibrate <csv> Calibrate early-exit stages on raw feature rows
+ *                    (78 values per line, e.g. the validation set) and
+ *                    store them with the model
+ *   --stages <list>  Stage ends in percent of the rounds (default: 10,25,50)
+ *   --tolerance <f>  Fraction of calibration samples allowed to change
+ *                    class at an early exit (default: 0)
+ *   --classes <n>    Class count for get_dump() input (default: 4)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <math.h>
+#include "tree_ensemble.h"
+#include "model_format.h"
+#include "buzzhive_ml.h"
+#include "json_lite.h"
+#include "dataset_lite.h"
+
+// ============================================================================
+// Source Model
+// ============================================================================
+
+struct SrcNode {
+    bool leaf = true;
+    int feature = 0;
+    float value = 0.0f;   // Threshold or leaf value
+    int left = -1;
+    int right = -1;
+};
+
+struct SrcTree {
+    std::vector<SrcNode> nodes;   // Node 0 is the root
+    int cls = 0;
+};
+
+struct SrcModel {
+    int numFeatures = 0;
+    int numClasses = 0;
+    float baseScore = 0.0f;
+    std::vector<SrcTree> trees;
+};
+
+static bool fail(const char* msg) {
+    fprintf(stderr, "error: %s\n", msg);
+    return false;
+}
+
+// Booster.save_model() JSON
+static bool loadSavedModel(const JsonValue& root, SrcModel& model) {
+    const JsonValue* learner = root.get("learner");
+    if (!learner) return fail("missing 'learner'");
+    const JsonValue* params = learner->get("learner_model_param");
+    const JsonValue* booster = learner->get("gradient_booster");
+    if (!params || !booster) return fail("missing learner_model_param / gradient_booster");
+    const JsonValue* gbModel = booster->get("model");
+    if (!gbModel) return fail("only gbtree boosters are supported");
+
+    model.numFeatures = (int)params->get("num_feature")->asNumber();
+    const JsonValue* numClass = params->get("num_class");
+    model.numClasses = numClass ? (int)numClass->asNumber() : 1;
+    if (model.numClasses < 1) model.numClasses = 1;
+    const JsonValue* baseScore = params->get("base_score");
+    model.baseScore = baseScore ? (float)baseScore->asNumber() : 0.5f;
+
+    const JsonValue* trees = gbModel->get("trees");
+    const JsonValue* treeInfo = gbModel->get("tree_info");
+    if (!trees || trees->type != JsonValue::ARRAY) return fail("missing 'trees'");
+
+    for (size_t t = 0; t < trees->items.size(); t++) {
+        const JsonValue& jt = trees->items[t];
+        const JsonValue* lefts = jt.get("left_children");
+        const JsonValue* rights = jt.get("right_children");
+        const JsonValue* indices = jt.get("split_indices");
+        const JsonValue* conds = jt.get("split_conditions");
+        if (!lefts || !rights || !indices || !conds) return fail("tree is missing node arrays");
+
+        SrcTree tree;
+        tree.cls = treeInfo ? (int)treeInfo->items[t].asNumber() : (int)(t % model.numClasses);
+        tree.nodes.resize(lefts->items.size());
+        for (size_t i = 0; i < tree.nodes.size(); i++) {
+            SrcNode& n = tree.nodes[i];
+            n.left = (int)lefts->items[i].asNumber();
+            n.right = (int)rights->items[i].asNumber();
+            n.leaf = n.left < 0;
+            n.feature = (int)indices->items[i].asNumber();
+            // Leaves keep their (learning-rate scaled) value in split_conditions
+            n.value = (float)conds->items[i].asNumber();
+        }
+        model.trees.push_back(tree);
+    }
+    return true;
+}
+
+// One get_dump(dump_format="json") node, appended to tree.nodes
+static int loadDumpNode(const JsonValue& jn, SrcTree& tree) {
+    int index = (int)tree.nodes.size();
+    tree.nodes.emplace_back();
+    const JsonValue* leaf = jn.get("leaf");
+    if (leaf) {
+        tree.nodes[index].value = (float)leaf->asNumber();
+        return index;
+    }
+
+    const JsonValue* split = jn.get("split");
+    const JsonValue* cond = jn.get("split_condition");
+    const JsonValue* yes = jn.get("yes");
+    const JsonValue* children = jn.get("children");
+    if (!split || !cond || !yes || !children) return -1;
+
+    // "f12" or a plain index; named features are not supported
+    const char* name = split->str.c_str();
+    int feature = (split->type == JsonValue::NUMBER) ? (int)split->number
+                : atoi(name[0] == 'f' ? name + 1 : name);
+
+    int yesId = (int)yes->asNumber();
+    int left = -1, right = -1;
+    for (const JsonValue& child : children->items) {
+        int c = loadDumpNode(child, tree);
+        if (c < 0) return -1;
+        int id = (int)child.get("nodeid")->asNumber();
+        if (id == yesId) left = c; else right = c;
+    }
+    if (left < 0 || right < 0) return -1;
+
+    SrcNode& n = tree.nodes[index];
+    n.leaf = false;
+    n.feature = feature;
+    n.value = (float)cond->asNumber();
+    n.left = left;
+    n.right = right;
+    return index;
+}
+
+static bool loadDump(const JsonValue& root, SrcModel& model, int numClasses) {
+    model.numClasses = numClasses;
+    model.baseScore = 0.5f;
+    for (size_t t = 0; t < root.items.size(); t++) {
+        SrcTree tree;
+        tree.cls = (int)(t % numClasses);
+        if (loadDumpNode(root.items[t], tree) < 0) return fail("malformed dump tree");
+        for (const SrcNode& n : tree.nodes) {
+            if (!n.leaf && n.feature + 1 > model.numFeatures) model.numFeatures = n.feature + 1;
+        }
+        model.trees.push_back(tree);
+    }
+    return true;
+}
+
+// ============================================================================
+// Flattening
+// ============================================================================
+
+struct FlatModel {
+    std::vector<TreeNode> nodes;
+    std::vector<uint32_t> roots;
+    std::vector<uint8_t> treeClass;
+    int maxDepth = 0;
+    Cascade cascade{};
+};
+
+// Breadth-first layout: children of a node are adjacent (left, right)
+static bool flattenTree(const SrcTree& tree, FlatModel& flat) {
+    uint32_t root = (uint32_t)flat.nodes.size();
+    flat.roots.push_back(root);
+    flat.treeClass.push_back((uint8_t)tree.cls);
+
+    // (source node, flat slot, depth)
+    std::deque<std::pair<int, std::pair<uint32_t, int>>> queue;
+    flat.nodes.emplace_back();
+    queue.push_back({0, {root, 0}});
+    while (!queue.empty()) {
+        int src = queue.front().first;
+        uint32_t slot = queue.front().second.first;
+        int depth = queue.front().second.second;
+        queue.pop_front();
+        if (depth > flat.maxDepth) flat.maxDepth = depth;
+
+        const SrcNode& n = tree.nodes[src];
+        TreeNode& out = flat.nodes[slot];
+        out.value = n.value;
+        if (n.leaf) {
+            out.feature = TREE_LEAF;
+            out.left = 0;
+            continue;
+        }
+        if (n.feature < 0 || n.feature >= TREE_LEAF) return fail("feature index out of range");
+        uint32_t left = (uint32_t)flat.nodes.size();
+        if (left - slot > 0xFFFF) return fail("tree too wide for 16-bit child offsets");
+        out.feature = (uint16_t)n.feature;
+        out.left = (uint16_t)(left - slot);
+        flat.nodes.emplace_back();
+        flat.nodes.emplace_back();
+        queue.push_back({n.left, {left, depth + 1}});
+        queue.push_back({n.right, {left + 1, depth + 1}});
+    }
+    return true;
+}
+
+// ============================================================================
+// Quantization
+// ============================================================================
+
+struct QuantModel {
+    std::vector<QuantTreeNode> nodes;
+    std::vector<float> leaves;
+    std::vector<uint32_t> cutOffsets;
+    std::vector<float> cuts;
+};
+
+// Float bits mapped so integer order matches float order
+static uint32_t orderedKey(float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+static float fromOrderedKey(uint32_t key) {
+    uint32_t bits = (key & 0x80000000u) ? (key & 0x7FFFFFFFu) : ~key;
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+// Same float arithmetic as normalizeFeatures() in the firmware
+static float normalizedValue(float raw, int feature) {
+    return (raw - MEAN[feature]) / SCALE[feature];
+}
+
+/**
+ * Smallest raw value whose normalized form is >= threshold
+ *
+ * Normalization is monotonic in float arithmetic, so
+ *   normalized(x) < threshold  <=>  x < rawSplit(threshold)
+ * holds exactly, rounding included.
+ */
+static float rawSplit(float threshold, int feature) {
+    uint32_t lo = orderedKey(-INFINITY);
+    uint32_t hi = orderedKey(INFINITY);
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (normalizedValue(fromOrderedKey(mid), feature) >= threshold) hi = mid;
+        else lo = mid + 1;
+    }
+    return fromOrderedKey(lo);
+}
+
+static bool quantizeModel(const SrcModel& model, const FlatModel& flat, QuantModel& quant) {
+    if (model.numFeatures != NUM_FEATURES) return fail("model feature count does not match buzzhive_ml.h");
+    if (model.numFeatures >= QTREE_LEAF) return fail("too many features for 8-bit indices");
+
+    // Split points per feature in the raw (unscaled) domain
+    std::vector<std::vector<float>> cuts(model.numFeatures);
+    for (const TreeNode& n : flat.nodes) {
+        if (n.feature != TREE_LEAF) cuts[n.feature].push_back(rawSplit(n.value, n.feature));
+    }
+    quant.cutOffsets.push_back(0);
+    for (auto& c : cuts) {
+        std::sort(c.begin(), c.end());
+        c.erase(std::unique(c.begin(), c.end()), c.end());
+        if (c.size() > 0xFFFF) return fail("too many split points for 16-bit bins");
+        quant.cuts.insert(quant.cuts.end(), c.begin(), c.end());
+        quant.cutOffsets.push_back((uint32_t)quant.cuts.size());
+    }
+
+    // Node j-th split point of a feature: x < cut[j]  <=>  bin(x) <= j
+    for (const TreeNode& n : flat.nodes) {
+        QuantTreeNode q;
+        if (n.feature == TREE_LEAF) {
+            if (quant.leaves.size() > 0xFFFF) return fail("too many leaves for 16-bit indices");
+            q.feature = QTREE_LEAF;
+            q.left = 0;
+            q.bin = (uint16_t)quant.leaves.size();
+            quant.leaves.push_back(n.value);
+        } else {
+            if (n.left > 0xFF) return fail("tree too wide for 8-bit child offsets");
+            const std::vector<float>& c = cuts[n.feature];
+            float split = rawSplit(n.value, n.feature);
+            q.feature = (uint8_t)n.feature;
+            q.left = (uint8_t)n.left;
+            q.bin = (uint16_t)(std::lower_bound(c.begin(), c.end(), split) - c.begin());
+        }
+        quant.nodes.push_back(q);
+    }
+    return true;
+}
+
+// ============================================================================
+// Cascade Calibration
+// ============================================================================
+
+static int argmax(const float* v, int n) {
+    int best = 0;
+    for (int i = 1; i < n; i++) {
+        if (v[i] > v[best]) best = i;
+    }
+    return best;
+}
+
+/**
+ * Pick each stage's exit gap so that, on the calibration rows, at most
+ * tolerance * rows samples exit with a class different from the full
+ * ensemble's (zero by default). A stage with no more wrong samples than
+ * that has nothing to bound its gap; it gets the largest gap seen, with
+ * a warning.
+ */
+static bool calibrateCascade(const SrcModel& model, FlatModel& flat, const char* path,
+                             const char* stageList, double tolerance) {
+    std::vector<float> rows;
+    if (!loadCsv(path, rows) || rows.empty()) return fail("no calibration rows");
+    if (model.numFeatures != NUM_FEATURES) return fail("model feature count does not match buzzhive_ml.h");
+    size_t count = rows.size() / NUM_FEATURES;
+    int numClasses = model.numClasses;
+    uint32_t numTrees = (uint32_t)flat.roots.size();
+    uint32_t rounds = numTrees / numClasses;
+
+    // Stage ends on whole rounds
+    Cascade& cascade = flat.cascade;
+    cascade = Cascade();
+    for (const char* p = stageList; *p && cascade.numStages < CASCADE_MAX_STAGES;) {
+        char* end;
+        double percent = strtod(p, &end);
+        if (end == p) break;
+        p = end;
+        while (*p == ',') p++;
+        uint32_t stageRounds = (uint32_t)(rounds * percent / 100.0 + 0.5);
+        if (stageRounds == 0) stageRounds = 1;
+        uint32_t endTree = stageRounds * numClasses;
+        uint32_t prev = cascade.numStages ? cascade.stages[cascade.numStages - 1].endTree : 0;
+        if (endTree <= prev || endTree >= numTrees) continue;
+        cascade.stages[cascade.numStages].endTree = endTree;
+        cascade.stages[cascade.numStages].minGap = INFINITY;
+        cascade.numStages++;
+    }
+    if (cascade.numStages == 0) return fail("no usable cascade stages");
+
+    TreeEnsemble view = {(uint16_t)model.numFeatures, (uint16_t)numClasses, numTrees, model.baseScore,
+                         flat.roots.data(), flat.treeClass.data(), flat.nodes.data()};
+
+    // Per stage: gaps of the samples whose partial class is wrong
+    std::vector<std::vector<float>> wrongGaps(cascade.numStages);
+    std::vector<std::vector<float>> gaps(cascade.numStages, std::vector<float>(count));
+    for (size_t r = 0; r < count; r++) {
+        float normalized[NUM_FEATURES];
+        for (int i = 0; i < NUM_FEATURES; i++) {
+            normalized[i] = (rows[r * NUM_FEATURES + i] - MEAN[i]) / SCALE[i];
+        }
+        float margins[256];
+        int partialClass[CASCADE_MAX_STAGES];
+        for (int c = 0; c < numClasses; c++) margins[c] = model.baseScore;
+        uint32_t done = 0;
+        for (uint32_t s = 0; s < cascade.numStages; s++) {
+            ensembleAccumulate(view, normalized, done, cascade.stages[s].endTree, margins);
+            done = cascade.stages[s].endTree;
+            gaps[s][r] = marginGap(margins, numClasses);
+            partialClass[s] = argmax(margins, numClasses);
+        }
+        ensembleAccumulate(view, normalized, done, numTrees, margins);
+        int fullClass = argmax(margins, numClasses);
+        for (uint32_t s = 0; s < cascade.numStages; s++) {
+            if (partialClass[s] != fullClass) wrongGaps[s].push_back(gaps[s][r]);
+        }
+    }
+
+    size_t allowed = (size_t)(tolerance * count);
+    for (uint32_t s = 0; s < cascade.numStages; s++) {
+        std::vector<float>& wrong = wrongGaps[s];
+        std::sort(wrong.begin(), wrong.end(), std::greater<float>());
+        if (allowed < wrong.size()) {
+            // Just above the largest gap that may not exit
+            cascade.stages[s].minGap = nextafterf(wrong[allowed], INFINITY);
+        } else {
+            // Too few wrong samples to bound the gap: only samples more
+            // decisive than every calibration row may exit
+            float maxGap = *std::max_element(gaps[s].begin(), gaps[s].end());
+            cascade.stages[s].minGap = nextafterf(maxGap, INFINITY);
+            fprintf(stderr, "warning: stage %u: %zu of %zu calibration rows wrong, gap floored at "
+                    "the largest seen (%.4g); calibrate on more rows\n", s + 1, wrong.size(), count, maxGap);
+        }
+    }
+
+    // Report the cascade as the runtime will execute it
+    double treeSum = 0.0;
+    size_t exits[CASCADE_MAX_STAGES + 1] = {0};
+    for (size_t r = 0; r < count; r++) {
+        uint32_t s = 0;
+        while (s < cascade.numStages && gaps[s][r] < cascade.stages[s].minGap) s++;
+        exits[s]++;
+        treeSum += s < cascade.numStages ? cascade.stages[s].endTree : numTrees;
+    }
+    printf("cascade calibrated on %zu rows (%s):\n", count, path);
+    for (uint32_t s = 0; s <= cascade.numStages; s++) {
+        uint32_t end = s < cascade.numStages ? cascade.stages[s].endTree : numTrees;
+        if (s < cascade.numStages) {
+            printf("  stage %u: %4u trees, gap >= %-10.4g exits %5.1f%%\n", s + 1, end,
+                   cascade.stages[s].minGap, 100.0 * exits[s] / count);
+        } else {
+            printf("  full:    %4u trees                     %5.1f%%\n", end, 100.0 * exits[s] / count);
+        }
+    }
+    printf("  mean trees per sample: %.1f of %u (%.2fx fewer)\n", treeSum / count, numTrees,
+           numTrees / (treeSum / count));
+    return true;
+}
+
+// ============================================================================
+// Output
+// ============================================================================
+
+// Shortest float literal that round-trips exactly
+static std::string floatLiteral(float v) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.9g", v);
+    std::string s = buf;
+    if (s.find_first_of(".eEn") == std::string::npos) s += ".0";
+    return s + "f";
+}
+
+// Per-tree roots and classes; prefix keeps both formats linkable together
+static void writeTreeTables(FILE* f, const char* prefix, const FlatModel& flat) {
+    fprintf(f, "static const uint32_t %s_TREE_ROOTS[%zu] = {", prefix, flat.roots.size());
+    for (size_t i = 0; i < flat.roots.size(); i++) {
+        fprintf(f, "%s%u,", (i % 12 == 0) ? "\n    " : " ", flat.roots[i]);
+    }
+    fprintf(f, "\n};\n\n");
+
+    fprintf(f, "static const uint8_t %s_TREE_CLASS[%zu] = {", prefix, flat.treeClass.size());
+    for (size_t i = 0; i < flat.treeClass.size(); i++) {
+        fprintf(f, "%s%u,", (i % 24 == 0) ? "\n    " : " ", flat.treeClass[i]);
+    }
+    fprintf(f, "\n};\n\n");
+}
+
+static void writeCascade(FILE* f, const char* prefix, const Cascade& cascade) {
+    fprintf(f, "// Early-exit stages (xgb_convert --calibrate); none = full ensemble\n");
+    fprintf(f, "static const Cascade %s_CASCADE = {%u, {", prefix, (unsigned)cascade.numStages);
+    for (int i = 0; i < CASCADE_MAX_STAGES; i++) {
+        fprintf(f, "%s{%u, %s}", i ? ", " : "", (unsigned)cascade.stages[i].endTree,
+                floatLiteral(cascade.stages[i].minGap).c_str());
+    }
+    fprintf(f, "}};\n\n");
+}
+
+static bool writeHeader(const char* path, const char* source, const SrcModel& model, const FlatModel& flat) {
+    FILE* f = fopen(path, "w");
+    if (!f) return fail("cannot open output file");
+
+    fprintf(f, "/**\n * Compiled XGBoost Model\n *\n");
+    fprintf(f, " * Generated by tools/xgb_convert.cpp from %s. Do not edit.\n", source);
+    fprintf(f, " * %zu trees, %zu nodes (%zu bytes), %d features, %d classes, max depth %d\n */\n\n",
+            flat.roots.size(), flat.nodes.size(), flat.nodes.size() * sizeof(TreeNode),
+            model.numFeatures, model.numClasses, flat.maxDepth);
+    fprintf(f, "#ifndef XGBOOST_MODEL_H\n#define XGBOOST_MODEL_H\n\n#include \"tree_ensemble.h\"\n\n");
+
+    fprintf(f, "static const TreeNode XGB_NODES[%zu] = {\n", flat.nodes.size());
+    for (size_t i = 0; i < flat.nodes.size(); i++) {
+        const TreeNode& n = flat.nodes[i];
+        fprintf(f, "    {%s, %u, %u},\n", floatLiteral(n.value).c_str(), n.feature, n.left);
+    }
+    fprintf(f, "};\n\n");
+
+    writeTreeTables(f, "XGB", flat);
+    writeCascade(f, "XGB", flat.cascade);
+
+    fprintf(f, "static const TreeEnsemble XGB_MODEL = {\n");
+    fprintf(f, "    %d, %d, %zu, %s,\n", model.numFeatures, model.numClasses, flat.roots.size(),
+            floatLiteral(model.baseScore).c_str());
+    fprintf(f, "    XGB_TREE_ROOTS, XGB_TREE_CLASS, XGB_NODES\n};\n\n");
+    fprintf(f, "#endif // XGBOOST_MODEL_H\n");
+    fclose(f);
+    return true;
+}
+
+static bool writeQuantHeader(const char* path, const char* source, const SrcModel& model,
+                             const FlatModel& flat, const QuantModel& quant) {
+    FILE* f = fopen(path, "w");
+    if (!f) return fail("cannot open output file");
+
+    size_t bytes = quant.nodes.size() * sizeof(QuantTreeNode) + (quant.leaves.size() + quant.cuts.size()) * sizeof(float);
+    fprintf(f, "/**\n * Compiled XGBoost Model (quantized, scaler folded in)\n *\n");
+    fprintf(f, " * Generated by tools/xgb_convert.cpp --quantized from %s. Do not edit.\n", source);
+    fprintf(f, " * %zu trees, %zu nodes, %zu leaves, %zu split points (%zu bytes), max depth %d\n */\n\n",
+            flat.roots.size(), quant.nodes.size(), quant.leaves.size(), quant.cuts.size(), bytes, flat.maxDepth);
+    fprintf(f, "#ifndef XGBOOST_MODEL_QUANT_H\n#define XGBOOST_MODEL_QUANT_H\n\n#include \"tree_ensemble.h\"\n\n");
+
+    fprintf(f, "static const QuantTreeNode XGB_QNODES[%zu] = {", quant.nodes.size());
+    for (size_t i = 0; i < quant.nodes.size(); i++) {
+        const QuantTreeNode& n = quant.nodes[i];
+        fprintf(f, "%s{%u, %u, %u},", (i % 6 == 0) ? "\n    " : " ", n.feature, n.left, n.bin);
+    }
+    fprintf(f, "\n};\n\n");
+
+    fprintf(f, "static const float XGB_QLEAVES[%zu] = {\n", quant.leaves.size());
+    for (float v : quant.leaves) fprintf(f, "    %s,\n", floatLiteral(v).c_str());
+    fprintf(f, "};\n\n");
+
+    fprintf(f, "static const uint32_t XGB_QCUT_OFFSETS[%zu] = {", quant.cutOffsets.size());
+    for (size_t i = 0; i < quant.cutOffsets.size(); i++) {
+        fprintf(f, "%s%u,", (i % 12 == 0) ? "\n    " : " ", quant.cutOffsets[i]);
+    }
+    fprintf(f, "\n};\n\n");
+
+    fprintf(f, "static const float XGB_QCUTS[%zu] = {\n", quant.cuts.size());
+    for (float v : quant.cuts) fprintf(f, "    %s,\n", floatLiteral(v).c_str());
+    fprintf(f, "};\n\n");
+
+    writeTreeTables(f, "XGB_Q", flat);
+    writeCascade(f, "XGB_Q", flat.cascade);
+
+    fprintf(f, "static const QuantEnsemble XGB_QMODEL = {\n");
+    fprintf(f, "    %d, %d, %zu, %s,\n", model.numFeatures, model.numClasses, flat.roots.size(),
+            floatLiteral(model.baseScore).c_str());
+    fprintf(f, "    XGB_Q_TREE_ROOTS, XGB_Q_TREE_CLASS, XGB_QNODES, XGB_QLEAVES, XGB_QCUT_OFFSETS, XGB_QCUTS\n};\n\n");
+    fprintf(f, "#endif // XGBOOST_MODEL_QUANT_H\n");
+    fclose(f);
+    return true;
+}
+
+// Trees per generated function: keeps each function small enough for the
+// compiler's per-function passes and never crosses a cascade stage
+static const uint32_t CODE_CHUNK_TREES = 32;
+
+// One tree as nested compares, leaves added to m[class]
+static void writeCodeNode(FILE* f, const FlatModel& flat, uint32_t index, int cls, int indent) {
+    const TreeNode& n = flat.nodes[index];
+    if (n.feature == TREE_LEAF) {
+        fprintf(f, "%*sm[%d] += %s;\n", indent, "", cls, floatLiteral(n.value).c_str());
+        return;
+    }
+    fprintf(f, "%*sif (x[%u] < %s) {\n", indent, "", n.feature, floatLiteral(n.value).c_str());
+    writeCodeNode(f, flat, index + n.left, cls, indent + 4);
+    fprintf(f, "%*s} else {\n", indent, "");
+    writeCodeNode(f, flat, index + n.left + 1, cls, indent + 4);
+    fprintf(f, "%*s}\n", indent, "");
+}
+
+/**
+ * Write the ensemble as straight-line C++: one function per chunk of trees,
+ * and a predict function that runs them in order with the cascade's exits
+ * in between. Same float adds in the same order as ensemblePredictCascade(),
+ * so the probabilities are identical.
+ */
+static bool writeCodeHeader(const char* path, const char* source, const SrcModel& model, const FlatModel& flat) {
+    FILE* f = fopen(path, "w");
+    if (!f) return fail("cannot open output file");
+    uint32_t numTrees = (uint32_t)flat.roots.size();
+    const Cascade& cascade = flat.cascade;
+
+    fprintf(f, "/**\n * Code-Generated XGBoost Model\n *\n");
+    fprintf(f, " * Generated by tools/xgb_convert.cpp --codegen from %s. Do not edit.\n", source);
+    fprintf(f, " * %u trees, %zu nodes, %d features, %d classes, max depth %d\n *\n",
+            numTrees, flat.nodes.size(), model.numFeatures, model.numClasses, flat.maxDepth);
+    fprintf(f, " * Every split is a compare against a constant. Define XGB_CODE_ATTR\n");
+    fprintf(f, " * (e.g. IRAM_ATTR) before including to choose where the code lives.\n */\n\n");
+    fprintf(f, "#ifndef XGBOOST_MODEL_CODE_H\n#define XGBOOST_MODEL_CODE_H\n\n#include \"tree_ensemble.h\"\n\n");
+    fprintf(f, "#ifndef XGB_CODE_ATTR\n#define XGB_CODE_ATTR\n#endif\n\n");
+    fprintf(f, "#define XGB_CODE_NUM_TREES %u\n#define XGB_CODE_NUM_CLASSES %d\n\n", numTrees, model.numClasses);
+
+    // Chunk boundaries: every CODE_CHUNK_TREES trees and every stage end
+    std::vector<uint32_t> ends;
+    uint32_t stage = 0;
+    for (uint32_t t = 0; t < numTrees;) {
+        uint32_t end = std::min(t + CODE_CHUNK_TREES, numTrees);
+        if (stage < cascade.numStages && cascade.stages[stage].endTree <= end) {
+            end = cascade.stages[stage].endTree;
+            stage++;
+        }
+        ends.push_back(end);
+        t = end;
+    }
+
+    uint32_t first = 0;
+    for (size_t c = 0; c < ends.size(); c++) {
+        fprintf(f, "// Trees [%u, %u)\n", first, ends[c]);
+        fprintf(f, "XGB_CODE_ATTR static void xgbCodeChunk%zu(const float* x, float* m) {\n", c);
+        for (uint32_t t = first; t < ends[c]; t++) {
+            writeCodeNode(f, flat, flat.roots[t], flat.treeClass[t], 4);
+        }
+        fprintf(f, "}\n\n");
+        first = ends[c];
+    }
+
+    fprintf(f, "/**\n * Class probabilities from normalized features\n *\n");
+    fprintf(f, " * @return Number of trees evaluated\n */\n");
+    fprintf(f, "inline uint32_t xgbCodePredict(const float* features, float* probs) {\n");
+    fprintf(f, "    for (int c = 0; c < %d; c++) probs[c] = %s;\n", model.numClasses,
+            floatLiteral(model.baseScore).c_str());
+    stage = 0;
+    for (size_t c = 0; c < ends.size(); c++) {
+        fprintf(f, "    xgbCodeChunk%zu(features, probs);\n", c);
+        if (stage < cascade.numStages && cascade.stages[stage].endTree == ends[c]) {
+            float gap = cascade.stages[stage].minGap;
+            if (isfinite(gap)) {
+                fprintf(f, "    if (marginGap(probs, %d) >= %s) {\n", model.numClasses, floatLiteral(gap).c_str());
+                fprintf(f, "        softmax(probs, %d);\n        return %u;\n    }\n", model.numClasses, ends[c]);
+            }
+            stage++;
+        }
+    }
+    fprintf(f, "    softmax(probs, %d);\n    return %u;\n}\n\n", model.numClasses, numTrees);
+    fprintf(f, "#endif // XGBOOST_MODEL_CODE_H\n");
+    fclose(f);
+    return true;
+}
+
+static bool writeImage(const char* path, const SrcModel& model, const FlatModel& flat,
+                       const QuantModel* quant) {
+    ModelImageHeader h;
+    std::vector<uint8_t> image;
+    if (quant) {
+        QuantEnsemble m = {(uint16_t)model.numFeatures, (uint16_t)model.numClasses,
+                           (uint32_t)flat.roots.size(), model.baseScore, flat.roots.data(),
+                           flat.treeClass.data(), quant->nodes.data(), quant->leaves.data(),
+                           quant->cutOffsets.data(), quant->cuts.data()};
+        h = modelImageHeader(m, (uint32_t)quant->nodes.size(), (uint32_t)quant->leaves.size());
+        image.resize(sizeof(h) + h.payloadBytes);
+        writeModelImage(h, flat.cascade, m.treeRoots, m.treeClass, m.nodes, m.leaves, m.cutOffsets, m.cuts, image.data());
+    } else {
+        TreeEnsemble m = {(uint16_t)model.numFeatures, (uint16_t)model.numClasses,
+                          (uint32_t)flat.roots.size(), model.baseScore, flat.roots.data(),
+                          flat.treeClass.data(), flat.nodes.data()};
+        h = modelImageHeader(m, (uint32_t)flat.nodes.size());
+        image.resize(sizeof(h) + h.payloadBytes);
+        writeModelImage(h, flat.cascade, m.treeRoots, m.treeClass, m.nodes, nullptr, nullptr, nullptr, image.data());
+    }
+
+    // Read it back through the firmware's parser before shipping it
+    memcpy(&h, image.data(), sizeof(h));
+    ModelImage check;
+    ModelStatus status = parseModelImage(image.data(), image.size(), &check);
+    if (status != MODEL_OK) return fail(modelStatusName(status));
+
+    FILE* f = fopen(path, "wb");
+    if (!f) return fail("cannot open output file");
+    bool ok = fwrite(image.data(), 1, image.size(), f) == image.size();
+    fclose(f);
+    if (!ok) return fail("write failed");
+    printf("model image: %zu bytes, CRC %08x\n", image.size(), (unsigned)h.crc32);
+    return true;
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+static void usage() {
+    fprintf(stderr, "usage: xgb_convert <model.json> [-o out] [--quantized | --binary | --codegen] [--rounds n] [--classes n]\n"
+                    "       [--calibrate rows.csv [--stages 10,25,50] [--tolerance f]]\n");
+}
+
+int main(int argc, char** argv) {
+    const char* input = nullptr;
+    const char* output = nullptr;
+    bool quantized = false;
+    bool binary = false;
+    bool codegen = false;
+    int rounds = 0;
+    const char* calibration = nullptr;
+    const char* stages = "10,25,50";
+    double tolerance = 0.0;
+    int dumpClasses = 4;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-o") && i + 1 < argc) output = argv[++i];
+        else if (!strcmp(argv[i], "--quantized")) quantized = true;
+        else if (!strcmp(argv[i], "--binary")) binary = true;
+        else if (!strcmp(argv[i], "--codegen")) codegen = true;
+        else if (!strcmp(argv[i], "--rounds") && i + 1 < argc) rounds = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--calibrate") && i + 1 < argc) calibration = argv[++i];
+        else if (!strcmp(argv[i], "--stages") && i + 1 < argc) stages = argv[++i];
+        else if (!strcmp(argv[i], "--tolerance") && i + 1 < argc) tolerance = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--classes") && i + 1 < argc) dumpClasses = atoi(argv[++i]);
+        else if (argv[i][0] != '-' && !input) input = argv[i];
+        else { usage(); return 2; }
+    }
+    if (!input) { usage(); return 2; }
+    if (codegen && (quantized || binary)) { usage(); return 2; }
+    if (!output) {
+        if (codegen) output = "xgboost_model_code.h";
+        else if (binary) output = quantized ? "xgboost_model_quant.bin" : "xgboost_model.bin";
+        else output = quantized ? "xgboost_model_quant.h" : "xgboost_model.h";
+    }
+
+    std::string text;
+    if (!readFile(input, text)) {
+        fprintf(stderr, "error: cannot read %s\n", input);
+        return 1;
+    }
+    JsonValue root;
+    JsonParser parser(text);
+    if (!parser.parse(root)) {
+        fprintf(stderr, "error: invalid JSON near byte %zu\n", parser.position());
+        return 1;
+    }
+
+    SrcModel model;
+    bool ok = (root.type == JsonValue::ARRAY) ? loadDump(root, model, dumpClasses)
+                                              : loadSavedModel(root, model);
+    if (!ok) return 1;
+    if (model.numClasses > 255) {
+        fail("too many classes");
+        return 1;
+    }
+
+    if (rounds > 0 && (size_t)rounds * model.numClasses < model.trees.size()) {
+        model.trees.resize((size_t)rounds * model.numClasses);
+    }
+
+    FlatModel flat;
+    for (const SrcTree& tree : model.trees) {
+        if (!flattenTree(tree, flat)) return 1;
+    }
+    if (calibration && !calibrateCascade(model, flat, calibration, stages, tolerance)) return 1;
+
+    if (codegen) {
+        if (!writeCodeHeader(output, input, model, flat)) return 1;
+        printf("%s: %zu trees, %zu nodes as code -> %s\n", input, flat.roots.size(), flat.nodes.size(), output);
+        return 0;
+    }
+
+    if (binary) {
+        QuantModel quant;
+        if (quantized && !quantizeModel(model, flat, quant)) return 1;
+        if (!writeImage(output, model, flat, quantized ? &quant : nullptr)) return 1;
+        printf("%s: %zu trees -> %s\n", input, flat.roots.size(), output);
+        return 0;
+    }
+
+    if (quantized) {
+        QuantModel quant;
+        if (!quantizeModel(model, flat, quant)) return 1;
+        if (!writeQuantHeader(output, input, model, flat, quant)) return 1;
+        printf("%s: %zu trees, %zu nodes, %zu leaves, %zu split points -> %s\n", input, flat.roots.size(),
+               quant.nodes.size(), quant.leaves.size(), quant.cuts.size(), output);
+        return 0;
+    }
+
+    if (!writeHeader(output, input, model, flat)) return 1;
+    printf("%s: %zu trees, %zu nodes, %zu bytes, max depth %d -> %s\n", input, flat.roots.size(),
+           flat.nodes.size(), flat.nodes.size() * sizeof(TreeNode), flat.maxDepth, output);
+    return 0;
+}